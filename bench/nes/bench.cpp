@@ -0,0 +1,274 @@
+#include "bench.hpp"
+#include "stats.hpp"
+
+using std::ofstream;
+using std::ostream;
+using std::thread;
+using std::chrono::duration;
+
+#define BENCH_VERSION 1
+#define BENCH_REPETITIONS 5
+#define BENCH_MIN_TIME 0.1
+#define BENCH_MAX_ITERATIONS 1000000000000ull
+
+struct Benchmark {
+  string name;
+  BenchFunction function;
+};
+
+struct Measurement {
+  string name;
+  uint64_t iterations = 0;
+  vector<double> nanoseconds;
+  vector<double> instructions;
+  vector<double> cycles;
+  // host events per emulated instruction, or per operation when the
+  // benchmark declares no instructions
+  vector<double> events[PERF_EVENTS];
+  string skipped;
+};
+
+// opened once, the first time --perf needs them
+static PerfCounters* counters() {
+  static PerfCounters counters;
+  return &counters;
+}
+
+static vector<Benchmark>& registry() {
+  static vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+BenchRegistrar::BenchRegistrar(const char* name, BenchFunction function) {
+  registry().push_back({name, function});
+}
+
+// seconds one call takes from its last begin(), counters are only read
+// when given
+static double runOnce(const Benchmark& benchmark, BenchState& state,
+                      uint64_t* counts = nullptr) {
+  state.counters = counts ? counters() : nullptr;
+  benchmark.function(state);
+  duration<double> elapsed = steady_clock::now() - state.start;
+  if (counts) {
+    state.counters->stop(counts);
+  }
+  return elapsed.count();
+}
+
+static Measurement measure(const Benchmark& benchmark, uint32_t repetitions,
+                           double minTime, bool perf) {
+  Measurement measurement;
+  measurement.name = benchmark.name;
+
+  // grow the count until a run is long enough to time, then size it to
+  // the minimum time with some margin
+  uint64_t iterations = 1;
+  for (;;) {
+    BenchState state(iterations);
+    auto seconds = runOnce(benchmark, state);
+    if (!state.reason.empty()) {
+      measurement.skipped = state.reason;
+      return measurement;
+    }
+    if (seconds >= minTime || iterations >= BENCH_MAX_ITERATIONS) {
+      break;
+    }
+    auto factor = seconds > minTime / 100 ? 1.2 * minTime / seconds : 10.0;
+    iterations = std::min<uint64_t>(BENCH_MAX_ITERATIONS,
+                                    std::max(iterations + 1.0,
+                                             iterations * factor));
+  }
+
+  measurement.iterations = iterations;
+  for (uint32_t i = 0; i < repetitions; i++) {
+    BenchState state(iterations);
+    uint64_t counts[PERF_EVENTS];
+    auto seconds = runOnce(benchmark, state, perf ? counts : nullptr);
+    measurement.nanoseconds.push_back(seconds * 1e9 / iterations);
+    if (state.instructions > 0) {
+      measurement.instructions.push_back(state.instructions * iterations /
+                                         seconds);
+    }
+    if (state.cycles > 0) {
+      measurement.cycles.push_back(state.cycles * iterations / seconds);
+    }
+    for (size_t event = 0; perf && event < PERF_EVENTS; event++) {
+      if (counters()->available(PerfEvent(event))) {
+        auto ops = (state.instructions > 0 ? state.instructions : 1.0) *
+                   iterations;
+        measurement.events[event].push_back(counts[event] / ops);
+      }
+    }
+  }
+  return measurement;
+}
+
+// median of per second samples, "-" when the benchmark declared none
+static string rate(const vector<double>& samples) {
+  if (samples.empty()) {
+    return "-";
+  }
+  char text[32];
+  snprintf(text, sizeof(text), "%.4g", median(samples));
+  return text;
+}
+
+// median of a host counter per emulated instruction, "-" when unavailable
+static string counter(const vector<double>* events, PerfEvent event) {
+  return rate(events[size_t(event)]);
+}
+
+static void writeSamples(ostream& out, const char* key,
+                         const vector<double>& samples,
+                         const char* separator = ",\n      ") {
+  out << separator << "\"" << key << "\": [";
+  for (uint32_t i = 0; i < samples.size(); i++) {
+    out << (i ? ", " : "") << samples[i];
+  }
+  out << "]";
+}
+
+// {"version": 1, "context": {...}, "benchmarks": [{"name": ..., "iterations":
+// ..., "ns_per_op": [...], "instructions_per_second": [...],
+// "cycles_per_second": [...]}]} with one sample per repetition, rates only
+// when the benchmark declares them; skipped ones carry "skipped": reason.
+// With --perf, "perf": {"cycles": [...], "instructions": [...],
+// "branch_misses": [...], "l1d_misses": [...]} holds the available host
+// counters per emulated instruction.
+static void writeJson(ostream& out, const vector<Measurement>& measurements,
+                      uint32_t repetitions, double minTime) {
+  out << std::setprecision(10);
+  out << "{\n  \"version\": " << BENCH_VERSION << ",\n  \"context\": {\n"
+      << "    \"build\": \""
+#ifdef NDEBUG
+      << "release"
+#else
+      << "debug"
+#endif
+      << "\",\n    \"threads\": " << thread::hardware_concurrency()
+      << ",\n    \"repetitions\": " << repetitions
+      << ",\n    \"min_time\": " << minTime << "\n  },\n  \"benchmarks\": [";
+  for (uint32_t i = 0; i < measurements.size(); i++) {
+    auto& measurement = measurements[i];
+    out << (i ? ",\n" : "\n") << "    {\n      \"name\": \""
+        << measurement.name << "\"";
+    if (!measurement.skipped.empty()) {
+      out << ",\n      \"skipped\": \"" << measurement.skipped << "\"\n    }";
+      continue;
+    }
+    out << ",\n      \"iterations\": " << measurement.iterations;
+    writeSamples(out, "ns_per_op", measurement.nanoseconds);
+    if (!measurement.instructions.empty()) {
+      writeSamples(out, "instructions_per_second", measurement.instructions);
+    }
+    if (!measurement.cycles.empty()) {
+      writeSamples(out, "cycles_per_second", measurement.cycles);
+    }
+    auto first = true;
+    for (size_t event = 0; event < PERF_EVENTS; event++) {
+      auto& samples = measurement.events[event];
+      if (samples.empty()) {
+        continue;
+      }
+      if (first) {
+        out << ",\n      \"perf\": {";
+      }
+      writeSamples(out, PerfCounters::name(PerfEvent(event)), samples,
+                   first ? "\n        " : ",\n        ");
+      first = false;
+    }
+    out << (first ? "" : "\n      }") << "\n    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+// nes-bench [--filter text] [--repetitions n] [--min-time seconds]
+//           [--json path] [--perf]
+int main(int argc, char* argv[]) {
+  string filter;
+  string json;
+  uint32_t repetitions = BENCH_REPETITIONS;
+  double minTime = BENCH_MIN_TIME;
+  auto perf = false;
+  for (auto i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--perf") == 0) {
+      perf = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      break;
+    }
+    if (strcmp(argv[i], "--filter") == 0) {
+      filter = argv[i + 1];
+    } else if (strcmp(argv[i], "--repetitions") == 0) {
+      repetitions = std::max(1ul, strtoul(argv[i + 1], nullptr, 0));
+    } else if (strcmp(argv[i], "--min-time") == 0) {
+      minTime = strtod(argv[i + 1], nullptr);
+    } else if (strcmp(argv[i], "--json") == 0) {
+      json = argv[i + 1];
+    }
+    i++;
+  }
+  if (perf && !counters()->any()) {
+    fprintf(stderr, "Hardware counters unavailable (%s), running without\n",
+            counters()->error().c_str());
+    perf = false;
+  }
+
+  auto benchmarks = registry();
+  std::sort(benchmarks.begin(), benchmarks.end(),
+            [](const Benchmark& a, const Benchmark& b) {
+              return a.name < b.name;
+            });
+  vector<Measurement> measurements;
+  uint32_t skipped = 0;
+  printf("%-32s %12s %14s %14s", "benchmark", "ns/op", "instructions/s",
+         "cycles/s");
+  if (perf) {
+    printf(" %8s %6s %10s %10s", "cyc/ins", "ipc", "br-miss", "l1d-miss");
+  }
+  printf("\n");
+  for (auto& benchmark : benchmarks) {
+    if (benchmark.name.find(filter) == string::npos) {
+      continue;
+    }
+    measurements.push_back(measure(benchmark, repetitions, minTime, perf));
+    auto& measurement = measurements.back();
+    if (!measurement.skipped.empty()) {
+      printf("%-32s skipped: %s\n", measurement.name.c_str(),
+             measurement.skipped.c_str());
+      skipped++;
+      continue;
+    }
+    printf("%-32s %12.2f %14s %14s", measurement.name.c_str(),
+           median(measurement.nanoseconds),
+           rate(measurement.instructions).c_str(),
+           rate(measurement.cycles).c_str());
+    if (perf) {
+      auto& events = measurement.events;
+      auto cycles = median(events[size_t(PerfEvent::Cycles)]);
+      auto instructions = median(events[size_t(PerfEvent::Instructions)]);
+      printf(" %8s %6s %10s %10s", counter(events, PerfEvent::Cycles).c_str(),
+             instructions > 0 ? rate({instructions / cycles}).c_str() : "-",
+             counter(events, PerfEvent::BranchMisses).c_str(),
+             counter(events, PerfEvent::L1dMisses).c_str());
+    }
+    printf("\n");
+  }
+
+  if (!json.empty()) {
+    ofstream file(json);
+    writeJson(file, measurements, repetitions, minTime);
+    if (!file.good()) {
+      fprintf(stderr, "Cannot write %s\n", json.c_str());
+      return 1;
+    }
+  }
+  // a skipped benchmark measured nothing; say so, but missing optional data
+  // is not an error
+  if (skipped) {
+    fprintf(stderr, "%u benchmarks skipped\n", skipped);
+  }
+  return 0;
+}
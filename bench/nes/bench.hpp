@@ -0,0 +1,69 @@
+#pragma once
+
+#include "nes/pch.h"
+#include "perf.hpp"
+
+using std::function;
+using std::string;
+using std::vector;
+using std::chrono::steady_clock;
+
+// Minimal benchmark harness. A benchmark is a function looping
+// state.iterations() times over the operation it measures; the harness
+// grows the iteration count until one run lasts the minimum time, then
+// repeats the run and reports every repetition so comparisons can use
+// robust statistics. Work per iteration declared with setInstructions()
+// and setCycles() turns into instructions and cycles per second. With
+// --perf, hardware counters run from begin() to the end of the run.
+class BenchState {
+  BenchState(const BenchState&) = delete;
+  BenchState& operator=(const BenchState&) = delete;
+
+ public:
+  BenchState(uint64_t aiterations) : iterations_(aiterations) {}
+  ~BenchState() = default;
+
+  uint64_t iterations() const { return iterations_; }
+  // restarts the clock, call it once setup is done
+  void begin() {
+    if (counters) {
+      counters->start();
+    }
+    start = steady_clock::now();
+  }
+  void setInstructions(double perIteration) { instructions = perIteration; }
+  void setCycles(double perIteration) { cycles = perIteration; }
+  void skip(const string& why) { reason = why; }
+
+  steady_clock::time_point start = steady_clock::now();
+  double instructions = 0.0;
+  double cycles = 0.0;
+  string reason;
+  PerfCounters* counters = nullptr;
+
+ private:
+  uint64_t iterations_;
+};
+
+using BenchFunction = function<void(BenchState&)>;
+
+struct BenchRegistrar {
+  BenchRegistrar(const char* name, BenchFunction function);
+};
+
+#define BENCH_CONCAT(a, b) a##b
+#define BENCH_NAME(a, b) BENCH_CONCAT(a, b)
+// variadic so lambdas may hold unparenthesized commas
+#define BENCHMARK(name, ...) \
+  static BenchRegistrar BENCH_NAME(registrar, __LINE__)(name, __VA_ARGS__)
+
+// keeps the compiler from discarding a value nobody reads
+template <typename T>
+inline void keep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile T sink;
+  sink = value;
+#endif
+}
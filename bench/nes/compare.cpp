@@ -0,0 +1,214 @@
+#include "nes/json.hpp"
+#include "stats.hpp"
+
+using std::ifstream;
+using std::istreambuf_iterator;
+using std::map;
+using std::string;
+using std::vector;
+
+#define COMPARE_THRESHOLD 0.05
+// scales a MAD to the standard deviation of normally distributed samples
+#define MAD_TO_SIGMA 1.4826
+// standard error of a median relative to the one of a mean, sqrt(pi / 2)
+#define MEDIAN_EFFICIENCY 1.2533
+#define Z_95 1.96
+
+// Throughput samples of one benchmark, higher is better: instructions per
+// second when the benchmark declares instructions, operations per second
+// otherwise.
+struct Samples {
+  string metric;
+  vector<double> values;
+  string skipped;
+};
+
+static double mad(const vector<double>& values) {
+  auto center = median(values);
+  vector<double> deviations;
+  for (auto value : values) {
+    deviations.push_back(fabs(value - center));
+  }
+  return median(deviations);
+}
+
+// standard error of the median, estimated robustly from the MAD
+static double medianError(const vector<double>& values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  return MEDIAN_EFFICIENCY * MAD_TO_SIGMA * mad(values) /
+         sqrt(double(values.size()));
+}
+
+static void readSamples(JsonReader& reader, vector<double>& values) {
+  reader.beginArray();
+  while (reader.nextItem()) {
+    double value = 0.0;
+    reader.readNumber(value);
+    values.push_back(value);
+  }
+}
+
+static bool parseBenchmark(JsonReader& reader, map<string, Samples>& result) {
+  string name;
+  string key;
+  string skipped;
+  vector<double> nanoseconds;
+  vector<double> instructions;
+  reader.beginObject();
+  while (reader.nextKey(key)) {
+    if (key == "name") {
+      reader.readString(name);
+    } else if (key == "skipped") {
+      reader.readString(skipped);
+    } else if (key == "ns_per_op") {
+      readSamples(reader, nanoseconds);
+    } else if (key == "instructions_per_second") {
+      readSamples(reader, instructions);
+    } else {
+      reader.skip();
+    }
+  }
+  auto& samples = result[name];
+  samples.skipped = skipped;
+  if (!instructions.empty()) {
+    samples.metric = "instructions/s";
+    samples.values = instructions;
+  } else {
+    samples.metric = "ops/s";
+    for (auto value : nanoseconds) {
+      samples.values.push_back(value > 0 ? 1e9 / value : 0.0);
+    }
+  }
+  return !reader.failed();
+}
+
+// the build type of a report, from its context
+static void parseContext(JsonReader& reader, string& build) {
+  string key;
+  reader.beginObject();
+  while (reader.nextKey(key)) {
+    if (key == "build") {
+      reader.readString(build);
+    } else {
+      reader.skip();
+    }
+  }
+}
+
+// reads a nes-bench --json report
+static bool load(const string& path, map<string, Samples>& result,
+                 string& build) {
+  ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  string text((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+  JsonReader reader(text.data(), text.size());
+  string key;
+  reader.beginObject();
+  while (reader.nextKey(key)) {
+    if (key == "context") {
+      parseContext(reader, build);
+      continue;
+    }
+    if (key != "benchmarks") {
+      reader.skip();
+      continue;
+    }
+    reader.beginArray();
+    while (reader.nextItem()) {
+      parseBenchmark(reader, result);
+    }
+  }
+  return !reader.failed() && reader.atEnd();
+}
+
+// nes-bench-compare baseline.json candidate.json [--threshold fraction]
+//                   [--filter text]
+// compares the median throughput of every benchmark in both reports with a
+// 95% confidence interval on the change; a benchmark regresses when it
+// drops by more than the threshold and the whole interval is below zero.
+// A baseline benchmark the candidate lacks or skipped fails as well, and
+// reports of different build types are not compared at all.
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: %s baseline.json candidate.json [--threshold fraction] "
+            "[--filter text]\n",
+            argv[0]);
+    return 2;
+  }
+  auto threshold = COMPARE_THRESHOLD;
+  string filter;
+  for (auto i = 3; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--threshold") == 0) {
+      threshold = strtod(argv[i + 1], nullptr);
+    } else if (strcmp(argv[i], "--filter") == 0) {
+      filter = argv[i + 1];
+    }
+  }
+
+  map<string, Samples> baseline;
+  map<string, Samples> candidate;
+  string builds[2];
+  const char* paths[2] = {argv[1], argv[2]};
+  map<string, Samples>* results[2] = {&baseline, &candidate};
+  for (auto i = 0; i < 2; i++) {
+    if (!load(paths[i], *results[i], builds[i])) {
+      fprintf(stderr, "Cannot read benchmark report %s\n", paths[i]);
+      return 2;
+    }
+  }
+  if (builds[0] != builds[1]) {
+    fprintf(stderr, "Cannot compare a %s baseline with a %s candidate\n",
+            builds[0].empty() ? "unknown" : builds[0].c_str(),
+            builds[1].empty() ? "unknown" : builds[1].c_str());
+    return 2;
+  }
+
+  printf("%-32s %15s %11s %11s %6s %7s %17s\n", "benchmark", "metric",
+         "baseline", "candidate", "mad", "change", "95% interval");
+  uint32_t regressions = 0;
+  uint32_t lost = 0;
+  for (auto& [name, before] : baseline) {
+    if (name.find(filter) == string::npos) {
+      continue;
+    }
+    auto found = candidate.find(name);
+    if (found == candidate.end()) {
+      printf("%-32s MISSING from the candidate\n", name.c_str());
+      lost++;
+      continue;
+    }
+    auto& after = found->second;
+    if (before.skipped.empty() && !after.skipped.empty()) {
+      printf("%-32s SKIPPED by the candidate: %s\n", name.c_str(),
+             after.skipped.c_str());
+      lost++;
+      continue;
+    }
+    if (!before.skipped.empty() || before.metric != after.metric ||
+        before.values.empty() || after.values.empty()) {
+      printf("%-32s skipped\n", name.c_str());
+      continue;
+    }
+    auto base = median(before.values);
+    auto change = (median(after.values) - base) / base;
+    auto margin = Z_95 * hypot(medianError(before.values),
+                               medianError(after.values)) / base;
+    // the noisier of the two runs, relative to the baseline
+    auto noise = std::max(mad(before.values), mad(after.values)) / base;
+    auto regressed = change < -threshold && change + margin < 0;
+    regressions += regressed;
+    printf("%-32s %15s %11.4g %11.4g %5.1f%% %+6.1f%% "
+           "[%+6.1f%%, %+6.1f%%]%s\n",
+           name.c_str(), before.metric.c_str(), base, median(after.values),
+           noise * 100, change * 100, (change - margin) * 100,
+           (change + margin) * 100, regressed ? "  REGRESSION" : "");
+  }
+  printf("%u regression%s beyond %.1f%%, %u missing or skipped\n",
+         regressions, regressions == 1 ? "" : "s", threshold * 100, lost);
+  return regressions || lost ? 1 : 0;
+}
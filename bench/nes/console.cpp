@@ -0,0 +1,26 @@
+#include "bench.hpp"
+#include "nes/console.hpp"
+#include "snake/snake.hpp"
+
+#define SNAKE_CYCLES_PER_FRAME 400
+#define SNAKE_FRAMES 60
+
+// Saves the whole state of a console that has played snake for a while
+// into a preallocated buffer and loads it back, once per iteration; the
+// target is under 50 us for the pair.
+BENCHMARK("console/save_load", [](BenchState& state) {
+  Console console;
+  console.loadProgram(SNAKE_PROGRAM_ADDR, SNAKE_PROGRAM,
+                      sizeof(SNAKE_PROGRAM));
+  console.reset();
+  console.cyclesPerFrame = SNAKE_CYCLES_PER_FRAME;
+  for (auto i = 0; i < SNAKE_FRAMES; i++) {
+    console.frame();
+  }
+  vector<uint8_t> buffer(console.stateSize());
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    auto size = console.saveState(buffer.data());
+    keep(console.loadState(buffer.data(), size));
+  }
+});
@@ -0,0 +1,123 @@
+#include "bench.hpp"
+#include "nes/assembler.hpp"
+#include "nes/console.hpp"
+
+using std::mt19937;
+
+#define BLOCK_REPEAT 256
+#define RANDOM_TABLE 0x0400
+#define RANDOM_SEED 6502
+
+// Runs one instruction per iteration from a block of copies of the same
+// statement that jumps back to its start, so every opcode class is timed
+// on its own. "sub" is a subroutine that returns at once. With random, the
+// page at "table" holds bytes from a fixed seed, so statements indexing it
+// by X see operands whose flags no branch predictor can learn.
+static void instructions(BenchState& state, const string& statement,
+                         bool random = false) {
+  char table[32];
+  snprintf(table, sizeof(table), "table = $%04x\nblock:\n", RANDOM_TABLE);
+  string source = table;
+  for (uint32_t i = 0; i < BLOCK_REPEAT; i++) {
+    source += "  " + statement + "\n";
+  }
+  source += "  jmp block\nsub:\n  rts\n";
+  Assembler assembler;
+  if (!assembler.assemble(source)) {
+    state.skip(assembler.getError());
+    return;
+  }
+  Console console;
+  auto& code = assembler.getCode();
+  console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+  if (random) {
+    mt19937 generator(RANDOM_SEED);
+    for (uint32_t i = 0; i < 0x100; i++) {
+      console.memory->write8(RANDOM_TABLE + i, generator());
+    }
+  }
+  console.reset();
+  auto& cpu = *console.cpu;
+
+  state.begin();
+  uint64_t cycles = 0;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    cpu.cycles = 0;
+    cpu.step();
+    cycles += cpu.cycles;
+  }
+  state.setInstructions(1);
+  state.setCycles(double(cycles) / state.iterations());
+}
+
+BENCHMARK("cpu/step/load", [](BenchState& state) {
+  instructions(state, "lda #$01");
+});
+BENCHMARK("cpu/step/alu", [](BenchState& state) {
+  instructions(state, "adc $10");
+});
+// One random operand per instruction, the INX that moves on to the next
+// one timed as well. The shifts load theirs into A first, as shifting the
+// table in place would zero it, and ROL and ROR take a random carry in.
+BENCHMARK("cpu/step/random/adc", [](BenchState& state) {
+  instructions(state, "adc table,x\n  inx", true);
+});
+BENCHMARK("cpu/step/random/sbc", [](BenchState& state) {
+  instructions(state, "sbc table,x\n  inx", true);
+});
+BENCHMARK("cpu/step/random/cmp", [](BenchState& state) {
+  instructions(state, "cmp table,x\n  inx", true);
+});
+BENCHMARK("cpu/step/random/asl", [](BenchState& state) {
+  instructions(state, "lda table,x\n  asl a\n  inx", true);
+});
+BENCHMARK("cpu/step/random/lsr", [](BenchState& state) {
+  instructions(state, "lda table,x\n  lsr a\n  inx", true);
+});
+BENCHMARK("cpu/step/random/rol", [](BenchState& state) {
+  instructions(state, "lda table,x\n  rol a\n  inx", true);
+});
+BENCHMARK("cpu/step/random/ror", [](BenchState& state) {
+  instructions(state, "lda table,x\n  ror a\n  inx", true);
+});
+BENCHMARK("cpu/step/store", [](BenchState& state) {
+  instructions(state, "sta $0300,x");
+});
+BENCHMARK("cpu/step/rmw", [](BenchState& state) {
+  instructions(state, "inc $10");
+});
+// always taken as Z starts clear
+BENCHMARK("cpu/step/branch", [](BenchState& state) {
+  instructions(state, "bne *+2");
+});
+BENCHMARK("cpu/step/stack", [](BenchState& state) {
+  instructions(state, "pha\n  pla");
+});
+// the RTS is timed as well
+BENCHMARK("cpu/step/call", [](BenchState& state) {
+  instructions(state, "jsr sub");
+});
+
+// the same through clock(), one call per cycle
+BENCHMARK("cpu/clock", [](BenchState& state) {
+  Assembler assembler;
+  assembler.assemble(
+      "loop:\n"
+      "  lda #$01\n"
+      "  adc $10\n"
+      "  sta $0300,x\n"
+      "  inx\n"
+      "  jmp loop\n");
+  Console console;
+  auto& code = assembler.getCode();
+  console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+  console.reset();
+  auto& cpu = *console.cpu;
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    cpu.clock();
+  }
+  state.setCycles(1);
+  // 2 + 3 + 5 + 2 + 3 cycles for five instructions
+  state.setInstructions(5.0 / 15.0);
+});
@@ -0,0 +1,21 @@
+#include "bench.hpp"
+#include "nes/disassembler.hpp"
+
+#define PRG_BANK_SIZE 0x8000
+
+// lists a 32 KB PRG bank of random bytes at $8000 per iteration
+BENCHMARK("disassembler/prg32k", [](BenchState& state) {
+  std::mt19937 random(6502);
+  vector<uint8_t> bank(PRG_BANK_SIZE);
+  for (auto& byte : bank) {
+    byte = random();
+  }
+  vector<char> text(PRG_BANK_SIZE * DISASSEMBLER_LINE + 1);
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    uint32_t written;
+    keep(Disassembler::range(0x8000, bank.data(), bank.size(), text.data(),
+                             text.size(), written));
+    keep(written);
+  }
+});
@@ -0,0 +1,61 @@
+#include "bench.hpp"
+#include "nes/memory.hpp"
+#include "nes/memorybus.hpp"
+
+using std::make_shared;
+
+// addresses walk RAM with a stride so accesses spread over every page
+#define STRIDE 0x0107
+
+static void read8(BenchState& state) {
+  Memory memory(0x0000, 0xffff);
+  uint8_t sum = 0;
+  uint16_t addr = 0;
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    sum += memory.read8(addr);
+    addr += STRIDE;
+  }
+  keep(sum);
+}
+BENCHMARK("memory/read8", read8);
+
+static void write8(BenchState& state) {
+  Memory memory(0x0000, 0xffff);
+  uint16_t addr = 0;
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    memory.write8(addr, i);
+    addr += STRIDE;
+  }
+  keep(memory.read8(0));
+}
+BENCHMARK("memory/write8", write8);
+
+static void busRead8(BenchState& state) {
+  MemoryBus bus;
+  bus.connect(make_shared<Memory>(0x0000, 0xffff));
+  uint8_t sum = 0;
+  uint16_t addr = 0;
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    sum += bus.read8(addr);
+    addr += STRIDE;
+  }
+  keep(sum);
+}
+BENCHMARK("bus/read8", busRead8);
+
+static void busRead16(BenchState& state) {
+  MemoryBus bus;
+  bus.connect(make_shared<Memory>(0x0000, 0xffff));
+  uint16_t sum = 0;
+  uint16_t addr = 0;
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    sum += bus.read16(addr);
+    addr += STRIDE;
+  }
+  keep(sum);
+}
+BENCHMARK("bus/read16", busRead16);
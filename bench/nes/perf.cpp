@@ -0,0 +1,120 @@
+#include "perf.hpp"
+
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+static int openEvent(PerfEvent event, int group) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  switch (event) {
+    case PerfEvent::Cycles:
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case PerfEvent::Instructions:
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case PerfEvent::BranchMisses:
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+    default:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+  attr.disabled = group < 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+#endif
+
+PerfCounters::PerfCounters() {
+  for (size_t i = 0; i < PERF_EVENTS; i++) {
+    fds[i] = -1;
+    ids[i] = ~0ull;
+  }
+#ifdef __linux__
+  for (size_t i = 0; i < PERF_EVENTS; i++) {
+    fds[i] = openEvent(PerfEvent(i), leader);
+    if (fds[i] >= 0) {
+      ioctl(fds[i], PERF_EVENT_IOC_ID, &ids[i]);
+    }
+    if (leader < 0) {
+      if (fds[i] < 0) {
+        // without cycles nothing else is worth counting
+        reason = string("perf_event_open: ") + strerror(errno);
+        return;
+      }
+      leader = fds[i];
+    }
+  }
+#else
+  reason = "perf_event_open is Linux only";
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (auto fd : fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+const char* PerfCounters::name(PerfEvent event) {
+  switch (event) {
+    case PerfEvent::Cycles:
+      return "cycles";
+    case PerfEvent::Instructions:
+      return "instructions";
+    case PerfEvent::BranchMisses:
+      return "branch_misses";
+    default:
+      return "l1d_misses";
+  }
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+  if (leader >= 0) {
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+void PerfCounters::stop(uint64_t values[PERF_EVENTS]) {
+  for (size_t i = 0; i < PERF_EVENTS; i++) {
+    values[i] = 0;
+  }
+#ifdef __linux__
+  if (leader < 0) {
+    return;
+  }
+  ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  // {count, {value, id} x count}
+  uint64_t data[1 + 2 * PERF_EVENTS];
+  if (read(leader, data, sizeof(data)) < ssize_t(sizeof(uint64_t))) {
+    return;
+  }
+  for (uint64_t j = 0; j < data[0] && j < PERF_EVENTS; j++) {
+    for (size_t i = 0; i < PERF_EVENTS; i++) {
+      if (fds[i] >= 0 && ids[i] == data[2 + 2 * j]) {
+        values[i] = data[1 + 2 * j];
+      }
+    }
+  }
+#endif
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "nes/pch.h"
+
+using std::string;
+
+enum class PerfEvent {
+  Cycles,
+  Instructions,
+  BranchMisses,
+  L1dMisses,
+  Count
+};
+
+#define PERF_EVENTS size_t(PerfEvent::Count)
+
+// Hardware counters of the calling thread through Linux perf_event_open,
+// opened as one group so they cover the same instructions. Events the
+// kernel, the CPU or a container refuses are left out: available() tells
+// which ones count, and on other systems none do.
+class PerfCounters {
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+ public:
+  PerfCounters();
+  ~PerfCounters();
+
+  static const char* name(PerfEvent event);
+  bool available(PerfEvent event) const { return fds[size_t(event)] >= 0; }
+  bool any() const { return leader >= 0; }
+  // why the first event could not be opened, empty when it could
+  const string& error() const { return reason; }
+
+  // zeroes and enables the counters
+  void start();
+  // disables the counters and reads them into values
+  void stop(uint64_t values[PERF_EVENTS]);
+
+ private:
+  int fds[PERF_EVENTS];
+  uint64_t ids[PERF_EVENTS];
+  int leader = -1;
+  string reason;
+};
@@ -0,0 +1,101 @@
+#include "bench.hpp"
+#include "nes/console.hpp"
+#include "nes/goldenlog.hpp"
+#include "snake/snake.hpp"
+
+using std::mt19937;
+
+#define SNAKE_CYCLES_PER_FRAME 400
+#define SNAKE_FRAMES 600
+#define SNAKE_RANDOM_ADDR 0x00fe
+#define SNAKE_BUTTON_ADDR 0x00ff
+
+// counts what a run executes, used once before timing the plain run
+struct Counter : NoHooks {
+  void instruction(uint16_t, uint8_t, uint32_t) {
+    instructions++;
+  }
+  uint64_t instructions = 0;
+};
+
+// One iteration plays SNAKE_FRAMES frames of snake from a fork of the same
+// start, steering with a fixed pseudo-random input sequence.
+static void snake(BenchState& state, Backend backend) {
+  Console start;
+  start.loadProgram(SNAKE_PROGRAM_ADDR, SNAKE_PROGRAM, sizeof(SNAKE_PROGRAM));
+  start.reset();
+  start.cyclesPerFrame = SNAKE_CYCLES_PER_FRAME;
+  start.cpu->setBackend(backend);
+  const uint8_t keys[] = {0x77, 0x64, 0x73, 0x61};
+
+  auto play = [&](Console& console, Counter* counter) {
+    mt19937 random(6502);
+    for (uint32_t frame = 0; frame < SNAKE_FRAMES; frame++) {
+      if (frame % 16 == 0) {
+        console.memory->write8(SNAKE_BUTTON_ADDR, keys[random() % 4]);
+      }
+      console.memory->write8(SNAKE_RANDOM_ADDR, random());
+      if (counter) {
+        console.frame(*counter);
+      } else {
+        console.frame();
+      }
+    }
+  };
+
+  Counter counter;
+  auto counted = start.fork();
+  play(*counted, &counter);
+  state.setInstructions(counter.instructions);
+  state.setCycles(counted->cycles);
+
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    auto console = start.fork();
+    play(*console, nullptr);
+  }
+}
+
+BENCHMARK("program/snake/interpreter", [](BenchState& state) {
+  snake(state, Backend::Interpreter);
+});
+BENCHMARK("program/snake/recompiler", [](BenchState& state) {
+  snake(state, Backend::Recompiler);
+});
+
+// One iteration runs the official opcode section of nestest from $c000.
+// Without nestest.nes and nestest.log in tests/data it is skipped.
+static void nestest(BenchState& state, Backend backend) {
+  string dir = NESTEST_DIR;
+  Rom rom(dir + "/nestest.nes");
+  GoldenLog log;
+  Console start;
+  if (!rom.valid() || !start.loadCartridge(rom) ||
+      !log.load(dir + "/nestest.log")) {
+    state.skip("nestest.nes and nestest.log not found in " + dir);
+    return;
+  }
+  auto counted = start.fork();
+  GoldenLog::startNestest(*counted->cpu);
+  while (!log.done()) {
+    counted->cpu->step(log);
+  }
+  auto cycles = log.getCycle() - NESTEST_START_CYCLE;
+  state.setInstructions(log.getChecked());
+  state.setCycles(cycles);
+
+  state.begin();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    auto console = start.fork();
+    console->cpu->setBackend(backend);
+    GoldenLog::startNestest(*console->cpu);
+    console->cpu->run(cycles);
+  }
+}
+
+BENCHMARK("program/nestest/interpreter", [](BenchState& state) {
+  nestest(state, Backend::Interpreter);
+});
+BENCHMARK("program/nestest/recompiler", [](BenchState& state) {
+  nestest(state, Backend::Recompiler);
+});
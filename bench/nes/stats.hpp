@@ -0,0 +1,16 @@
+#pragma once
+
+#include "nes/pch.h"
+
+using std::vector;
+
+// shared by nes-bench and nes-bench-compare
+inline double median(vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  auto middle = values.size() / 2;
+  return values.size() % 2 ? values[middle]
+                           : (values[middle - 1] + values[middle]) / 2;
+}
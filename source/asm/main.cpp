@@ -0,0 +1,71 @@
+#include "nes/assembler.hpp"
+
+using std::ofstream;
+
+#define HEADER_BYTES_PER_LINE 12
+
+static bool endsWith(const string& text, const string& suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+// NAME[size] array and NAME_ADDR origin, laid out like clang-format would
+static void writeHeader(ofstream& out, const Assembler& assembler,
+                        const string& source, const string& name) {
+  auto& code = assembler.getCode();
+  auto file = source.substr(source.find_last_of("/\\") + 1);
+  char origin[8];
+  snprintf(origin, sizeof(origin), "0x%04x", assembler.getOrigin());
+  out << "#pragma once\n\n#include <stdint.h>\n\n// " << file
+      << " assembled for $" << origin + 2 << " by nes-asm, do not edit\n"
+      << "#define " << name << "_ADDR " << origin << "\n\n"
+      << "static const uint8_t " << name << "[" << code.size() << "] = {";
+  for (size_t i = 0; i < code.size(); i++) {
+    char byte[8];
+    snprintf(byte, sizeof(byte), "0x%02x", code[i]);
+    out << (i % HEADER_BYTES_PER_LINE ? " " : "\n    ") << byte
+        << (i + 1 < code.size() ? "," : "");
+  }
+  out << "};\n";
+}
+
+// nes-asm source.asm output [--origin address] [--name NAME]
+// assembles source.asm into a C header when output ends in .h or .hpp,
+// into a raw binary otherwise
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: %s source.asm output [--origin address] [--name NAME]\n",
+            argv[0]);
+    return 1;
+  }
+  uint16_t origin = ASSEMBLER_ORIGIN;
+  string name = "PROGRAM";
+  for (auto i = 3; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--origin") == 0) {
+      origin = strtoul(argv[i + 1], nullptr, 0);
+    } else if (strcmp(argv[i], "--name") == 0) {
+      name = argv[i + 1];
+    }
+  }
+
+  Assembler assembler(origin);
+  if (!assembler.assembleFile(argv[1])) {
+    fprintf(stderr, "%s: %s\n", argv[1], assembler.getError().c_str());
+    return 1;
+  }
+  string output = argv[2];
+  ofstream out(output, std::ios::binary);
+  if (endsWith(output, ".h") || endsWith(output, ".hpp")) {
+    writeHeader(out, assembler, argv[1], name);
+  } else {
+    auto& code = assembler.getCode();
+    out.write(reinterpret_cast<const char*>(code.data()), code.size());
+  }
+  if (!out.good()) {
+    fprintf(stderr, "Cannot write %s\n", output.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "nes/assembler.hpp"
+#include "nes/console.hpp"
+#include "nes/gdbstub.hpp"
+
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+#define GDB_DEFAULT_PORT 6502
+#define FRAME_MICROSECONDS 16639
+
+static bool endsWith(const string& text, const string& suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+// an iNES image, 6502 assembly or a raw binary loaded at origin
+static bool load(Console& console, const string& path, uint16_t origin) {
+  if (endsWith(path, ".asm")) {
+    Assembler assembler(origin);
+    if (!assembler.assembleFile(path)) {
+      fprintf(stderr, "%s: %s\n", path.c_str(),
+              assembler.getError().c_str());
+      return false;
+    }
+    auto& code = assembler.getCode();
+    console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+    return true;
+  }
+  Rom rom(path);
+  if (!rom.valid()) {
+    return false;
+  }
+  if (rom.isINes()) {
+    return console.loadCartridge(rom);
+  }
+  console.loadProgram(origin, rom.getData(), rom.getSize());
+  return true;
+}
+
+// nes-gdb program [--port port] [--unix path] [--origin address]
+// runs program at 60 frames per second with a GDB remote stub listening on
+// 127.0.0.1:port, or on a Unix socket; attach with target remote
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s program [--port port] [--unix path] [--origin "
+            "address]\n",
+            argv[0]);
+    return 1;
+  }
+  uint16_t port = GDB_DEFAULT_PORT;
+  uint16_t origin = ASSEMBLER_ORIGIN;
+  string path;
+  for (auto i = 2; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--port") == 0) {
+      port = strtoul(argv[i + 1], nullptr, 0);
+    } else if (strcmp(argv[i], "--unix") == 0) {
+      path = argv[i + 1];
+    } else if (strcmp(argv[i], "--origin") == 0) {
+      origin = strtoul(argv[i + 1], nullptr, 0);
+    }
+  }
+
+  Console console;
+  if (!load(console, argv[1], origin)) {
+    fprintf(stderr, "Cannot load %s\n", argv[1]);
+    return 1;
+  }
+  console.reset();
+  GdbStub stub(console.cpu, console.memory);
+  if (!(path.empty() ? stub.listenTcp(port) : stub.listenUnix(path))) {
+    fprintf(stderr, "Cannot listen: %s\n", stub.getError().c_str());
+    return 1;
+  }
+  if (path.empty()) {
+    fprintf(stderr, "Listening on 127.0.0.1:%u\n", stub.getPort());
+  } else {
+    fprintf(stderr, "Listening on %s\n", path.c_str());
+  }
+
+  auto next = steady_clock::now();
+  while (!stub.isKilled()) {
+    console.frame(stub);
+    next += microseconds(FRAME_MICROSECONDS);
+    // frames stopped for the debugger do not catch up afterwards
+    next = std::max(next, steady_clock::now());
+    std::this_thread::sleep_until(next);
+  }
+  return 0;
+}
@@ -0,0 +1,488 @@
+#include "assembler.hpp"
+
+using std::array;
+using std::ifstream;
+using std::istreambuf_iterator;
+using std::unordered_map;
+
+#define ADDRESSING_MODES (size_t(Addressing::Zpy) + 1)
+#define NOP_OPCODE 0xea
+
+using Modes = array<int16_t, ADDRESSING_MODES>;
+
+// opcode of every mnemonic and addressing mode the CPU decodes, -1 if none
+static const unordered_map<string, Modes>& opcodeModes() {
+  static const auto modes = [] {
+    unordered_map<string, Modes> result;
+    auto table = CPU::opcodeTable();
+    for (uint32_t opcode = 0; opcode < 0x100; opcode++) {
+      auto& info = table[opcode];
+      if (strcmp(info.mnemonic, "XXX") == 0) {
+        continue;
+      }
+      auto inserted = result.emplace(info.mnemonic, Modes());
+      if (inserted.second) {
+        inserted.first->second.fill(-1);
+      }
+      auto& opcodes = inserted.first->second;
+      auto mode = size_t(CPU::getAddressing(info));
+      if (opcodes[mode] < 0) {
+        opcodes[mode] = opcode;
+      }
+    }
+    // the table decodes unofficial implied NOPs before the official one
+    result["NOP"][size_t(Addressing::Imp)] = NOP_OPCODE;
+    return result;
+  }();
+  return modes;
+}
+
+static void skipSpaces(const char*& text) {
+  while (*text == ' ' || *text == '\t') {
+    text++;
+  }
+}
+
+static bool isNameStart(char c) { return isalpha(c) || c == '_'; }
+
+static string readName(const char*& text) {
+  string name;
+  while (isalnum(*text) || *text == '_') {
+    name += *text++;
+  }
+  return name;
+}
+
+static string toUpper(string text) {
+  for (auto& c : text) {
+    c = toupper(c);
+  }
+  return text;
+}
+
+// true when text holds the single letter register and nothing after it
+static bool isRegister(const char* text, char name) {
+  return tolower(text[0]) == name && !isalnum(text[1]) && text[1] != '_';
+}
+
+Assembler::Assembler(uint16_t aorigin) : origin(aorigin), start(aorigin) {}
+
+bool Assembler::assemble(const string& source) {
+  symbols.clear();
+  widths.clear();
+  error.clear();
+  return pass(source, false) && pass(source, true);
+}
+
+bool Assembler::assembleFile(const string& path) {
+  ifstream file(path);
+  if (!file.is_open()) {
+    line = 0;
+    return fail("cannot open " + path);
+  }
+  string source((istreambuf_iterator<char>(file)),
+                istreambuf_iterator<char>());
+  return assemble(source);
+}
+
+bool Assembler::getSymbol(const string& name, uint16_t& value) const {
+  auto found = symbols.find(name);
+  if (found == symbols.end()) {
+    return false;
+  }
+  value = found->second;
+  return true;
+}
+
+bool Assembler::fail(const string& message) {
+  if (error.empty()) {
+    error = line ? "line " + std::to_string(line) + ": " + message : message;
+  }
+  return false;
+}
+
+void Assembler::emit(uint8_t value) {
+  if (finalPass) {
+    code.push_back(value);
+  }
+  address++;
+}
+
+bool Assembler::pass(const string& source, bool afinal) {
+  finalPass = afinal;
+  origin = start;
+  address = origin;
+  instructions = 0;
+  code.clear();
+  line = 0;
+  size_t at = 0;
+  while (at < source.size()) {
+    auto end = source.find('\n', at);
+    if (end == string::npos) {
+      end = source.size();
+    }
+    auto text = source.substr(at, end - at);
+    at = end + 1;
+    line++;
+    // cut the comment, unless the ';' is quoted
+    char quote = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+      if (quote) {
+        quote = text[i] == quote ? 0 : quote;
+      } else if (text[i] == '"' || text[i] == '\'') {
+        quote = text[i];
+      } else if (text[i] == ';') {
+        text.resize(i);
+        break;
+      }
+    }
+    auto cursor = text.c_str();
+    if (!statement(cursor)) {
+      return false;
+    }
+    skipSpaces(cursor);
+    if (*cursor != '\0' && *cursor != '\r') {
+      return fail(string("unexpected ") + cursor);
+    }
+    if (address > 0x10000) {
+      return fail("program passes $ffff");
+    }
+  }
+  return true;
+}
+
+bool Assembler::statement(const char*& text) {
+  skipSpaces(text);
+  if (*text == '\0' || *text == '\r') {
+    return true;
+  }
+  if (*text == '*' || *text == '.') {
+    auto directive = *text == '*' ? string("*") : toUpper(readName(++text));
+    if (directive == "*") {
+      text++;
+      skipSpaces(text);
+      if (*text != '=') {
+        return fail("expected *=");
+      }
+      text++;
+      directive = "ORG";
+    }
+    if (directive == "BYTE" || directive == "DB") {
+      return data(text, 1);
+    }
+    if (directive == "WORD" || directive == "DW") {
+      return data(text, 2);
+    }
+    if (directive != "ORG") {
+      return fail("unknown directive ." + directive);
+    }
+    Operand target;
+    if (!expression(text, target)) {
+      return false;
+    }
+    if (!target.known) {
+      return fail(".org needs a defined address");
+    }
+    // before any code it moves the origin itself
+    if (address == origin) {
+      origin = address = target.value;
+    } else if (target.value < int32_t(address)) {
+      return fail(".org moves backwards");
+    }
+    while (address < uint32_t(target.value)) {
+      emit(0);
+    }
+    return true;
+  }
+  if (!isNameStart(*text)) {
+    return fail(string("unexpected ") + text);
+  }
+
+  auto name = readName(text);
+  skipSpaces(text);
+  if (*text == ':') {
+    text++;
+    if (!finalPass && symbols.count(name)) {
+      return fail("duplicate symbol " + name);
+    }
+    symbols[name] = address;
+    return statement(text);
+  }
+  if (*text == '=') {
+    return define(name, ++text);
+  }
+  auto keyword = toUpper(name);
+  if (keyword == "DEFINE") {
+    skipSpaces(text);
+    auto constant = readName(text);
+    if (constant.empty()) {
+      return fail("define needs a name");
+    }
+    return define(constant, text);
+  }
+  if (keyword == "DCB") {
+    return data(text, 1);
+  }
+  return instruction(keyword, text);
+}
+
+bool Assembler::define(const string& name, const char*& text) {
+  if (!finalPass && symbols.count(name)) {
+    return fail("duplicate symbol " + name);
+  }
+  Operand value;
+  if (!expression(text, value)) {
+    return false;
+  }
+  if (value.known) {
+    symbols[name] = value.value;
+  }
+  return true;
+}
+
+bool Assembler::data(const char*& text, uint32_t size) {
+  for (;;) {
+    skipSpaces(text);
+    if (*text == '"' && size == 1) {
+      for (text++; *text && *text != '"'; text++) {
+        emit(*text);
+      }
+      if (*text++ != '"') {
+        return fail("unterminated string");
+      }
+    } else {
+      Operand item;
+      if (!expression(text, item)) {
+        return false;
+      }
+      auto limit = size == 1 ? 0xff : 0xffff;
+      if (finalPass && (item.value < -(limit + 1) / 2 || item.value > limit)) {
+        return fail("value out of range");
+      }
+      emit(item.value);
+      if (size == 2) {
+        emit(item.value >> 8);
+      }
+    }
+    skipSpaces(text);
+    if (*text != ',') {
+      return true;
+    }
+    text++;
+  }
+}
+
+bool Assembler::term(const char*& text, Operand& operand) {
+  skipSpaces(text);
+  operand = Operand();
+  if (*text == '$' || *text == '%' || isdigit(*text)) {
+    auto base = *text == '$' ? 16 : *text == '%' ? 2 : 10;
+    auto digits = base == 10 ? text : text + 1;
+    char* end;
+    operand.value = strtol(digits, &end, base);
+    if (end == digits || *digits == '-' || *digits == '+') {
+      return fail(string("expected a number at ") + text);
+    }
+    // $0010 and %000000001 ask for an absolute address
+    operand.wide = (base == 16 && end - digits > 2) ||
+                   (base == 2 && end - digits > 8);
+    text = end;
+    return true;
+  }
+  if (*text == '\'' && text[1] && text[2] == '\'') {
+    operand.value = uint8_t(text[1]);
+    text += 3;
+    return true;
+  }
+  if (*text == '*') {
+    operand.value = address;
+    operand.wide = true;
+    text++;
+    return true;
+  }
+  if (!isNameStart(*text)) {
+    return fail(string("expected a value at ") + text);
+  }
+  auto name = readName(text);
+  auto found = symbols.find(name);
+  if (found != symbols.end()) {
+    operand.value = found->second;
+    return true;
+  }
+  if (finalPass) {
+    return fail("unknown symbol " + name);
+  }
+  operand.known = false;
+  operand.wide = true;
+  return true;
+}
+
+bool Assembler::expression(const char*& text, Operand& operand) {
+  skipSpaces(text);
+  char select = 0;
+  if (*text == '<' || *text == '>') {
+    select = *text++;
+  }
+  skipSpaces(text);
+  auto negate = *text == '-';
+  if (negate) {
+    text++;
+  }
+  if (!term(text, operand)) {
+    return false;
+  }
+  if (negate) {
+    operand.value = -operand.value;
+  }
+  for (;;) {
+    skipSpaces(text);
+    if (*text != '+' && *text != '-') {
+      break;
+    }
+    auto sign = *text++ == '-' ? -1 : 1;
+    Operand next;
+    if (!term(text, next)) {
+      return false;
+    }
+    operand.value += sign * next.value;
+    operand.known = operand.known && next.known;
+    operand.wide = operand.wide || next.wide;
+  }
+  if (select) {
+    operand.value = (select == '<' ? operand.value : operand.value >> 8) & 0xff;
+    operand.wide = false;
+  }
+  return true;
+}
+
+bool Assembler::instruction(const string& mnemonic, const char*& text) {
+  auto& table = opcodeModes();
+  auto found = table.find(mnemonic);
+  if (found == table.end()) {
+    return fail("unknown instruction " + mnemonic);
+  }
+  auto& opcodes = found->second;
+  auto has = [&](Addressing mode) { return opcodes[size_t(mode)] >= 0; };
+
+  skipSpaces(text);
+  auto mode = Addressing::Imp;
+  Operand operand;
+  if (*text == '\0' || *text == '\r') {
+    mode = has(Addressing::Imp) ? Addressing::Imp : Addressing::Acc;
+  } else if (isRegister(text, 'a') && has(Addressing::Acc)) {
+    mode = Addressing::Acc;
+    text++;
+  } else if (*text == '#') {
+    if (!expression(++text, operand)) {
+      return false;
+    }
+    mode = Addressing::Imm;
+  } else if (*text == '(') {
+    if (!expression(++text, operand)) {
+      return false;
+    }
+    skipSpaces(text);
+    if (*text == ',') {
+      text++;
+      skipSpaces(text);
+      if (!isRegister(text, 'x')) {
+        return fail("expected (zp,x)");
+      }
+      text++;
+      mode = Addressing::Indx;
+    }
+    skipSpaces(text);
+    if (*text++ != ')') {
+      return fail("expected )");
+    }
+    if (mode != Addressing::Indx) {
+      skipSpaces(text);
+      mode = Addressing::Ind;
+      if (*text == ',') {
+        text++;
+        skipSpaces(text);
+        if (!isRegister(text, 'y')) {
+          return fail("expected (zp),y");
+        }
+        text++;
+        mode = Addressing::Indy;
+      }
+    }
+  } else {
+    if (!expression(text, operand)) {
+      return false;
+    }
+    skipSpaces(text);
+    char index = 0;
+    if (*text == ',') {
+      text++;
+      skipSpaces(text);
+      if (!isRegister(text, 'x') && !isRegister(text, 'y')) {
+        return fail("expected ,x or ,y");
+      }
+      index = tolower(*text++);
+    }
+    if (has(Addressing::Rel) && !index) {
+      mode = Addressing::Rel;
+    } else {
+      // the second pass must keep the size the first one counted
+      bool wide;
+      if (finalPass) {
+        wide = widths[instructions++];
+      } else {
+        wide = operand.wide || !operand.known || operand.value > 0xff ||
+               operand.value < 0;
+        widths.push_back(wide);
+      }
+      auto zp = index == 'x'   ? Addressing::Zpx
+                : index == 'y' ? Addressing::Zpy
+                               : Addressing::Zp;
+      auto abs = index == 'x'   ? Addressing::Absx
+                 : index == 'y' ? Addressing::Absy
+                                : Addressing::Abs;
+      mode = !wide && has(zp) ? zp : abs;
+    }
+  }
+  if (!has(mode)) {
+    return fail("addressing mode not available for " + mnemonic);
+  }
+
+  emit(opcodes[size_t(mode)]);
+  auto value = operand.value;
+  switch (mode) {
+    case Addressing::Imp:
+    case Addressing::Acc:
+      break;
+    case Addressing::Imm:
+      if (finalPass && (value < -0x80 || value > 0xff)) {
+        return fail("value out of range");
+      }
+      emit(value);
+      break;
+    case Addressing::Rel: {
+      auto offset = value - int32_t(address + 1);
+      if (finalPass && (offset < -0x80 || offset > 0x7f)) {
+        return fail("branch out of range");
+      }
+      emit(offset);
+      break;
+    }
+    case Addressing::Zp:
+    case Addressing::Zpx:
+    case Addressing::Zpy:
+    case Addressing::Indx:
+    case Addressing::Indy:
+      if (finalPass && (value < 0 || value > 0xff)) {
+        return fail("zero page address out of range");
+      }
+      emit(value);
+      break;
+    default:
+      if (finalPass && (value < 0 || value > 0xffff)) {
+        return fail("address out of range");
+      }
+      emit(value);
+      emit(value >> 8);
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::map;
+using std::string;
+using std::vector;
+
+#define ASSEMBLER_ORIGIN 0x0600
+
+// Two-pass 6502 assembler for the easy6502 dialect snake.asm is written in.
+// One statement per line, comments start with ';':
+//   label:            defines a label at the current address
+//   lda #$10          every addressing mode: #imm, zp, zp,x, zp,y, abs,
+//                     abs,x, abs,y, (ind), (zp,x), (zp),y, A and implied
+//   define NAME $10   constant, as is NAME = $10
+//   .org $0700        moves the current address forward, *= $0700 also
+//   .byte 1, "ab"     bytes and strings, also dcb and .db
+//   .word label       little-endian words, also .dw
+// Operands are sums and differences of $hex, %binary, decimal, 'c', symbols
+// and * (the current address); <expr and >expr take the low and high byte.
+// Symbols known to fit in a byte pick the zero page modes, forward ones are
+// assumed to take two bytes so both passes agree on every size.
+class Assembler {
+  Assembler(const Assembler&) = delete;
+  Assembler& operator=(const Assembler&) = delete;
+
+ public:
+  Assembler(uint16_t aorigin = ASSEMBLER_ORIGIN);
+  ~Assembler() = default;
+
+  // false on the first error, which getError() describes with its line
+  bool assemble(const string& source);
+  bool assembleFile(const string& path);
+
+  const vector<uint8_t>& getCode() const { return code; }
+  uint16_t getOrigin() const { return origin; }
+  const string& getError() const { return error; }
+  // value of a label or constant once assembled
+  bool getSymbol(const string& name, uint16_t& value) const;
+  const map<string, uint16_t>& getSymbols() const { return symbols; }
+
+ private:
+  struct Operand {
+    int32_t value = 0;
+    bool known = true;
+    // a symbol not yet defined or a literal written with four hex digits
+    bool wide = false;
+  };
+
+  bool pass(const string& source, bool afinal);
+  bool statement(const char*& text);
+  bool instruction(const string& mnemonic, const char*& text);
+  bool data(const char*& text, uint32_t size);
+  bool expression(const char*& text, Operand& operand);
+  bool term(const char*& text, Operand& operand);
+  bool define(const string& name, const char*& text);
+  void emit(uint8_t value);
+  bool fail(const string& message);
+
+  // origin of the current pass, .org may move it from start
+  uint16_t origin;
+  uint16_t start;
+  uint32_t address = 0;
+  uint32_t line = 0;
+  bool finalPass = false;
+  // operand width the first pass chose, per instruction
+  vector<bool> widths;
+  uint32_t instructions = 0;
+  map<string, uint16_t> symbols;
+  vector<uint8_t> code;
+  string error;
+};
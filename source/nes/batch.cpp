@@ -0,0 +1,143 @@
+#include "batch.hpp"
+
+#include "movie.hpp"
+
+using std::lock_guard;
+using std::make_unique;
+using std::map;
+using std::pair;
+using std::unique_lock;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+BatchRunner::BatchRunner(uint32_t athreads, Backend abackend)
+    : threads(athreads) {
+  if (threads == 0) {
+    threads = std::max(1u, thread::hardware_concurrency());
+  }
+  ranges = make_unique<Range[]>(threads);
+  for (uint32_t i = 0; i < threads; i++) {
+    consoles.push_back(make_unique<Console>());
+    consoles.back()->cpu->setBackend(abackend);
+  }
+  for (uint32_t i = 1; i < threads; i++) {
+    pool.emplace_back(&BatchRunner::loop, this, i);
+  }
+}
+
+BatchRunner::~BatchRunner() {
+  {
+    lock_guard<mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (auto& worker : pool) {
+    worker.join();
+  }
+}
+
+vector<BatchResult> BatchRunner::run(const vector<BatchJob>& ajobs) {
+  vector<BatchResult> aresults(ajobs.size());
+  // one start state per ROM and address: the program loaded and the CPU
+  // reset, as every job begins
+  map<pair<const Rom*, uint16_t>, vector<uint8_t>> loaded;
+  states.assign(ajobs.size(), nullptr);
+  for (uint32_t i = 0; i < ajobs.size(); i++) {
+    auto& job = ajobs[i];
+    auto rom = job.rom && job.rom->valid() ? job.rom.get() : nullptr;
+    auto& state = loaded[{rom, rom ? job.address : 0}];
+    if (state.empty()) {
+      Console prototype;
+      if (rom) {
+        prototype.loadProgram(job.address, rom->getData(), rom->getSize());
+      }
+      prototype.reset();
+      prototype.saveState(state);
+    }
+    states[i] = &state;
+  }
+
+  for (uint32_t i = 0; i < threads; i++) {
+    ranges[i].next = ajobs.size() * i / threads;
+    ranges[i].end = ajobs.size() * (i + 1) / threads;
+  }
+
+  auto start = steady_clock::now();
+  {
+    lock_guard<mutex> guard(lock);
+    jobs = &ajobs;
+    results = &aresults;
+    busy = threads - 1;
+    generation++;
+  }
+  wake.notify_all();
+  work(0);
+  {
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [this] { return busy == 0; });
+    jobs = nullptr;
+    results = nullptr;
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+
+  uint64_t frames = 0;
+  for (auto& result : aresults) {
+    frames += result.frames;
+  }
+  fps = elapsed.count() > 0 ? frames / elapsed.count() : 0.0;
+  return aresults;
+}
+
+void BatchRunner::loop(uint32_t worker) {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      unique_lock<mutex> guard(lock);
+      wake.wait(guard, [&] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+    }
+    work(worker);
+    {
+      lock_guard<mutex> guard(lock);
+      busy--;
+    }
+    finished.notify_one();
+  }
+}
+
+void BatchRunner::work(uint32_t worker) {
+  auto& console = *consoles[worker];
+  for (uint32_t i = 0; i < threads; i++) {
+    // own range first, then the others in turn
+    auto& range = ranges[(worker + i) % threads];
+    while (true) {
+      auto job = range.next.fetch_add(1, std::memory_order_relaxed);
+      if (job >= range.end) {
+        break;
+      }
+      execute(console, *states[job], (*jobs)[job], (*results)[job]);
+    }
+  }
+}
+
+void BatchRunner::execute(Console& console, const vector<uint8_t>& state,
+                          const BatchJob& job, BatchResult& result) {
+  auto start = steady_clock::now();
+  console.loadState(state);
+  console.cyclesPerFrame = job.cyclesPerFrame;
+  for (uint32_t frame = 0; frame < job.frames; frame++) {
+    if (job.input) {
+      job.input(console, frame);
+    }
+    console.frame();
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+
+  result.frames = job.frames;
+  result.cycles = console.cycles;
+  result.hash = Movie::hashRam(console);
+  result.seconds = elapsed.count();
+}
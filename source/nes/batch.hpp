@@ -0,0 +1,81 @@
+#pragma once
+
+#include "console.hpp"
+#include "rom.hpp"
+
+using std::condition_variable;
+using std::function;
+using std::mutex;
+using std::shared_ptr;
+using std::thread;
+using std::unique_ptr;
+using std::vector;
+
+struct BatchJob {
+  shared_ptr<const Rom> rom;
+  uint16_t address = 0x0600;
+  uint32_t frames = 0;
+  uint32_t cyclesPerFrame = CPU_CYCLES_PER_FRAME;
+  // called before every frame to feed input, shared by all workers so it
+  // must not touch anything but the console it is given
+  function<void(Console&, uint32_t)> input = nullptr;
+};
+
+struct BatchResult {
+  uint32_t frames = 0;
+  uint64_t cycles = 0;
+  uint64_t hash = 0;
+  double seconds = 0.0;
+};
+
+// Runs independent jobs on a pool of workers, one per hardware thread, the
+// thread calling run() being the first. Jobs are split into a contiguous
+// range per worker; a worker that drains its range steals single jobs from
+// the others through their atomic cursors, so scheduling never takes a lock.
+// Every worker keeps one console, and with it one recompiler, for the life
+// of the runner. Every ROM is loaded once into a start state, which a job
+// loads into the console of its worker; the load only drops the
+// translations of the code bytes it changes, so jobs running the same ROM
+// keep reusing them.
+class BatchRunner {
+  BatchRunner(const BatchRunner&) = delete;
+  BatchRunner& operator=(const BatchRunner&) = delete;
+
+ public:
+  BatchRunner(uint32_t athreads = 0,
+              Backend abackend = Backend::Interpreter);
+  ~BatchRunner();
+
+  vector<BatchResult> run(const vector<BatchJob>& jobs);
+  uint32_t getThreads() const { return threads; }
+  // frames of the last run divided by its wall time
+  double framesPerSecond() const { return fps; }
+
+ private:
+  struct alignas(64) Range {
+    std::atomic<uint32_t> next{0};
+    uint32_t end = 0;
+  };
+
+  // pool threads wait here for the next run
+  void loop(uint32_t worker);
+  void work(uint32_t worker);
+  void execute(Console& console, const vector<uint8_t>& state,
+               const BatchJob& job, BatchResult& result);
+
+  uint32_t threads;
+  unique_ptr<Range[]> ranges;
+  vector<unique_ptr<Console>> consoles;
+  vector<thread> pool;
+  mutex lock;
+  condition_variable wake;
+  condition_variable finished;
+  uint64_t generation = 0;
+  uint32_t busy = 0;
+  bool stopping = false;
+  // the run in progress, the start state of every job
+  const vector<BatchJob>* jobs = nullptr;
+  vector<const vector<uint8_t>*> states;
+  vector<BatchResult>* results = nullptr;
+  double fps = 0.0;
+};
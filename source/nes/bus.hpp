@@ -2,6 +2,7 @@
 
 #include "device.hpp"
 
+using std::function;
 using std::shared_ptr;
 
 class Bus {
@@ -17,4 +18,15 @@ class Bus {
   virtual void write8(uint16_t addr, uint8_t value) = 0;
   virtual uint16_t read16(uint16_t addr) = 0;
   virtual void write16(uint16_t addr, uint16_t value) = 0;
+  // copies len bytes from addr on, wrapping at the end of the address
+  // space as reads do, without any of the side effects of reading them;
+  // for hooks looking at code the CPU reads itself
+  virtual void peek(uint16_t addr, uint8_t* data, uint32_t len) = 0;
+  // calls the watcher with the bytes written the next time anything writes
+  // to the 256 byte page: the CPU, hooks, a debugger or loading a state;
+  // the page is watched again by calling watchCode() again. For the
+  // recompiler, whose translations go stale when their code changes.
+  using CodeWatcher = function<void(uint16_t addr, uint32_t len)>;
+  virtual void setCodeWatcher(CodeWatcher watcher) = 0;
+  virtual void watchCode(uint8_t page) = 0;
 };
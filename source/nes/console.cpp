@@ -0,0 +1,238 @@
+#include "console.hpp"
+
+#include "endian.hpp"
+#include "hash.hpp"
+
+using std::make_shared;
+
+// Save state layout, every field little-endian:
+//   header  magic u32 "NESS", version u16, chunk count u16, total size u32
+//   chunk   tag u32, length u32, then length bytes of payload
+// Chunks:
+//   "CPU "  a, x, y, p, sp u8, pc u16, cycles u16
+//   "RAM "  the whole memory
+//   "SCHD"  frames u64, cycles u64
+// Unknown chunks are skipped, so devices added later only append chunks.
+#define STATE_HEADER_SIZE 12
+#define STATE_CHUNK_SIZE 8
+#define STATE_CPU_SIZE 9
+#define STATE_SCHEDULER_SIZE 16
+#define STATE_CHUNKS 3
+
+#define TAG(a, b, c, d) \
+  (uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24))
+
+static const uint32_t CPU_TAG = TAG('C', 'P', 'U', ' ');
+static const uint32_t RAM_TAG = TAG('R', 'A', 'M', ' ');
+static const uint32_t SCHEDULER_TAG = TAG('S', 'C', 'H', 'D');
+
+Console::Console(bool verbose)
+    : Console(make_shared<Memory>(0x0000, 0xffff), verbose) {}
+
+Console::Console(shared_ptr<Memory> amemory, bool verbose) : memory(amemory) {
+  bus = make_shared<MemoryBus>();
+  bus->connect(memory);
+  cpu = make_shared<CPU>(bus, verbose);
+}
+
+shared_ptr<Console> Console::fork() {
+  auto child = shared_ptr<Console>(new Console(memory->fork(), cpu->verbose));
+  CpuState state;
+  cpu->save(state);
+  child->cpu->load(state);
+  child->cpu->setBackend(cpu->getBackend());
+  child->cyclesPerFrame = cyclesPerFrame;
+  child->frames = frames;
+  child->cycles = cycles;
+  return child;
+}
+
+void Console::loadProgram(uint16_t addr, const uint8_t* data, uint32_t len) {
+  memory->set(addr, data, len);
+  memory->write16(RESET_PROC_ADDR, addr);
+}
+
+bool Console::loadCartridge(const Rom& rom) {
+  auto size = rom.getPrgSize();
+  if (!rom.isINes() || rom.getMapper() != 0 ||
+      (size != INES_PRG_BANK_SIZE && size != 2 * INES_PRG_BANK_SIZE)) {
+    return false;
+  }
+  memory->set(0x8000, rom.getPrg(), size);
+  if (size == INES_PRG_BANK_SIZE) {
+    memory->set(0xc000, rom.getPrg(), size);
+  }
+  if (cpu->recompiler) {
+    cpu->recompiler->flush();
+  }
+  return true;
+}
+
+void Console::reset() {
+  cpu->reset();
+  frames = 0;
+  cycles = 0;
+}
+
+// runs the CPU up to the end of the next frame; instructions overlapping the
+// frame boundary are paid back by the following frame
+uint32_t Console::frame() {
+  auto budget = frameBudget();
+  return endFrame(cpu->run(budget), budget);
+}
+
+uint32_t Console::frameBudget() const {
+  uint64_t target = (frames + 1) * cyclesPerFrame;
+  return target > cycles ? target - cycles : 0;
+}
+
+uint32_t Console::endFrame(uint32_t elapsed, uint32_t budget) {
+  cycles += elapsed;
+  if (elapsed >= budget) {
+    frames++;
+  }
+  return elapsed;
+}
+
+uint32_t Console::stateSize() const {
+  return STATE_HEADER_SIZE + STATE_CHUNKS * STATE_CHUNK_SIZE + STATE_CPU_SIZE +
+         memory->getSize() + STATE_SCHEDULER_SIZE;
+}
+
+uint32_t Console::stateRamOffset() const {
+  return STATE_HEADER_SIZE + 2 * STATE_CHUNK_SIZE + STATE_CPU_SIZE;
+}
+
+uint32_t Console::saveState(uint8_t* buffer) const {
+  return saveState(buffer, 0);
+}
+
+uint32_t Console::saveState(uint8_t* buffer, uint32_t since) const {
+  auto size = stateSize();
+  auto ptr = putLE(buffer, STATE_MAGIC, 4);
+  ptr = putLE(ptr, STATE_VERSION, 2);
+  ptr = putLE(ptr, STATE_CHUNKS, 2);
+  ptr = putLE(ptr, size, 4);
+
+  ptr = putLE(ptr, CPU_TAG, 4);
+  ptr = putLE(ptr, STATE_CPU_SIZE, 4);
+  ptr = putLE(ptr, cpu->a, 1);
+  ptr = putLE(ptr, cpu->x, 1);
+  ptr = putLE(ptr, cpu->y, 1);
+  ptr = putLE(ptr, cpu->getStatus(), 1);
+  ptr = putLE(ptr, cpu->sp, 1);
+  ptr = putLE(ptr, cpu->pc, 2);
+  ptr = putLE(ptr, cpu->cycles, 2);
+
+  ptr = putLE(ptr, RAM_TAG, 4);
+  ptr = putLE(ptr, memory->getSize(), 4);
+  for (uint32_t page = 0; page < memory->getPages(); page++) {
+    if (since == 0 || memory->dirty(page, since)) {
+      auto len = std::min(memory->getSize() - (page << 8), 0x100u);
+      memory->get(page << 8, ptr + (page << 8), len);
+    }
+  }
+  ptr += memory->getSize();
+
+  ptr = putLE(ptr, SCHEDULER_TAG, 4);
+  ptr = putLE(ptr, STATE_SCHEDULER_SIZE, 4);
+  ptr = putLE(ptr, frames, 8);
+  ptr = putLE(ptr, cycles, 8);
+
+  assert(uint32_t(ptr - buffer) == size);
+  return size;
+}
+
+void Console::saveState(vector<uint8_t>& state) const {
+  state.resize(stateSize());
+  saveState(state.data());
+}
+
+bool Console::loadState(const uint8_t* buffer, uint32_t size) {
+  if (size < STATE_HEADER_SIZE || getLE(buffer, 4) != STATE_MAGIC ||
+      getLE(buffer + 4, 2) != STATE_VERSION || getLE(buffer + 8, 4) != size) {
+    return false;
+  }
+
+  // validate every chunk before touching the console so a truncated or
+  // foreign state leaves it as it was
+  auto chunks = getLE(buffer + 6, 2);
+  const uint8_t* cpuChunk = nullptr;
+  const uint8_t* ramChunk = nullptr;
+  const uint8_t* schedulerChunk = nullptr;
+  uint32_t offset = STATE_HEADER_SIZE;
+  for (uint32_t i = 0; i < chunks; i++) {
+    if (size - offset < STATE_CHUNK_SIZE) {
+      return false;
+    }
+    auto tag = getLE(buffer + offset, 4);
+    auto length = getLE(buffer + offset + 4, 4);
+    offset += STATE_CHUNK_SIZE;
+    if (size - offset < length) {
+      return false;
+    }
+    if (tag == CPU_TAG && length == STATE_CPU_SIZE) {
+      cpuChunk = buffer + offset;
+    } else if (tag == RAM_TAG && length == memory->getSize()) {
+      ramChunk = buffer + offset;
+    } else if (tag == SCHEDULER_TAG && length == STATE_SCHEDULER_SIZE) {
+      schedulerChunk = buffer + offset;
+    } else if (tag == CPU_TAG || tag == RAM_TAG || tag == SCHEDULER_TAG) {
+      return false;
+    }
+    offset += length;
+  }
+  if (offset != size || !cpuChunk || !ramChunk || !schedulerChunk) {
+    return false;
+  }
+
+  cpu->a = cpuChunk[0];
+  cpu->x = cpuChunk[1];
+  cpu->y = cpuChunk[2];
+  cpu->setStatus(cpuChunk[3]);
+  cpu->sp = cpuChunk[4];
+  cpu->pc = getLE(cpuChunk + 5, 2);
+  cpu->cycles = getLE(cpuChunk + 7, 2);
+  // translations survive the load unless it changes the code they came
+  // from, set() only reports the code bytes that differ
+  memory->set(0x0000, ramChunk, memory->getSize());
+  frames = getLE(schedulerChunk, 8);
+  cycles = getLE(schedulerChunk + 8, 8);
+  return true;
+}
+
+bool Console::loadState(const vector<uint8_t>& state) {
+  return loadState(state.data(), state.size());
+}
+
+// page hashes are seeded with their index and xored together, so replacing
+// one only takes its old value out and the new one in
+uint64_t Console::stateHash() {
+  auto pages = memory->getPages();
+  auto previous = hashSince;
+  if (previous == 0) {
+    pageHashes.assign(pages, 0);
+    ramHash = 0;
+  }
+  for (uint32_t page = 0; page < pages; page++) {
+    if (previous == 0 || memory->dirty(page, previous)) {
+      auto len = std::min(memory->getSize() - (page << 8), 0x100u);
+      auto hash = hash64(memory->getPage(page), len, page);
+      ramHash ^= pageHashes[page] ^ hash;
+      pageHashes[page] = hash;
+    }
+  }
+  hashSince = memory->checkpoint();
+
+  uint8_t fields[STATE_CPU_SIZE + STATE_SCHEDULER_SIZE];
+  auto ptr = putLE(fields, cpu->a, 1);
+  ptr = putLE(ptr, cpu->x, 1);
+  ptr = putLE(ptr, cpu->y, 1);
+  ptr = putLE(ptr, cpu->getStatus(), 1);
+  ptr = putLE(ptr, cpu->sp, 1);
+  ptr = putLE(ptr, cpu->pc, 2);
+  ptr = putLE(ptr, cpu->cycles, 2);
+  ptr = putLE(ptr, frames, 8);
+  putLE(ptr, cycles, 8);
+  return hash64(fields, sizeof(fields), ramHash);
+}
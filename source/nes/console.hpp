@@ -0,0 +1,75 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "memory.hpp"
+#include "memorybus.hpp"
+#include "rom.hpp"
+
+using std::shared_ptr;
+using std::vector;
+
+#define CPU_CYCLES_PER_FRAME 29781
+#define STATE_MAGIC 0x5353454e  // "NESS"
+#define STATE_VERSION 1
+
+// A CPU wired to 64 KB of RAM, plus the frame scheduler driving it.
+class Console {
+  Console(const Console&) = delete;
+  Console& operator=(const Console&) = delete;
+
+ public:
+  Console(bool verbose = false);
+  ~Console() = default;
+
+  // child sharing every memory page with this console until either writes
+  // to it, so forking costs the same whatever the amount of RAM
+  shared_ptr<Console> fork();
+
+  void loadProgram(uint16_t addr, const uint8_t* data, uint32_t len);
+  // maps the PRG ROM of a mapper 0 (NROM) iNES image at $8000, a single
+  // 16 KB bank is mirrored at $c000; false for any other image
+  bool loadCartridge(const Rom& rom);
+  void reset();
+  uint32_t frame();
+  // interprets the frame with the CPU hooks, see NoHooks; when the hooks
+  // stop the CPU early the next call finishes the same frame
+  template <typename Hooks>
+  uint32_t frame(Hooks& hooks) {
+    auto budget = frameBudget();
+    return endFrame(cpu->run(budget, hooks), budget);
+  }
+
+  // Save states are a little-endian header followed by tagged chunks, see
+  // console.cpp for the layout. Buffers must hold stateSize() bytes.
+  uint32_t stateSize() const;
+  uint32_t saveState(uint8_t* buffer) const;
+  // only copies the RAM pages dirty since the memory checkpoint, the buffer
+  // must still hold the state saved at that checkpoint
+  uint32_t saveState(uint8_t* buffer, uint32_t since) const;
+  uint32_t stateRamOffset() const;
+  void saveState(vector<uint8_t>& state) const;
+  bool loadState(const uint8_t* buffer, uint32_t size);
+  bool loadState(const vector<uint8_t>& state);
+
+  // 64-bit hash of everything a save state holds, equal states hash equal.
+  // Per page hashes are cached and with dirty tracking only pages written
+  // since the previous call are hashed again.
+  uint64_t stateHash();
+
+  shared_ptr<Memory> memory;
+  shared_ptr<MemoryBus> bus;
+  shared_ptr<CPU> cpu;
+  uint32_t cyclesPerFrame = CPU_CYCLES_PER_FRAME;
+  uint64_t frames = 0;
+  uint64_t cycles = 0;
+
+ private:
+  Console(shared_ptr<Memory> amemory, bool verbose);
+
+  uint32_t frameBudget() const;
+  uint32_t endFrame(uint32_t elapsed, uint32_t budget);
+
+  vector<uint64_t> pageHashes;
+  uint64_t ramHash = 0;
+  uint32_t hashSince = 0;
+};
@@ -0,0 +1,157 @@
+#include "coverage.hpp"
+
+using std::dec;
+using std::hex;
+using std::ofstream;
+using std::setfill;
+using std::setw;
+
+// instructions whose execution reads their operand through CPU::read8()
+static const char* const READS[] = {"ADC", "AND", "ASL", "BIT", "CMP", "CPX",
+                                    "CPY", "DEC", "EOR", "INC", "LDA", "LDX",
+                                    "LDY", "LSR", "ORA", "ROL", "ROR", "SBC"};
+static const char* const ENDS[] = {"BRK", "JMP", "JSR", "RTI", "RTS", "XXX"};
+
+static bool listed(const char* mnemonic, const char* const* list,
+                   size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (strcmp(mnemonic, list[i]) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// what every opcode does that coverage cares about, built once
+const Coverage::Kind* Coverage::kindTable() {
+  static const auto table = [] {
+    std::array<Kind, 0x100> result;
+    auto opcodes = CPU::opcodeTable();
+    for (uint32_t opcode = 0; opcode < 0x100; opcode++) {
+      auto& info = opcodes[opcode];
+      auto& kind = result[opcode];
+      auto mode = CPU::getAddressing(info);
+      auto memory = mode != Addressing::Imp && mode != Addressing::Acc &&
+                    mode != Addressing::Imm && mode != Addressing::Rel;
+      // undecoded opcodes take no bytes and stay where they are
+      kind.bytes = info.bytes ? info.bytes : 1;
+      kind.mode = mode;
+      kind.reads = memory && listed(info.mnemonic, READS,
+                                    sizeof(READS) / sizeof(READS[0]));
+      kind.indirect = info.bytes && (mode == Addressing::Ind ||
+                                     mode == Addressing::Indx ||
+                                     mode == Addressing::Indy);
+      kind.ends = mode == Addressing::Rel ||
+                  listed(info.mnemonic, ENDS, sizeof(ENDS) / sizeof(ENDS[0]));
+    }
+    return result;
+  }();
+  return table.data();
+}
+
+Coverage::Coverage()
+    : kinds(kindTable()),
+      flags(COVERAGE_ADDRESSES),
+      blockCounts(COVERAGE_ADDRESSES),
+      blockCycles(COVERAGE_ADDRESSES),
+      blockEnds(COVERAGE_ADDRESSES) {}
+
+void Coverage::clear() {
+  std::fill(flags.begin(), flags.end(), 0);
+  std::fill(blockCounts.begin(), blockCounts.end(), 0);
+  std::fill(blockCycles.begin(), blockCycles.end(), 0);
+  std::fill(blockEnds.begin(), blockEnds.end(), 0);
+  leader = true;
+  runCycles = 0;
+}
+
+// the pointer bytes the addressing mode reads, as CPU::ind(), indx() and
+// indy() read them
+void Coverage::pointer(const CPU& acpu, Addressing mode) {
+  uint8_t operands[2];
+  acpu.bus->peek(acpu.pc + 1, operands, mode == Addressing::Ind ? 2 : 1);
+  uint16_t ptr = operands[0];
+  if (mode == Addressing::Ind) {
+    ptr |= operands[1] << 8;
+  } else if (mode == Addressing::Indx) {
+    ptr += acpu.x;
+  }
+  flags[ptr] |= COVERAGE_DATA;
+  flags[(ptr & 0xff00) | ((ptr + 1) & 0x00ff)] |= COVERAGE_DATA;
+}
+
+void Coverage::endBlock(uint16_t pc) {
+  blockCounts[blockStart]++;
+  blockCycles[blockStart] += runCycles;
+  blockEnds[blockStart] = pc;
+  runCycles = 0;
+  leader = true;
+}
+
+uint32_t Coverage::count(uint8_t mask) const {
+  uint32_t total = 0;
+  for (auto flag : flags) {
+    total += (flag & mask) != 0;
+  }
+  return total;
+}
+
+vector<Coverage::Block> Coverage::hotBlocks(uint32_t limit) const {
+  vector<Block> blocks;
+  for (uint32_t start = 0; start < COVERAGE_ADDRESSES; start++) {
+    if (blockCounts[start]) {
+      blocks.push_back({uint16_t(start), blockEnds[start], blockCounts[start],
+                        blockCycles[start]});
+    }
+  }
+  auto hotter = [](const Block& a, const Block& b) {
+    return a.cycles != b.cycles ? a.cycles > b.cycles : a.start < b.start;
+  };
+  if (blocks.size() > limit) {
+    std::partial_sort(blocks.begin(), blocks.begin() + limit, blocks.end(),
+                      hotter);
+    blocks.resize(limit);
+  } else {
+    std::sort(blocks.begin(), blocks.end(), hotter);
+  }
+  return blocks;
+}
+
+void Coverage::report(ostream& out, uint32_t limit) const {
+  uint64_t total = 0;
+  for (auto cycles : blockCycles) {
+    total += cycles;
+  }
+  auto format = out.flags();
+  out << "opcodes " << count(COVERAGE_OPCODE) << " code "
+      << count(COVERAGE_CODE) << " data " << count(COVERAGE_DATA)
+      << " indirect " << count(COVERAGE_INDIRECT) << "\n";
+  out << "start  end            count     cycles      %\n";
+  for (auto& block : hotBlocks(limit)) {
+    out << setfill('0') << hex << setw(4) << block.start << "   " << setw(4)
+        << block.end << setfill(' ') << dec << setw(16) << block.count
+        << setw(11) << block.cycles << std::fixed << std::setprecision(2)
+        << setw(7) << (total ? 100.0 * block.cycles / total : 0.0) << "\n";
+  }
+  out.flags(format);
+}
+
+void Coverage::writeCdl(ostream& out, uint16_t start, uint32_t size,
+                        uint32_t fold) const {
+  size = std::min(size, uint32_t(COVERAGE_ADDRESSES));
+  if (fold == 0 || fold > size) {
+    fold = size;
+  }
+  vector<uint8_t> folded(fold);
+  for (uint32_t i = 0; i < size; i++) {
+    folded[i % fold] |= flags[uint16_t(start + i)];
+  }
+  out.write(reinterpret_cast<const char*>(folded.data()), folded.size());
+}
+
+bool Coverage::saveCdl(const string& path, uint16_t start, uint32_t size,
+                       uint32_t fold) const {
+  ofstream file(path, std::ios::binary);
+  writeCdl(file, start, size, fold);
+  return file.good();
+}
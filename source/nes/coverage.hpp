@@ -0,0 +1,112 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::ostream;
+using std::string;
+using std::vector;
+
+#define COVERAGE_ADDRESSES 0x10000
+// Per address flags. Code, data and indirect data are the bits FCEUX code
+// data logs use for PRG ROM; opcode is ours, set on the first byte of every
+// executed instruction, so code bytes without it are operands.
+#define COVERAGE_CODE 0x01
+#define COVERAGE_DATA 0x02
+#define COVERAGE_INDIRECT 0x20
+#define COVERAGE_OPCODE 0x80
+
+// Records which addresses were executed as opcodes or operands and which
+// were read as data, plus the basic blocks run and what they cost. Pass it
+// as the hooks of CPU::run() or Console::frame(); runs without it are not
+// slowed down. Data reads are the operands of instructions that load them,
+// taken from the address the CPU resolved, and the pointers of indirect
+// modes; stack pulls are not counted. A basic block runs from the
+// instruction control reached it at up to the next branch, jump, call,
+// return or BRK, so entering a block in the middle counts another block.
+class Coverage : public NoHooks {
+  Coverage(const Coverage&) = delete;
+  Coverage& operator=(const Coverage&) = delete;
+
+ public:
+  struct Block {
+    uint16_t start;
+    // address of the instruction ending the block
+    uint16_t end;
+    uint64_t count;
+    uint64_t cycles;
+  };
+
+  Coverage();
+  ~Coverage() = default;
+
+  void fetch(const CPU& acpu) {
+    auto pc = acpu.pc;
+    auto& kind = kinds[acpu.opcodeInfo.opcode];
+    flags[pc] |= COVERAGE_CODE | COVERAGE_OPCODE;
+    for (uint32_t i = 1; i < kind.bytes; i++) {
+      flags[uint16_t(pc + i)] |= COVERAGE_CODE;
+    }
+    if (kind.indirect) {
+      pointer(acpu, kind.mode);
+    }
+    if (leader) {
+      blockStart = pc;
+      leader = false;
+    }
+    cpu = &acpu;
+  }
+  void instruction(uint16_t pc, uint8_t opcode, uint32_t cycles) {
+    auto& kind = kinds[opcode];
+    if (kind.reads) {
+      flags[cpu->address] |=
+          COVERAGE_DATA | (kind.indirect ? COVERAGE_INDIRECT : 0);
+    }
+    runCycles += cycles;
+    if (kind.ends) {
+      endBlock(pc);
+    }
+  }
+  void clear();
+
+  uint8_t getFlags(uint16_t addr) const { return flags[addr]; }
+  // addresses with any of the flags in mask
+  uint32_t count(uint8_t mask) const;
+
+  // blocks by cycles spent, most first, at most limit of them
+  vector<Block> hotBlocks(uint32_t limit) const;
+  void report(ostream& out, uint32_t limit = 20) const;
+  // One flag byte per address from start on, size of them. With fold, the
+  // range is folded onto fold bytes by or-ing the flags of its mirrors,
+  // e.g. $8000-$ffff onto the 16 KB PRG ROM mirrored there.
+  void writeCdl(ostream& out, uint16_t start = 0,
+                uint32_t size = COVERAGE_ADDRESSES, uint32_t fold = 0) const;
+  bool saveCdl(const string& path, uint16_t start = 0,
+               uint32_t size = COVERAGE_ADDRESSES, uint32_t fold = 0) const;
+
+ private:
+  struct Kind {
+    uint8_t bytes;
+    Addressing mode;
+    // loads its operand from memory
+    bool reads;
+    // goes through a pointer it reads from memory
+    bool indirect;
+    // ends a basic block
+    bool ends;
+  };
+
+  static const Kind* kindTable();
+  void pointer(const CPU& acpu, Addressing mode);
+  void endBlock(uint16_t pc);
+
+  const Kind* kinds;
+  vector<uint8_t> flags;
+  // per block start
+  vector<uint64_t> blockCounts;
+  vector<uint64_t> blockCycles;
+  vector<uint16_t> blockEnds;
+  const CPU* cpu = nullptr;
+  bool leader = true;
+  uint16_t blockStart = 0;
+  uint64_t runCycles = 0;
+};
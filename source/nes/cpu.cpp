@@ -1,6 +1,10 @@
 #include "cpu.hpp"
 
+#include "disassembler.hpp"
+
 using std::exception;
+using std::make_shared;
+using std::pair;
 
 void CPU::push8(uint8_t value) {
   uint16_t addr = STACK_PAGE + sp;
@@ -173,16 +177,19 @@ void CPU::reset() {
   a = 0;
   x = 0;
   y = 0;
-  p = 0x20;
+  setStatus(0x20);
   sp = 0xfd;
   pc = bus->read16(RESET_PROC_ADDR);
+  if (recompiler) {
+    recompiler->flush();
+  }
 }
 
 void CPU::nmi() {
   push16(pc);
   pc = bus->read16(NMI_PROC_ADDR);
-  auto status =
-      p & ~static_cast<uint8_t>(Flags::B) | static_cast<uint8_t>(Flags::U);
+  auto status = getStatus() & ~static_cast<uint8_t>(Flags::B) |
+                static_cast<uint8_t>(Flags::U);
   push8(status);
   setFlag(Flags::I);
   cycles += 7;
@@ -194,8 +201,8 @@ void CPU::irq() {
   }
   push16(pc);
   pc = bus->read16(IRQ_PROC_ADDR);
-  auto status =
-      p & ~static_cast<uint8_t>(Flags::B) | static_cast<uint8_t>(Flags::U);
+  auto status = getStatus() & ~static_cast<uint8_t>(Flags::B) |
+                static_cast<uint8_t>(Flags::U);
   push8(status);
   setFlag(Flags::I);
   cycles += 7;
@@ -203,42 +210,72 @@ void CPU::irq() {
 
 void CPU::clock(bool force) {
   if (cycles == 0 || force) {
-    auto opcode = bus->read8(pc);
-    opcodeInfo = opcodes[opcode];
-    if (verbose) {
-      if (opcodeInfo.mnemonic == "XXX") {
-        fprintf(stderr, "Invalid opcode at %04x\n", pc);
-      }
-      debug();
-    }
-
-    (this->*opcodeInfo.resolve)();
-    cycles += opcodeInfo.cycles;
-    pc += opcodeInfo.bytes;
-    (this->*opcodeInfo.execute)();
+    step();
   }
   cycles--;
 }
 
-void CPU::debug() {
-  uint8_t byte1 = bus->read8(pc);
-  char byte2[3] = "  ";
-  if (opcodeInfo.bytes >= 2) {
-    auto value = bus->read8(pc + 1);
-    sprintf(byte2, "%02x", value);
+void CPU::step() {
+  if (backend == Backend::Recompiler) {
+    recompiler->step();
+    return;
   }
-  char byte3[3] = "  ";
-  if (opcodeInfo.bytes >= 3) {
-    auto value = bus->read8(pc + 2);
-    sprintf(byte3, "%02x", value);
+  NoHooks hooks;
+  step(hooks);
+}
+
+uint32_t CPU::run(uint32_t budget) {
+  if (backend == Backend::Recompiler) {
+    return recompiler->run(budget);
   }
+  NoHooks hooks;
+  return run(budget, hooks);
+}
 
-  printf("%04x %s  %02x %s %s a:%02x x:%02x y:%02x sp:%02x p:%08b\n", pc,
-         opcodeInfo.mnemonic.c_str(), byte1, byte2, byte3, a, x, y, sp, p);
+void CPU::setBackend(Backend abackend) {
+  if (abackend == Backend::Recompiler) {
+    if (!recompiler) {
+      recompiler = make_shared<Recompiler>(*this);
+    }
+    if (!recompiler->available()) {
+      abackend = Backend::Interpreter;
+    }
+    recompiler->flush();
+  }
+  backend = abackend;
 }
 
-void CPU::setOpcodesInfo() {
-  opcodes = {
+void CPU::debug() {
+  // peeked, a read of the instruction would be a second, visible access
+  uint8_t code[3] = {};
+  bus->peek(pc, code, 1);
+  bus->peek(pc, code, Disassembler::length(code[0]));
+  char line[DISASSEMBLER_LINE];
+  Disassembler::line(pc, code, line);
+  printf("%-28s a:%02x x:%02x y:%02x sp:%02x p:%08b\n", line, a, x, y, sp,
+         getStatus());
+}
+
+Addressing CPU::getAddressing(const OpcodeInfo& info) {
+  static const pair<void (CPU::*)(), Addressing> modes[] = {
+      {&CPU::abs, Addressing::Abs},   {&CPU::absx, Addressing::Absx},
+      {&CPU::absy, Addressing::Absy}, {&CPU::acc, Addressing::Acc},
+      {&CPU::imm, Addressing::Imm},   {&CPU::imp, Addressing::Imp},
+      {&CPU::ind, Addressing::Ind},   {&CPU::indx, Addressing::Indx},
+      {&CPU::indy, Addressing::Indy}, {&CPU::rel, Addressing::Rel},
+      {&CPU::zp, Addressing::Zp},     {&CPU::zpx, Addressing::Zpx},
+      {&CPU::zpy, Addressing::Zpy}};
+  for (auto& mode : modes) {
+    if (info.resolve == mode.first) {
+      return mode.second;
+    }
+  }
+  return Addressing::Imp;
+}
+
+// shared by every CPU; constant initialized, so no CPU allocates or locks
+const OpcodeInfo* CPU::opcodeTable() {
+  static const OpcodeInfo table[256] = {
       OpcodeInfo{0x0, "BRK", &CPU::imp, &CPU::BRK, 2, 7, false},
       OpcodeInfo{0x1, "ORA", &CPU::indx, &CPU::ORA, 2, 6, false},
       OpcodeInfo{0x2, "XXX", &CPU::imp, &CPU::XXX, 0, 2, false},
@@ -496,6 +533,7 @@ void CPU::setOpcodesInfo() {
       OpcodeInfo{0xfe, "INC", &CPU::absx, &CPU::INC, 3, 7, false},
       OpcodeInfo{0xff, "XXX", &CPU::absx, &CPU::XXX, 0, 7, false},
   };
+  return table;
 }
 
 void CPU::branch(bool condition) {
@@ -511,25 +549,21 @@ void CPU::branch(bool condition) {
 
 void CPU::compare(uint8_t r) {
   auto value = read8();
-  setFlag(Flags::C, r >= value);
-  setFlag(Flags::Z, r == value);
-  setFlag(Flags::N, ((r - value) & 0x80) != 0);
-  if (opcodeInfo.penality && penality) {
-    cycles++;
-  }
+  uint16_t difference = uint16_t(r) - value;
+  // no borrow out of bit 7 means r >= value
+  carry = (~difference >> 8) & 0x01;
+  setZN(difference);
+  cycles += opcodeInfo.penality & penality;
 }
 
 void CPU::adc(uint8_t value) {
-  uint16_t c = getFlag(Flags::C) ? 1 : 0;
-  uint16_t sum = uint16_t(a) + value + c;
-  setFlag(Flags::C, sum > 0x00ff);
+  uint16_t sum = uint16_t(a) + value + carry;
+  carry = sum >> 8;
   uint8_t result = sum & 0x00ff;
-  setFlag(Flags::V, ((result ^ a) & (result ^ value) & 0x80) != 0);
+  vResult = (result ^ a) & (result ^ value);
   a = result;
   setZN(a);
-  if (opcodeInfo.penality && penality) {
-    cycles += 1;
-  }
+  cycles += opcodeInfo.penality & penality;
 }
 
 void CPU::ADC() {
@@ -541,14 +575,12 @@ void CPU::AND() {
   uint16_t value = read8();
   a &= value;
   setZN(a);
-  if (opcodeInfo.penality && penality) {
-    cycles += 1;
-  }
+  cycles += opcodeInfo.penality & penality;
 }
 
 void CPU::ASL() {
   auto value = read8();
-  setFlag(Flags::C, (value & 0x80) != 0);
+  carry = value >> 7;
   value <<= 1;
   setZN(value);
   write8(value);
@@ -562,9 +594,9 @@ void CPU::BEQ() { branch(getFlag(Flags::Z)); }
 
 void CPU::BIT() {
   auto value = read8();
-  setFlag(Flags::Z, (a & value) == 0);
-  setFlag(Flags::N, (value & 0x80) != 0);
-  setFlag(Flags::V, (value & 0x40) != 0);
+  zResult = a & value;
+  nResult = value;
+  vResult = value << 1;
 }
 
 void CPU::BMI() { branch(getFlag(Flags::N)); }
@@ -576,8 +608,8 @@ void CPU::BPL() { branch(!getFlag(Flags::N)); }
 void CPU::BRK() {
   push16(pc);
   pc = bus->read16(IRQ_PROC_ADDR);
-  auto status =
-      p | static_cast<uint8_t>(Flags::B) | static_cast<uint8_t>(Flags::U);
+  auto status = getStatus() | static_cast<uint8_t>(Flags::B) |
+                static_cast<uint8_t>(Flags::U);
   push8(status);
   setFlag(Flags::I);
 }
@@ -619,9 +651,7 @@ void CPU::DEY() {
 void CPU::EOR() {
   a ^= read8();
   setZN(a);
-  if (opcodeInfo.penality && penality) {
-    cycles++;
-  }
+  cycles += opcodeInfo.penality & penality;
 }
 
 void CPU::INC() {
@@ -664,7 +694,7 @@ void CPU::LDY() {
 
 void CPU::LSR() {
   auto value = read8();
-  setFlag(Flags::C, (value & 0x01) != 0);
+  carry = value & 0x01;
   value >>= 1;
   setZN(value);
   write8(value);
@@ -680,8 +710,8 @@ void CPU::ORA() {
 void CPU::PHA() { push8(a); }
 
 void CPU::PHP() {
-  auto status =
-      p | static_cast<uint8_t>(Flags::B) | static_cast<uint8_t>(Flags::U);
+  auto status = getStatus() | static_cast<uint8_t>(Flags::B) |
+                static_cast<uint8_t>(Flags::U);
   push8(status);
 }
 
@@ -690,12 +720,12 @@ void CPU::PLA() {
   setZN(a);
 }
 
-void CPU::PLP() { p = pop8() & 0xef | 0x20; }
+void CPU::PLP() { setStatus(pop8() & 0xef | 0x20); }
 
 void CPU::ROL() {
   auto value = read8();
-  uint8_t c = getFlag(Flags::C) ? 0x01 : 0x00;
-  setFlag(Flags::C, (value & 0x80) != 0);
+  uint8_t c = carry;
+  carry = value >> 7;
   value = (value << 1) | c;
   setZN(value);
   write8(value);
@@ -703,15 +733,15 @@ void CPU::ROL() {
 
 void CPU::ROR() {
   auto value = read8();
-  uint8_t c = getFlag(Flags::C) ? 0x01 : 0x00;
-  setFlag(Flags::C, (value & 0x01) != 0);
+  uint8_t c = carry;
+  carry = value & 0x01;
   value = (c << 7) | (value >> 1);
   setZN(value);
   write8(value);
 }
 
 void CPU::RTI() {
-  p = pop8() & 0xef | 0x20;
+  setStatus(pop8() & 0xef | 0x20);
   pc = pop16();
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "bus.hpp"
+#include "recompiler.hpp"
 
 using std::string;
 using std::vector;
@@ -37,11 +38,16 @@ enum class Addressing : uint8_t {
   Zpy,   // Zero page indexed
 };
 
+enum class Backend : uint8_t {
+  Interpreter,
+  Recompiler,
+};
+
 class CPU;
 
 struct OpcodeInfo {
   uint8_t opcode;
-  string mnemonic;
+  const char* mnemonic;
   void (CPU::*resolve)() = nullptr;
   void (CPU::*execute)() = nullptr;
   uint8_t bytes;
@@ -49,14 +55,50 @@ struct OpcodeInfo {
   bool penality;
 };
 
-class CPU {
+// Registers and per-instruction scratch of the CPU. Kept trivially copyable
+// so a snapshot is a plain memory copy.
+struct CpuState {
+  uint8_t a = 0;
+  uint8_t x = 0;
+  uint8_t y = 0;
+  uint8_t p = 0x24;
+  uint8_t carry = 0;
+  uint8_t zResult = 0x01;
+  uint8_t nResult = 0x00;
+  uint8_t vResult = 0x00;
+  uint8_t sp = 0xff;
+  uint16_t pc = 0x0000;
+  Addressing addressing = Addressing::Imp;
+  uint16_t address = 0x0000;
+  bool penality = false;
+  uint16_t cycles = 0;
+  OpcodeInfo opcodeInfo;
+};
+
+static_assert(std::is_trivially_copyable<CpuState>::value,
+              "CpuState must be trivially copyable");
+
+// Hooks the interpreter calls around every instruction: fetch() once the
+// opcode is decoded, with the registers as they are before it runs, and
+// instruction() afterwards with the address it was fetched from, its opcode
+// and the cycles it took. run() asks stop() before every instruction and
+// returns early when it is true. They are a template parameter of step() and
+// run(), so the default inlines to nothing and the plain loop carries no
+// extra branches. Hooks derive from NoHooks and hide what they use.
+struct NoHooks {
+  void fetch(const CPU&) {}
+  void instruction(uint16_t, uint8_t, uint32_t) {}
+  bool stop(const CPU&) { return false; }
+};
+
+class CPU : public CpuState {
   CPU(const CPU&) = delete;
   CPU& operator=(const CPU&) = delete;
 
  public:
   CPU(shared_ptr<Bus> abus, bool verbose = false) : bus(abus) {
     this->verbose = verbose;
-    setOpcodesInfo();
+    opcodes = opcodeTable();
   }
   ~CPU() = default;
 
@@ -64,23 +106,75 @@ class CPU {
   void nmi();
   void irq();
   void clock(bool force = false);
+  void step();
+  uint32_t run(uint32_t budget);
+  // always interpret, whatever the backend, so hooks see every instruction
+  template <typename Hooks>
+  void step(Hooks& hooks);
+  template <typename Hooks>
+  uint32_t run(uint32_t budget, Hooks& hooks);
+  void setBackend(Backend abackend);
+  Backend getBackend() const { return backend; }
+  void save(CpuState& state) const { state = *this; }
+  void load(const CpuState& state) { static_cast<CpuState&>(*this) = state; }
 
  public:  // for testing
   // private:
   // flags operations
-  void setFlag(Flags mask) { p |= static_cast<uint8_t>(mask); }
-  void clearFlag(Flags mask) { p &= ~static_cast<uint8_t>(mask); }
-  bool getFlag(Flags mask) const { return p & static_cast<uint8_t>(mask); }
+  // C, Z, N and V live outside of p: ALU instructions only store the carry
+  // and the bytes the flags derive from, p is assembled on demand
+  void setFlag(Flags mask) { setFlag(mask, true); }
+  void clearFlag(Flags mask) { setFlag(mask, false); }
+  bool getFlag(Flags mask) const {
+    switch (mask) {
+      case Flags::C:
+        return carry;
+      case Flags::Z:
+        return zResult == 0;
+      case Flags::N:
+        return nResult & 0x80;
+      case Flags::V:
+        return vResult & 0x80;
+      default:
+        return p & static_cast<uint8_t>(mask);
+    }
+  }
   void setFlag(Flags mask, bool on) {
-    if (on) {
-      setFlag(mask);
-    } else {
-      clearFlag(mask);
+    switch (mask) {
+      case Flags::C:
+        carry = on;
+        break;
+      case Flags::Z:
+        zResult = !on;
+        break;
+      case Flags::N:
+        nResult = on ? 0x80 : 0x00;
+        break;
+      case Flags::V:
+        vResult = on ? 0x80 : 0x00;
+        break;
+      default:
+        if (on) {
+          p |= static_cast<uint8_t>(mask);
+        } else {
+          p &= ~static_cast<uint8_t>(mask);
+        }
     }
   }
   void setZN(uint8_t value) {
-    setFlag(Flags::Z, value == 0);
-    setFlag(Flags::N, value >= 0x80);
+    zResult = value;
+    nResult = value;
+  }
+  uint8_t getStatus() const {
+    return (p & 0x3c) | carry | ((zResult == 0) << 1) |
+           ((vResult & 0x80) >> 1) | (nResult & 0x80);
+  }
+  void setStatus(uint8_t value) {
+    p = value;
+    carry = value & 0x01;
+    zResult = ~value & 0x02;
+    nResult = value;
+    vResult = value << 1;
   }
   uint8_t read8();
   void write8(uint8_t value);
@@ -109,7 +203,8 @@ class CPU {
   void zpx();
   void zpy();
   // instructions
-  void setOpcodesInfo();
+  static const OpcodeInfo* opcodeTable();
+  static Addressing getAddressing(const OpcodeInfo& info);
   void branch(bool condition);
   void compare(uint8_t r);
   void adc(uint8_t value);
@@ -173,17 +268,41 @@ class CPU {
   void XXX();
 
   shared_ptr<Bus> bus;
-  uint8_t a = 0;
-  uint8_t x = 0;
-  uint8_t y = 0;
-  uint8_t p = 0x24;
-  uint8_t sp = 0xff;
-  uint16_t pc = 0x0000;
-  Addressing addressing = Addressing::Imp;
-  uint16_t address = 0x0000;
-  bool penality = false;
-  uint16_t cycles = 0;
-  OpcodeInfo opcodeInfo;
-  vector<OpcodeInfo> opcodes;
+  const OpcodeInfo* opcodes = nullptr;
   bool verbose = false;
-};
\ No newline at end of file
+  Backend backend = Backend::Interpreter;
+  shared_ptr<Recompiler> recompiler = nullptr;
+};
+
+template <typename Hooks>
+void CPU::step(Hooks& hooks) {
+  auto at = pc;
+  auto opcode = bus->read8(pc);
+  opcodeInfo = opcodes[opcode];
+  if (verbose) {
+    if (strcmp(opcodeInfo.mnemonic, "XXX") == 0) {
+      fprintf(stderr, "Invalid opcode at %04x\n", pc);
+    }
+    debug();
+  }
+  hooks.fetch(*this);
+
+  auto start = cycles;
+  (this->*opcodeInfo.resolve)();
+  cycles += opcodeInfo.cycles;
+  pc += opcodeInfo.bytes;
+  (this->*opcodeInfo.execute)();
+  hooks.instruction(at, opcode, uint16_t(cycles - start));
+}
+
+template <typename Hooks>
+uint32_t CPU::run(uint32_t budget, Hooks& hooks) {
+  uint32_t elapsed = cycles;
+  while (elapsed < budget && !hooks.stop(*this)) {
+    cycles = 0;
+    step(hooks);
+    elapsed += cycles;
+  }
+  cycles = 0;
+  return elapsed;
+}
@@ -0,0 +1,66 @@
+#include "debugger.hpp"
+
+Debugger::Debugger(shared_ptr<Memory> amemory, Callback acallback)
+    : memory(amemory), callback(acallback) {
+  memory->setWatcher([this](uint16_t addr, uint8_t value, bool write) {
+    access(addr, value, write);
+  });
+}
+
+Debugger::~Debugger() {
+  memory->clearWatches();
+  memory->setWatcher(nullptr);
+}
+
+void Debugger::setBreakpoint(uint16_t addr, bool enabled) {
+  if (breakpoints[addr] != enabled) {
+    breakpoints[addr] = enabled;
+    breakpointCount += enabled ? 1 : -1;
+  }
+}
+
+void Debugger::clearBreakpoints() {
+  breakpoints.reset();
+  breakpointCount = 0;
+}
+
+void Debugger::watch(uint16_t addr, bool read, bool write) {
+  memory->watch(addr, read, write);
+}
+
+void Debugger::clearWatchpoints() { memory->clearWatches(); }
+
+bool Debugger::stopAt(const CPU& acpu) {
+  if (pending) {
+    pending = false;
+    hits++;
+    return true;
+  }
+  auto resumed = resuming && acpu.pc == resumePc;
+  resuming = false;
+  if (!breakpoints[acpu.pc] || resumed) {
+    return false;
+  }
+  DebugHit candidate = {DebugEvent::Breakpoint, acpu.pc, acpu.pc, 0};
+  if (callback && !callback(acpu, candidate)) {
+    return false;
+  }
+  hit = candidate;
+  hits++;
+  resuming = true;
+  resumePc = acpu.pc;
+  return true;
+}
+
+// the opcode is read before fetch() and its operands after, both ignored
+void Debugger::access(uint16_t addr, uint8_t value, bool write) {
+  if (!cpu || (!write && uint16_t(addr - at) < length)) {
+    return;
+  }
+  DebugHit candidate = {write ? DebugEvent::Write : DebugEvent::Read, at,
+                        addr, value};
+  if (!callback || callback(*cpu, candidate)) {
+    hit = candidate;
+    pending = true;
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "cpu.hpp"
+#include "memory.hpp"
+
+using std::bitset;
+using std::function;
+using std::shared_ptr;
+
+#define DEBUGGER_ADDRESSES 0x10000
+
+enum class DebugEvent : uint8_t {
+  Breakpoint,
+  Read,
+  Write,
+};
+
+struct DebugHit {
+  DebugEvent event;
+  // address of the instruction that hit
+  uint16_t pc;
+  // breakpoint or accessed address
+  uint16_t address;
+  // value read or written
+  uint8_t value;
+};
+
+// Execution breakpoints and read/write watchpoints. Pass it as the hooks of
+// CPU::run() or Console::frame(): breakpoints stop the run before the
+// instruction at their address, watchpoints right after the instruction
+// that made the access. Breakpoints are a bitmap only looked at while at
+// least one is set; watchpoints take watched pages out of the memory page
+// tables, so other pages keep the fast path. The callback sees the CPU
+// state when the event triggers, in the middle of the instruction for
+// watchpoints, and returning false lets the run go on. Read watchpoints
+// are for data, breakpoints for code: the CPU reading the opcode and
+// operands of an instruction never triggers them, and neither does a data
+// read the instruction makes within its own bytes.
+class Debugger : public NoHooks {
+  Debugger(const Debugger&) = delete;
+  Debugger& operator=(const Debugger&) = delete;
+
+ public:
+  using Callback = function<bool(const CpuState& state, const DebugHit& hit)>;
+
+  Debugger(shared_ptr<Memory> amemory, Callback acallback = nullptr);
+  ~Debugger();
+
+  void setBreakpoint(uint16_t addr, bool enabled = true);
+  bool hasBreakpoint(uint16_t addr) const { return breakpoints[addr]; }
+  void clearBreakpoints();
+  void watch(uint16_t addr, bool read, bool write);
+  void clearWatchpoints();
+
+  void fetch(const CPU& acpu) {
+    cpu = &acpu;
+    at = acpu.pc;
+    length = acpu.opcodeInfo.bytes;
+  }
+  void instruction(uint16_t, uint8_t, uint32_t) {
+    cpu = nullptr;
+  }
+  bool stop(const CPU& acpu) {
+    return (breakpointCount || pending) && stopAt(acpu);
+  }
+
+  // the last event that stopped the CPU, and how many did
+  const DebugHit& getHit() const { return hit; }
+  uint64_t getHits() const { return hits; }
+
+ private:
+  bool stopAt(const CPU& acpu);
+  void access(uint16_t addr, uint8_t value, bool write);
+
+  shared_ptr<Memory> memory;
+  Callback callback;
+  bitset<DEBUGGER_ADDRESSES> breakpoints;
+  uint32_t breakpointCount = 0;
+  // the instruction running, watchpoints only trigger during one
+  const CPU* cpu = nullptr;
+  uint16_t at = 0;
+  // its bytes, whose reads are not data accesses
+  uint8_t length = 0;
+  // a watchpoint triggered, stop before the next instruction
+  bool pending = false;
+  // the breakpoint the CPU stopped at, passed when the run resumes
+  bool resuming = false;
+  uint16_t resumePc = 0;
+  DebugHit hit = {};
+  uint64_t hits = 0;
+};
@@ -0,0 +1,161 @@
+#include "disassembler.hpp"
+
+struct Decoded {
+  char mnemonic[3];
+  Addressing mode;
+  uint8_t length;
+};
+
+// mnemonic, addressing mode and length of every opcode, built once
+static const Decoded* decodeTable() {
+  static const auto table = [] {
+    std::array<Decoded, 0x100> result;
+    auto opcodes = CPU::opcodeTable();
+    for (uint32_t opcode = 0; opcode < 0x100; opcode++) {
+      auto& info = opcodes[opcode];
+      auto& decoded = result[opcode];
+      memcpy(decoded.mnemonic, info.mnemonic, sizeof(decoded.mnemonic));
+      decoded.mode = info.bytes ? CPU::getAddressing(info) : Addressing::Imp;
+      decoded.length = info.bytes ? info.bytes : 1;
+    }
+    return result;
+  }();
+  return table.data();
+}
+
+static const char HEX[] = "0123456789ABCDEF";
+
+static inline void putHex8(char*& out, uint8_t value) {
+  *out++ = HEX[value >> 4];
+  *out++ = HEX[value & 0xf];
+}
+
+static inline void putHex16(char*& out, uint16_t value) {
+  putHex8(out, value >> 8);
+  putHex8(out, value);
+}
+
+template <size_t N>
+static inline void put(char*& out, const char (&text)[N]) {
+  memcpy(out, text, N - 1);
+  out += N - 1;
+}
+
+static char* putInstruction(const Decoded& decoded, uint16_t pc,
+                            const uint8_t* code, char* out) {
+  memcpy(out, decoded.mnemonic, sizeof(decoded.mnemonic));
+  out += sizeof(decoded.mnemonic);
+  switch (decoded.mode) {
+    case Addressing::Imp:
+      break;
+    case Addressing::Acc:
+      put(out, " A");
+      break;
+    case Addressing::Imm:
+      put(out, " #$");
+      putHex8(out, code[1]);
+      break;
+    case Addressing::Zp:
+    case Addressing::Zpx:
+    case Addressing::Zpy:
+      put(out, " $");
+      putHex8(out, code[1]);
+      if (decoded.mode != Addressing::Zp) {
+        put(out, ",");
+        *out++ = decoded.mode == Addressing::Zpx ? 'X' : 'Y';
+      }
+      break;
+    case Addressing::Abs:
+    case Addressing::Absx:
+    case Addressing::Absy:
+      put(out, " $");
+      putHex16(out, code[1] | (code[2] << 8));
+      if (decoded.mode != Addressing::Abs) {
+        put(out, ",");
+        *out++ = decoded.mode == Addressing::Absx ? 'X' : 'Y';
+      }
+      break;
+    case Addressing::Ind:
+      put(out, " ($");
+      putHex16(out, code[1] | (code[2] << 8));
+      put(out, ")");
+      break;
+    case Addressing::Indx:
+      put(out, " ($");
+      putHex8(out, code[1]);
+      put(out, ",X)");
+      break;
+    case Addressing::Indy:
+      put(out, " ($");
+      putHex8(out, code[1]);
+      put(out, "),Y");
+      break;
+    case Addressing::Rel:
+      put(out, " $");
+      putHex16(out, pc + 2 + int8_t(code[1]));
+      break;
+  }
+  *out = '\0';
+  return out;
+}
+
+static char* putLine(const Decoded& decoded, uint16_t pc, const uint8_t* code,
+                     char* out) {
+  putHex16(out, pc);
+  put(out, "  ");
+  putHex8(out, code[0]);
+  for (uint32_t i = 1; i < 3; i++) {
+    if (i < decoded.length) {
+      *out++ = ' ';
+      putHex8(out, code[i]);
+    } else {
+      put(out, "   ");
+    }
+  }
+  put(out, "  ");
+  return putInstruction(decoded, pc, code, out);
+}
+
+uint32_t Disassembler::length(uint8_t opcode) {
+  return decodeTable()[opcode].length;
+}
+
+uint32_t Disassembler::instruction(uint16_t pc, const uint8_t* code,
+                                   char* text) {
+  return putInstruction(decodeTable()[code[0]], pc, code, text) - text;
+}
+
+uint32_t Disassembler::line(uint16_t pc, const uint8_t* code, char* text) {
+  return putLine(decodeTable()[code[0]], pc, code, text) - text;
+}
+
+uint32_t Disassembler::range(uint16_t pc, const uint8_t* code, uint32_t size,
+                             char* text, uint32_t capacity,
+                             uint32_t& written) {
+  auto table = decodeTable();
+  uint32_t offset = 0;
+  written = 0;
+  // room for one more line, its '\n' and the final zero
+  while (offset < size && capacity - written > DISASSEMBLER_LINE) {
+    auto out = text + written;
+    auto address = uint16_t(pc + offset);
+    auto& decoded = table[code[offset]];
+    if (offset + decoded.length <= size) {
+      written = putLine(decoded, address, code + offset, out) - text;
+      offset += decoded.length;
+    } else {
+      putHex16(out, address);
+      put(out, "  ");
+      putHex8(out, code[offset]);
+      put(out, "        .BYTE $");
+      putHex8(out, code[offset]);
+      written = out - text;
+      offset++;
+    }
+    text[written++] = '\n';
+  }
+  if (capacity > written) {
+    text[written] = '\0';
+  }
+  return offset;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "cpu.hpp"
+
+// longest instruction text, "LDA ($12),Y", with its terminating zero
+#define DISASSEMBLER_TEXT 16
+// longest listing line, "C000  B1 12     LDA ($12),Y", with its zero
+#define DISASSEMBLER_LINE 32
+
+// Table-driven 6502 disassembler in the nestest notation, writing into
+// caller buffers without allocating. Opcodes the CPU does not decode take
+// one byte and read XXX.
+class Disassembler {
+  Disassembler() = delete;
+
+ public:
+  // bytes the instruction starting with opcode takes
+  static uint32_t length(uint8_t opcode);
+  // "LDA ($12),Y" for the instruction at pc whose bytes are code, which
+  // must hold length(code[0]) bytes; returns the text length
+  static uint32_t instruction(uint16_t pc, const uint8_t* code, char* text);
+  // "C000  B1 12     LDA ($12),Y", returns the line length
+  static uint32_t line(uint16_t pc, const uint8_t* code, char* text);
+  // Lists size bytes of code loaded at pc, one line per instruction ended
+  // by '\n', as long as lines fit in capacity. A last instruction cut by
+  // the end of code is listed as .BYTE. Returns the bytes of code listed
+  // and sets written to the text length, text is zero terminated.
+  static uint32_t range(uint16_t pc, const uint8_t* code, uint32_t size,
+                        char* text, uint32_t capacity, uint32_t& written);
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "pch.h"
+
+// Little-endian field helpers for the save state and movie formats.
+inline uint8_t* putLE(uint8_t* buffer, uint64_t value, uint32_t bytes) {
+  for (uint32_t i = 0; i < bytes; i++) {
+    *buffer++ = value >> (8 * i);
+  }
+  return buffer;
+}
+
+inline uint64_t getLE(const uint8_t* buffer, uint32_t bytes) {
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < bytes; i++) {
+    value |= uint64_t(buffer[i]) << (8 * i);
+  }
+  return value;
+}
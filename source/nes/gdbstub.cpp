@@ -0,0 +1,632 @@
+#include "gdbstub.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using std::lock_guard;
+using std::unique_lock;
+
+#define WATCH_READ 0x01
+#define WATCH_WRITE 0x02
+
+static const char HEX[] = "0123456789abcdef";
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// hex number at text[at], at least one digit, at is left after it
+static bool parseHex(const string& text, size_t& at, uint32_t& value) {
+  auto first = at;
+  value = 0;
+  for (int digit; at < text.size() && (digit = hexDigit(text[at])) >= 0;
+       at++) {
+    value = (value << 4) | digit;
+  }
+  return at > first && at - first <= 8;
+}
+
+// hex number then the separator, or the end of text when it is 0
+static bool parseField(const string& text, size_t& at, uint32_t& value,
+                       char separator) {
+  if (!parseHex(text, at, value)) {
+    return false;
+  }
+  if (separator == 0) {
+    return at == text.size();
+  }
+  return at < text.size() && text[at++] == separator;
+}
+
+// count bytes of hex text at text[at]
+static bool parseBytes(const string& text, size_t at, uint32_t count,
+                       uint8_t* bytes) {
+  if (text.size() - at != count * 2) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    auto high = hexDigit(text[at + 2 * i]);
+    auto low = hexDigit(text[at + 2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    bytes[i] = (high << 4) | low;
+  }
+  return true;
+}
+
+static void putHex8(string& out, uint8_t value) {
+  out += HEX[value >> 4];
+  out += HEX[value & 0xf];
+}
+
+GdbStub::GdbStub(shared_ptr<CPU> acpu, shared_ptr<Memory> amemory)
+    : cpu(acpu), debugger(amemory) {}
+
+GdbStub::~GdbStub() { close(); }
+
+bool GdbStub::listenTcp(uint16_t aport) {
+  close();
+  auto fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error = string("socket: ") + strerror(errno);
+    return false;
+  }
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(aport);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t length = sizeof(address);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) < 0 ||
+      getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) < 0) {
+    error = string("bind: ") + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  port = ntohs(address.sin_port);
+  return start(fd);
+}
+
+bool GdbStub::listenUnix(const string& path) {
+  close();
+  sockaddr_un address = {};
+  if (path.size() >= sizeof(address.sun_path)) {
+    error = "socket path too long";
+    return false;
+  }
+  auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error = string("socket: ") + strerror(errno);
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+    error = string("bind: ") + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  unixPath = path;
+  return start(fd);
+}
+
+bool GdbStub::start(int afd) {
+  if (::listen(afd, 1) < 0 || pipe(wake) < 0) {
+    error = string("listen: ") + strerror(errno);
+    ::close(afd);
+    return false;
+  }
+  // parking must never block on a full pipe
+  fcntl(wake[1], F_SETFL, O_NONBLOCK);
+  listener = afd;
+  {
+    lock_guard<mutex> guard(lock);
+    closing = false;
+  }
+  server = thread(&GdbStub::serve, this);
+  return true;
+}
+
+void GdbStub::close() {
+  {
+    lock_guard<mutex> guard(lock);
+    closing = true;
+    changed.notify_all();
+  }
+  if (server.joinable()) {
+    auto written = write(wake[1], "", 1);
+    (void)written;
+    server.join();
+  }
+  for (auto fd : {listener, wake[0], wake[1]}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+  listener = wake[0] = wake[1] = -1;
+  if (!unixPath.empty()) {
+    unlink(unixPath.c_str());
+    unixPath.clear();
+  }
+}
+
+void GdbStub::serve() {
+  while (true) {
+    // a session may have drained the wake up of close()
+    {
+      lock_guard<mutex> guard(lock);
+      if (closing) {
+        return;
+      }
+    }
+    pollfd fds[] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+      return;
+    }
+    char drained[16];
+    if ((fds[1].revents & POLLIN) &&
+        read(wake[0], drained, sizeof(drained)) < 0) {
+      return;
+    }
+    if (fds[0].revents & POLLIN) {
+      auto client = accept(listener, nullptr, nullptr);
+      if (client >= 0) {
+        int on = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        session(client);
+        ::close(client);
+      }
+    }
+  }
+}
+
+void GdbStub::session(int client) {
+  acks = true;
+  signal = 5;
+  running = false;
+  // the client expects a stopped target once attached
+  if (!halt()) {
+    return;
+  }
+  string buffer;
+  char data[GDB_PACKET_SIZE];
+  while (true) {
+    pollfd fds[] = {{client, POLLIN, 0}, {wake[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+      break;
+    }
+    // drained before looking at parked, a park after that wakes us again
+    if ((fds[1].revents & POLLIN) && read(wake[0], data, sizeof(data)) < 0) {
+      break;
+    }
+    bool stopped;
+    {
+      lock_guard<mutex> guard(lock);
+      if (closing) {
+        break;
+      }
+      stopped = parked;
+    }
+    if (fds[1].revents & POLLIN) {
+      if (running && stopped) {
+        running = false;
+        if (!send(client, stopReply())) {
+          break;
+        }
+      }
+    }
+    if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+      auto count = recv(client, data, sizeof(data), 0);
+      if (count <= 0) {
+        break;
+      }
+      buffer.append(data, count);
+      if (!receive(client, buffer)) {
+        break;
+      }
+    }
+  }
+  detach();
+}
+
+bool GdbStub::receive(int client, string& buffer) {
+  size_t at = 0;
+  while (at < buffer.size()) {
+    if (buffer[at] == 0x03) {
+      at++;
+      if (running) {
+        signal = 2;
+        requested = true;
+      }
+      continue;
+    }
+    // acks and anything outside packets
+    if (buffer[at] != '$') {
+      at++;
+      continue;
+    }
+    // '$' is escaped inside packets, so another one starts over
+    auto end = buffer.find_first_of("$#", at + 1);
+    if (end != string::npos && buffer[end] == '$') {
+      at = end;
+      continue;
+    }
+    if (end == string::npos || end + 2 >= buffer.size()) {
+      break;
+    }
+    auto packet = buffer.substr(at + 1, end - at - 1);
+    uint8_t sum = 0;
+    for (auto c : packet) {
+      sum += c;
+    }
+    auto high = hexDigit(buffer[end + 1]);
+    auto low = hexDigit(buffer[end + 2]);
+    at = end + 3;
+    if (high < 0 || low < 0 || ((high << 4) | low) != sum) {
+      if (acks && ::send(client, "-", 1, MSG_NOSIGNAL) != 1) {
+        return false;
+      }
+      continue;
+    }
+    if (acks && ::send(client, "+", 1, MSG_NOSIGNAL) != 1) {
+      return false;
+    }
+    if (!handle(client, packet)) {
+      return false;
+    }
+  }
+  buffer.erase(0, at);
+  // a packet longer than we said we take never completes, drop it
+  if (buffer.size() > GDB_PACKET_SIZE) {
+    buffer.clear();
+    if (acks && ::send(client, "-", 1, MSG_NOSIGNAL) != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GdbStub::handle(int client, const string& packet) {
+  if (packet.empty()) {
+    return send(client, "");
+  }
+  // all-stop clients only send ^C while running, anything else is served
+  // by pausing the CPU for the time of the packet
+  auto paused = running;
+  if (paused) {
+    running = false;
+    if (!halt()) {
+      return false;
+    }
+  }
+  auto args = packet.substr(1);
+  string reply;
+  switch (packet[0]) {
+    case '?':
+      reply = stopReply();
+      break;
+    case 'g':
+      reply = readRegisters();
+      break;
+    case 'G':
+      reply = writeRegisters(args);
+      break;
+    case 'p':
+      reply = readRegister(args);
+      break;
+    case 'P':
+      reply = writeRegister(args);
+      break;
+    case 'm':
+      reply = readMemory(args);
+      break;
+    case 'M':
+      reply = writeMemory(args);
+      break;
+    case 'Z':
+    case 'z':
+      reply = point(args, packet[0] == 'Z');
+      break;
+    case 'H':
+      reply = "OK";
+      break;
+    case 'q':
+    case 'Q':
+      reply = query(packet);
+      break;
+    case 'c':
+    case 's': {
+      size_t at = 0;
+      uint32_t address;
+      if (!args.empty()) {
+        if (!parseField(args, at, address, 0)) {
+          return send(client, "E01");
+        }
+        cpu->pc = address;
+      }
+      signal = 5;
+      if (packet[0] == 's') {
+        requested = true;
+      }
+      running = true;
+      resume();
+      // the stop reply comes once the CPU parks again
+      return true;
+    }
+    case 'D':
+      send(client, "OK");
+      return false;
+    case 'k':
+      killed = true;
+      return false;
+    default:
+      // unsupported, the empty reply
+      break;
+  }
+  auto sent = send(client, reply);
+  if (paused) {
+    running = true;
+    resume();
+  }
+  if (packet == "QStartNoAckMode") {
+    acks = false;
+  }
+  return sent;
+}
+
+string GdbStub::query(const string& packet) {
+  if (packet.compare(0, 10, "qSupported") == 0) {
+    char features[64];
+    snprintf(features, sizeof(features), "PacketSize=%x;QStartNoAckMode+",
+             GDB_PACKET_SIZE);
+    return features;
+  }
+  if (packet == "QStartNoAckMode") {
+    return "OK";
+  }
+  if (packet == "qAttached") {
+    return "1";
+  }
+  return "";
+}
+
+bool GdbStub::halt() {
+  unique_lock<mutex> guard(lock);
+  if (!parked) {
+    requested = true;
+  }
+  changed.wait(guard, [&] { return parked || closing; });
+  return parked;
+}
+
+void GdbStub::resume() {
+  lock_guard<mutex> guard(lock);
+  parked = false;
+  changed.notify_all();
+}
+
+bool GdbStub::park(Halt why) {
+  unique_lock<mutex> guard(lock);
+  requested = false;
+  if (closing || killed) {
+    return killed;
+  }
+  reason = why;
+  parked = true;
+  changed.notify_all();
+  auto written = write(wake[1], "", 1);
+  (void)written;
+  changed.wait(guard, [&] { return !parked || closing; });
+  parked = false;
+  return killed;
+}
+
+string GdbStub::stopReply() {
+  Halt why;
+  {
+    lock_guard<mutex> guard(lock);
+    why = reason;
+  }
+  string reply = "S";
+  auto& hit = debugger.getHit();
+  if (why == Halt::Request || hit.event == DebugEvent::Breakpoint) {
+    putHex8(reply, why == Halt::Request ? signal : 5);
+    return reply;
+  }
+  // watchpoints say which kind triggered and where
+  auto watched = watches.find(hit.address);
+  reply = "T05";
+  if (watched != watches.end() &&
+      watched->second == (WATCH_READ | WATCH_WRITE)) {
+    reply += "awatch:";
+  } else if (hit.event == DebugEvent::Write) {
+    reply += "watch:";
+  } else {
+    reply += "rwatch:";
+  }
+  putHex8(reply, hit.address >> 8);
+  putHex8(reply, hit.address);
+  return reply + ";";
+}
+
+string GdbStub::readRegisters() {
+  string reply;
+  for (auto value : {cpu->a, cpu->x, cpu->y, cpu->getStatus(), cpu->sp,
+                     uint8_t(cpu->pc), uint8_t(cpu->pc >> 8)}) {
+    putHex8(reply, value);
+  }
+  return reply;
+}
+
+string GdbStub::writeRegisters(const string& hex) {
+  uint8_t bytes[GDB_REGISTER_BYTES];
+  if (!parseBytes(hex, 0, GDB_REGISTER_BYTES, bytes)) {
+    return "E01";
+  }
+  cpu->a = bytes[0];
+  cpu->x = bytes[1];
+  cpu->y = bytes[2];
+  cpu->setStatus(bytes[3]);
+  cpu->sp = bytes[4];
+  cpu->pc = bytes[5] | (bytes[6] << 8);
+  return "OK";
+}
+
+string GdbStub::readRegister(const string& args) {
+  size_t at = 0;
+  uint32_t index;
+  if (!parseField(args, at, index, 0) || index >= GDB_REGISTERS) {
+    return "E01";
+  }
+  auto registers = readRegisters();
+  // every register is a byte but pc
+  return index < 5 ? registers.substr(index * 2, 2) : registers.substr(10);
+}
+
+string GdbStub::writeRegister(const string& args) {
+  size_t at = 0;
+  uint32_t index;
+  uint8_t bytes[2];
+  if (!parseField(args, at, index, '=') || index >= GDB_REGISTERS ||
+      !parseBytes(args, at, index < 5 ? 1 : 2, bytes)) {
+    return "E01";
+  }
+  switch (index) {
+    case 0:
+      cpu->a = bytes[0];
+      break;
+    case 1:
+      cpu->x = bytes[0];
+      break;
+    case 2:
+      cpu->y = bytes[0];
+      break;
+    case 3:
+      cpu->setStatus(bytes[0]);
+      break;
+    case 4:
+      cpu->sp = bytes[0];
+      break;
+    default:
+      cpu->pc = bytes[0] | (bytes[1] << 8);
+      break;
+  }
+  return "OK";
+}
+
+string GdbStub::readMemory(const string& args) {
+  size_t at = 0;
+  uint32_t address, length;
+  if (!parseField(args, at, address, ',') ||
+      !parseField(args, at, length, 0) || address > 0xffff ||
+      length > (GDB_PACKET_SIZE - 4) / 2) {
+    return "E01";
+  }
+  string reply;
+  for (uint32_t i = 0; i < length; i++) {
+    putHex8(reply, cpu->bus->read8(address + i));
+  }
+  return reply;
+}
+
+string GdbStub::writeMemory(const string& args) {
+  size_t at = 0;
+  uint32_t address, length;
+  uint8_t bytes[GDB_PACKET_SIZE / 2];
+  if (!parseField(args, at, address, ',') ||
+      !parseField(args, at, length, ':') || address > 0xffff ||
+      length > sizeof(bytes) || !parseBytes(args, at, length, bytes)) {
+    return "E01";
+  }
+  // through the bus, which has the recompiler drop what it translated from
+  // the bytes, so patched code runs once the CPU leaves the debugger too
+  for (uint32_t i = 0; i < length; i++) {
+    cpu->bus->write8(address + i, bytes[i]);
+  }
+  return "OK";
+}
+
+string GdbStub::point(const string& args, bool insert) {
+  size_t at = 0;
+  uint32_t type, address, kind;
+  if (!parseField(args, at, type, ',') ||
+      !parseField(args, at, address, ',') || !parseHex(args, at, kind) ||
+      address > 0xffff) {
+    return "E01";
+  }
+  // software and hardware breakpoints are the same bitmap
+  if (type <= 1) {
+    debugger.setBreakpoint(address, insert);
+    return "OK";
+  }
+  if (type > 4) {
+    return "";
+  }
+  // the kind of a watchpoint is its length in bytes, kept within memory
+  kind = std::max(kind, 1u);
+  if (kind > GDB_WATCH_BYTES || kind > 0x10000 - address) {
+    return "E01";
+  }
+  uint8_t mask = type == 2   ? WATCH_WRITE
+                 : type == 3 ? WATCH_READ
+                             : WATCH_READ | WATCH_WRITE;
+  for (uint32_t i = 0; i < kind; i++) {
+    uint16_t watched = address + i;
+    auto& flags = watches[watched];
+    flags = insert ? flags | mask : flags & ~mask;
+    debugger.watch(watched, flags & WATCH_READ, flags & WATCH_WRITE);
+    if (!flags) {
+      watches.erase(watched);
+    }
+  }
+  return "OK";
+}
+
+void GdbStub::detach() {
+  if (running) {
+    running = false;
+    if (!halt()) {
+      return;
+    }
+  }
+  debugger.clearBreakpoints();
+  debugger.clearWatchpoints();
+  watches.clear();
+  resume();
+}
+
+bool GdbStub::send(int client, const string& payload) {
+  uint8_t sum = 0;
+  for (auto c : payload) {
+    sum += c;
+  }
+  string packet = "$" + payload + "#";
+  putHex8(packet, sum);
+  for (size_t sent = 0; sent < packet.size();) {
+    auto count = ::send(client, packet.data() + sent, packet.size() - sent,
+                        MSG_NOSIGNAL);
+    if (count <= 0) {
+      return false;
+    }
+    sent += count;
+  }
+  return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "debugger.hpp"
+
+using std::atomic;
+using std::condition_variable;
+using std::map;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::thread;
+
+#define GDB_PACKET_SIZE 0x1000
+// longest watchpoint, one Debugger::watch() call per byte
+#define GDB_WATCH_BYTES 0x100
+// a, x, y, p and sp take a byte each, pc two, little-endian
+#define GDB_REGISTERS 6
+#define GDB_REGISTER_BYTES 7
+
+// GDB remote serial protocol stub. listenTcp() or listenUnix() start a
+// thread serving one debugger connection at a time; pass the stub as the
+// hooks of CPU::run() or Console::frame() on the emulation thread. That
+// thread only checks an atomic flag per instruction, plus the Debugger
+// breakpoints, and parks between two instructions whenever the client
+// needs the CPU halted: on a breakpoint, a watchpoint, after a single
+// step, on ^C, and while a packet reads or writes registers or memory.
+// Memory is accessed through the CPU bus. Registers are numbered a, x, y,
+// p, sp and pc.
+class GdbStub : public NoHooks {
+  GdbStub(const GdbStub&) = delete;
+  GdbStub& operator=(const GdbStub&) = delete;
+
+ public:
+  GdbStub(shared_ptr<CPU> acpu, shared_ptr<Memory> amemory);
+  ~GdbStub();
+
+  // 127.0.0.1 only, port 0 picks a free port, see getPort()
+  bool listenTcp(uint16_t port);
+  bool listenUnix(const string& path);
+  uint16_t getPort() const { return port; }
+  const string& getError() const { return error; }
+  // stops serving and lets a parked CPU go
+  void close();
+  // the client sent k, the emulation is expected to end
+  bool isKilled() const { return killed; }
+
+  void fetch(const CPU& acpu) { debugger.fetch(acpu); }
+  void instruction(uint16_t pc, uint8_t opcode, uint32_t cycles) {
+    debugger.instruction(pc, opcode, cycles);
+  }
+  bool stop(const CPU& acpu) {
+    if (debugger.stop(acpu)) {
+      return park(Halt::Debugger);
+    }
+    if (requested.load(std::memory_order_relaxed)) {
+      return park(Halt::Request);
+    }
+    return false;
+  }
+
+ private:
+  enum class Halt : uint8_t {
+    // ^C, a single step or a packet needing the CPU
+    Request,
+    // a breakpoint or watchpoint of the debugger
+    Debugger,
+  };
+
+  bool start(int afd);
+  void serve();
+  void session(int client);
+  bool halt();
+  void resume();
+  // blocks the emulation thread until resumed, true once killed
+  bool park(Halt why);
+  // handles the complete packets at the start of buffer and drops them,
+  // false when the session is over
+  bool receive(int client, string& buffer);
+  bool handle(int client, const string& packet);
+  string query(const string& packet);
+  string stopReply();
+  string readRegisters();
+  string writeRegisters(const string& hex);
+  string readRegister(const string& args);
+  string writeRegister(const string& args);
+  string readMemory(const string& args);
+  string writeMemory(const string& args);
+  string point(const string& args, bool insert);
+  void detach();
+  bool send(int client, const string& payload);
+
+  shared_ptr<CPU> cpu;
+  Debugger debugger;
+  int listener = -1;
+  // the parked emulation thread wakes the server through it
+  int wake[2] = {-1, -1};
+  string unixPath;
+  uint16_t port = 0;
+  string error;
+  thread server;
+
+  // requested is the only state the emulation thread looks at per
+  // instruction, the rest is guarded by lock
+  atomic<bool> requested{false};
+  atomic<bool> killed{false};
+  mutex lock;
+  condition_variable changed;
+  bool parked = false;
+  bool closing = false;
+  Halt reason = Halt::Request;
+
+  // server thread only
+  bool running = false;
+  // reported for a Request halt, SIGTRAP or SIGINT
+  uint8_t signal = 5;
+  bool acks = true;
+  // read and write watches set by Z2, Z3 and Z4 per address
+  map<uint16_t, uint8_t> watches;
+};
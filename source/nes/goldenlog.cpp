@@ -0,0 +1,117 @@
+#include "goldenlog.hpp"
+
+using std::getline;
+using std::ifstream;
+
+#define LOG_BYTES_COLUMN 6
+#define LOG_MNEMONIC_COLUMN 16
+
+void GoldenLog::startNestest(CPU& cpu) {
+  cpu.pc = NESTEST_START_PC;
+  cpu.sp = 0xfd;
+  cpu.setStatus(0x24);
+}
+
+bool GoldenLog::parse(const string& text, Line& line) {
+  if (text.size() < LOG_MNEMONIC_COLUMN ||
+      sscanf(text.c_str(), "%4hx", &line.pc) != 1) {
+    return false;
+  }
+  line.count = 0;
+  for (uint32_t i = 0; i < 3; i++) {
+    uint32_t byte;
+    if (text[LOG_BYTES_COLUMN + 3 * i] == ' ' ||
+        sscanf(text.c_str() + LOG_BYTES_COLUMN + 3 * i, "%2x", &byte) != 1) {
+      break;
+    }
+    line.bytes[line.count++] = byte;
+  }
+  line.unofficial = text[LOG_MNEMONIC_COLUMN - 1] == '*';
+
+  auto registers = text.find("A:", LOG_MNEMONIC_COLUMN);
+  auto cycle = text.find("CYC:", LOG_MNEMONIC_COLUMN);
+  uint32_t a, x, y, p, sp;
+  if (line.count == 0 || registers == string::npos ||
+      cycle == string::npos ||
+      sscanf(text.c_str() + registers, "A:%2x X:%2x Y:%2x P:%2x SP:%2x", &a,
+             &x, &y, &p, &sp) != 5) {
+    return false;
+  }
+  line.a = a;
+  line.x = x;
+  line.y = y;
+  line.p = p;
+  line.sp = sp;
+  line.cycle = strtoull(text.c_str() + cycle + 4, nullptr, 10);
+  return true;
+}
+
+bool GoldenLog::load(const string& path, bool official) {
+  ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  string text;
+  Line line;
+  while (getline(file, text)) {
+    if (!text.empty() && text.back() == '\r') {
+      text.pop_back();
+    }
+    if (!parse(text, line)) {
+      return false;
+    }
+    if (official && line.unofficial) {
+      break;
+    }
+    lines.push_back(line);
+  }
+  return !lines.empty();
+}
+
+bool GoldenLog::add(const string& text) {
+  Line line;
+  if (!parse(text, line)) {
+    return false;
+  }
+  lines.push_back(line);
+  return true;
+}
+
+void GoldenLog::fetch(const CPU& cpu) {
+  if (failed() || done()) {
+    return;
+  }
+  auto& line = lines[checked];
+  if (checked == 0) {
+    cycle = line.cycle;
+  }
+  auto same = cpu.pc == line.pc && cpu.a == line.a && cpu.x == line.x &&
+              cpu.y == line.y && cpu.getStatus() == line.p &&
+              cpu.sp == line.sp && cycle == line.cycle;
+  uint8_t bytes[3];
+  cpu.bus->peek(cpu.pc, bytes, line.count);
+  same = same && memcmp(bytes, line.bytes, line.count) == 0;
+  if (same) {
+    return;
+  }
+
+  char text[160];
+  auto format = [&](uint16_t pc, const uint8_t* code, uint32_t count,
+                    uint32_t a, uint32_t x, uint32_t y, uint32_t p,
+                    uint32_t sp, uint64_t cycles) {
+    auto len = snprintf(text, sizeof(text), "%04X ", pc);
+    for (uint32_t i = 0; i < count; i++) {
+      len += snprintf(text + len, sizeof(text) - len, " %02X", code[i]);
+    }
+    snprintf(text + len, sizeof(text) - len,
+             "  A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%llu", a, x, y, p, sp,
+             (unsigned long long)cycles);
+    return string(text);
+  };
+  mismatch = "instruction " + std::to_string(checked + 1) + "\n  expected " +
+             format(line.pc, line.bytes, line.count, line.a, line.x, line.y,
+                    line.p, line.sp, line.cycle) +
+             "\n  actual   " +
+             format(cpu.pc, bytes, line.count, cpu.a, cpu.x, cpu.y,
+                    cpu.getStatus(), cpu.sp, cycle);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::string;
+using std::vector;
+
+// nestest's automation mode starts at $c000 with the registers of the first
+// line of its log, where the cycle count is already 7
+#define NESTEST_START_PC 0xc000
+#define NESTEST_START_CYCLE 7
+
+// Checks a run instruction by instruction against a reference log in the
+// nestest format, e.g.
+// C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 ...
+// with SP and CYC further right. Pass it as the hooks of CPU::step() or
+// CPU::run(): before every instruction the PC, the instruction bytes and
+// the registers are compared with the next line, cycles when they follow.
+// Checking stops at the first mismatch, which is kept for the report.
+class GoldenLog : public NoHooks {
+  GoldenLog(const GoldenLog&) = delete;
+  GoldenLog& operator=(const GoldenLog&) = delete;
+
+ public:
+  struct Line {
+    uint16_t pc;
+    uint8_t bytes[3];
+    uint8_t count;
+    uint8_t a;
+    uint8_t x;
+    uint8_t y;
+    uint8_t p;
+    uint8_t sp;
+    uint64_t cycle;
+    // nestest marks unofficial opcodes with a '*' before the mnemonic
+    bool unofficial;
+  };
+
+  GoldenLog() = default;
+  ~GoldenLog() = default;
+
+  static bool parse(const string& text, Line& line);
+  // puts the CPU in the state nestest's automation mode starts from
+  static void startNestest(CPU& cpu);
+  // reads lines up to the first unofficial opcode, or all of them
+  bool load(const string& path, bool official = true);
+  bool add(const string& text);
+
+  void fetch(const CPU& cpu);
+  void instruction(uint16_t, uint8_t, uint32_t cycles) {
+    cycle += cycles;
+    checked++;
+  }
+
+  uint32_t getLines() const { return lines.size(); }
+  uint32_t getChecked() const { return checked; }
+  // cycle count reached, starting from the one on the first line
+  uint64_t getCycle() const { return cycle; }
+  bool done() const { return checked >= lines.size(); }
+  bool failed() const { return !mismatch.empty(); }
+  const string& getMismatch() const { return mismatch; }
+
+ private:
+  vector<Line> lines;
+  uint32_t checked = 0;
+  uint64_t cycle = 0;
+  string mismatch;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "pch.h"
+
+// 64-bit non-cryptographic hash after xxHash64: four independent lanes take
+// 32 bytes per round so the multiplies pipeline, then fold and avalanche.
+#define HASH_PRIME1 0x9e3779b185ebca87ull
+#define HASH_PRIME2 0xc2b2ae3d27d4eb4full
+#define HASH_PRIME3 0x165667b19e3779f9ull
+#define HASH_PRIME4 0x85ebca77c2b2ae63ull
+#define HASH_PRIME5 0x27d4eb2f165667c5ull
+
+inline uint64_t hashRotate(uint64_t value, uint32_t bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t hashRead64(const uint8_t* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint64_t hashRound(uint64_t acc, uint64_t input) {
+  return hashRotate(acc + input * HASH_PRIME2, 31) * HASH_PRIME1;
+}
+
+inline uint64_t hashMerge(uint64_t acc, uint64_t lane) {
+  return (acc ^ hashRound(0, lane)) * HASH_PRIME1 + HASH_PRIME4;
+}
+
+inline uint64_t hashMix(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= HASH_PRIME2;
+  hash ^= hash >> 29;
+  hash *= HASH_PRIME3;
+  return hash ^ (hash >> 32);
+}
+
+inline uint64_t hash64(const uint8_t* data, uint32_t len, uint64_t seed = 0) {
+  auto end = data + len;
+  uint64_t hash;
+  if (len >= 32) {
+    uint64_t lanes[4] = {seed + HASH_PRIME1 + HASH_PRIME2, seed + HASH_PRIME2,
+                         seed, seed - HASH_PRIME1};
+    for (; end - data >= 32; data += 32) {
+      for (uint32_t i = 0; i < 4; i++) {
+        lanes[i] = hashRound(lanes[i], hashRead64(data + 8 * i));
+      }
+    }
+    hash = hashRotate(lanes[0], 1) + hashRotate(lanes[1], 7) +
+           hashRotate(lanes[2], 12) + hashRotate(lanes[3], 18);
+    for (auto lane : lanes) {
+      hash = hashMerge(hash, lane);
+    }
+  } else {
+    hash = seed + HASH_PRIME5;
+  }
+  hash += len;
+  for (; end - data >= 8; data += 8) {
+    hash ^= hashRound(0, hashRead64(data));
+    hash = hashRotate(hash, 27) * HASH_PRIME1 + HASH_PRIME4;
+  }
+  for (; data < end; data++) {
+    hash ^= *data * HASH_PRIME5;
+    hash = hashRotate(hash, 11) * HASH_PRIME1;
+  }
+  return hashMix(hash);
+}
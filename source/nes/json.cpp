@@ -0,0 +1,199 @@
+#include "json.hpp"
+
+JsonReader::JsonReader(const char* atext, size_t asize)
+    : text(atext), size(asize) {}
+
+void JsonReader::whitespace() {
+  while (at < size && (text[at] == ' ' || text[at] == '\n' ||
+                       text[at] == '\r' || text[at] == '\t')) {
+    at++;
+  }
+}
+
+bool JsonReader::expect(char c) {
+  whitespace();
+  if (error || at >= size || text[at] != c) {
+    return fail();
+  }
+  at++;
+  return true;
+}
+
+bool JsonReader::atEnd() {
+  whitespace();
+  return at >= size;
+}
+
+bool JsonReader::nextKey(string& key) {
+  whitespace();
+  if (error || at >= size) {
+    return fail();
+  }
+  if (text[at] == '}') {
+    at++;
+    return false;
+  }
+  if (text[at] == ',') {
+    at++;
+  }
+  return readString(key) && expect(':');
+}
+
+bool JsonReader::nextItem() {
+  whitespace();
+  if (error || at >= size) {
+    return fail();
+  }
+  if (text[at] == ']') {
+    at++;
+    return false;
+  }
+  if (text[at] == ',') {
+    at++;
+  }
+  return true;
+}
+
+bool JsonReader::readNumber(double& value) {
+  whitespace();
+  if (error || at >= size) {
+    return fail();
+  }
+  // integers are by far the most common, take them without strtod
+  size_t end = at;
+  bool negative = text[end] == '-';
+  if (negative) {
+    end++;
+  }
+  uint64_t integer = 0;
+  auto digits = end;
+  while (end < size && text[end] >= '0' && text[end] <= '9') {
+    integer = integer * 10 + (text[end++] - '0');
+  }
+  if (end == digits) {
+    return fail();
+  }
+  auto fraction = end < size && (text[end] == '.' || text[end] == 'e' ||
+                                 text[end] == 'E');
+  if (fraction || end - digits > 18) {
+    // strtod needs a terminated string, numbers are short
+    char buffer[64];
+    auto len = std::min(size - at, sizeof(buffer) - 1);
+    memcpy(buffer, text + at, len);
+    buffer[len] = '\0';
+    char* stop;
+    value = strtod(buffer, &stop);
+    if (stop == buffer) {
+      return fail();
+    }
+    at += stop - buffer;
+    return true;
+  }
+  value = negative ? -double(integer) : double(integer);
+  at = end;
+  return true;
+}
+
+bool JsonReader::readString(string& value) {
+  if (!expect('"')) {
+    return false;
+  }
+  value.clear();
+  while (at < size && text[at] != '"') {
+    auto c = text[at++];
+    if (c != '\\') {
+      value += c;
+      continue;
+    }
+    if (at >= size) {
+      return fail();
+    }
+    switch (c = text[at++]) {
+      case 'b':
+        value += '\b';
+        break;
+      case 'f':
+        value += '\f';
+        break;
+      case 'n':
+        value += '\n';
+        break;
+      case 'r':
+        value += '\r';
+        break;
+      case 't':
+        value += '\t';
+        break;
+      case 'u': {
+        // only code points below 0x80 are kept as is
+        if (size - at < 4) {
+          return fail();
+        }
+        auto code = strtoul(string(text + at, 4).c_str(), nullptr, 16);
+        value += code < 0x80 ? char(code) : '?';
+        at += 4;
+        break;
+      }
+      default:
+        value += c;
+    }
+  }
+  return expect('"');
+}
+
+bool JsonReader::readBool(bool& value) {
+  whitespace();
+  if (!error && size - at >= 4 && memcmp(text + at, "true", 4) == 0) {
+    value = true;
+    at += 4;
+    return true;
+  }
+  if (!error && size - at >= 5 && memcmp(text + at, "false", 5) == 0) {
+    value = false;
+    at += 5;
+    return true;
+  }
+  return fail();
+}
+
+bool JsonReader::skip() {
+  whitespace();
+  if (error || at >= size) {
+    return fail();
+  }
+  switch (text[at]) {
+    case '{': {
+      beginObject();
+      string key;
+      while (nextKey(key)) {
+        skip();
+      }
+      return !error;
+    }
+    case '[':
+      beginArray();
+      while (nextItem()) {
+        skip();
+      }
+      return !error;
+    case '"': {
+      string value;
+      return readString(value);
+    }
+    case 't':
+    case 'f': {
+      bool value;
+      return readBool(value);
+    }
+    case 'n':
+      if (size - at >= 4 && memcmp(text + at, "null", 4) == 0) {
+        at += 4;
+        return true;
+      }
+      return fail();
+    default: {
+      double value;
+      return readNumber(value);
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pch.h"
+
+using std::string;
+
+// Pull parser over a JSON text held in memory. Values are read in document
+// order without building a tree, so multi-megabyte files of test vectors or
+// benchmark results cost no more than the text itself. Separators are
+// handled leniently: nextKey() and nextItem() skip one comma if present.
+// Any error sets failed() and makes every later call return false.
+class JsonReader {
+  JsonReader(const JsonReader&) = delete;
+  JsonReader& operator=(const JsonReader&) = delete;
+
+ public:
+  JsonReader(const char* atext, size_t asize);
+  ~JsonReader() = default;
+
+  bool beginObject() { return expect('{'); }
+  bool beginArray() { return expect('['); }
+  // inside an object: reads the next key and its colon, false at the end of
+  // the object, which is consumed
+  bool nextKey(string& key);
+  // inside an array: true when another value follows, false at the end of
+  // the array, which is consumed
+  bool nextItem();
+
+  bool readNumber(double& value);
+  bool readString(string& value);
+  bool readBool(bool& value);
+  // skips the next value whatever its type
+  bool skip();
+
+  bool failed() const { return error; }
+  // true once only whitespace is left
+  bool atEnd();
+
+ private:
+  void whitespace();
+  bool expect(char c);
+  bool fail() {
+    error = true;
+    return false;
+  }
+
+  const char* text;
+  size_t size;
+  size_t at = 0;
+  bool error = false;
+};
@@ -0,0 +1,453 @@
+#include "lockstep.hpp"
+
+template <uint32_t N>
+Lockstep<N>::Lockstep() : ram(N * LANE_RAM_SIZE) {
+  static const char* names[] = {
+      "ADC", "AND", "ASL", "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL",
+      "BRK", "BVC", "BVS", "CLC", "CLD", "CLI", "CLV", "CMP", "CPX", "CPY",
+      "DEC", "DEX", "DEY", "EOR", "INC", "INX", "INY", "JMP", "JSR", "LDA",
+      "LDX", "LDY", "LSR", "NOP", "ORA", "PHA", "PHP", "PLA", "PLP", "ROL",
+      "ROR", "RTI", "RTS", "SBC", "SEC", "SED", "SEI", "STA", "STX", "STY",
+      "TAX", "TAY", "TSX", "TXA", "TXS", "TYA", "XXX"};
+  static const Kernel byOp[] = {
+      &Lockstep::kernel<Op::ADC>, &Lockstep::kernel<Op::AND>,
+      &Lockstep::kernel<Op::ASL>, &Lockstep::kernel<Op::BCC>,
+      &Lockstep::kernel<Op::BCS>, &Lockstep::kernel<Op::BEQ>,
+      &Lockstep::kernel<Op::BIT>, &Lockstep::kernel<Op::BMI>,
+      &Lockstep::kernel<Op::BNE>, &Lockstep::kernel<Op::BPL>,
+      &Lockstep::kernel<Op::BRK>, &Lockstep::kernel<Op::BVC>,
+      &Lockstep::kernel<Op::BVS>, &Lockstep::kernel<Op::CLC>,
+      &Lockstep::kernel<Op::CLD>, &Lockstep::kernel<Op::CLI>,
+      &Lockstep::kernel<Op::CLV>, &Lockstep::kernel<Op::CMP>,
+      &Lockstep::kernel<Op::CPX>, &Lockstep::kernel<Op::CPY>,
+      &Lockstep::kernel<Op::DEC>, &Lockstep::kernel<Op::DEX>,
+      &Lockstep::kernel<Op::DEY>, &Lockstep::kernel<Op::EOR>,
+      &Lockstep::kernel<Op::INC>, &Lockstep::kernel<Op::INX>,
+      &Lockstep::kernel<Op::INY>, &Lockstep::kernel<Op::JMP>,
+      &Lockstep::kernel<Op::JSR>, &Lockstep::kernel<Op::LDA>,
+      &Lockstep::kernel<Op::LDX>, &Lockstep::kernel<Op::LDY>,
+      &Lockstep::kernel<Op::LSR>, &Lockstep::kernel<Op::NOP>,
+      &Lockstep::kernel<Op::ORA>, &Lockstep::kernel<Op::PHA>,
+      &Lockstep::kernel<Op::PHP>, &Lockstep::kernel<Op::PLA>,
+      &Lockstep::kernel<Op::PLP>, &Lockstep::kernel<Op::ROL>,
+      &Lockstep::kernel<Op::ROR>, &Lockstep::kernel<Op::RTI>,
+      &Lockstep::kernel<Op::RTS>, &Lockstep::kernel<Op::SBC>,
+      &Lockstep::kernel<Op::SEC>, &Lockstep::kernel<Op::SED>,
+      &Lockstep::kernel<Op::SEI>, &Lockstep::kernel<Op::STA>,
+      &Lockstep::kernel<Op::STX>, &Lockstep::kernel<Op::STY>,
+      &Lockstep::kernel<Op::TAX>, &Lockstep::kernel<Op::TAY>,
+      &Lockstep::kernel<Op::TSX>, &Lockstep::kernel<Op::TXA>,
+      &Lockstep::kernel<Op::TXS>, &Lockstep::kernel<Op::TYA>,
+      &Lockstep::kernel<Op::XXX>};
+  // decode the scalar table once so both cores share one definition of every
+  // opcode's mode, length and timing
+  auto table = CPU::opcodeTable();
+  for (uint32_t opcode = 0; opcode <= 0xff; opcode++) {
+    auto& info = table[opcode];
+    decoded[opcode] = {CPU::getAddressing(info), info.bytes, info.cycles,
+                       info.penality};
+    kernels[opcode] = &Lockstep::kernel<Op::XXX>;
+    for (uint32_t op = 0; op < uint32_t(Op::Count); op++) {
+      if (strcmp(info.mnemonic, names[op]) == 0) {
+        kernels[opcode] = byOp[op];
+      }
+    }
+  }
+  for (uint32_t lane = 0; lane < N; lane++) {
+    setStatus(lane, 0x24);
+    sp[lane] = 0xff;
+  }
+}
+
+template <uint32_t N>
+void Lockstep<N>::load(uint16_t addr, const uint8_t* data, uint32_t len) {
+  auto copy = std::min(len, uint32_t(LANE_RAM_SIZE - addr));
+  for (uint32_t lane = 0; lane < N; lane++) {
+    memcpy(getRam(lane) + addr, data, copy);
+  }
+}
+
+template <uint32_t N>
+void Lockstep<N>::reset() {
+  for (uint32_t lane = 0; lane < N; lane++) {
+    a[lane] = 0;
+    x[lane] = 0;
+    y[lane] = 0;
+    setStatus(lane, 0x20);
+    sp[lane] = 0xfd;
+    pc[lane] = read16(lane, RESET_PROC_ADDR);
+  }
+}
+
+template <uint32_t N>
+void Lockstep<N>::setStatus(uint32_t lane, uint8_t value) {
+  p[lane] = value;
+  carry[lane] = value & 0x01;
+  zResult[lane] = ~value & 0x02;
+  nResult[lane] = value;
+  vResult[lane] = value << 1;
+}
+
+template <uint32_t N>
+void Lockstep<N>::step() {
+  uint8_t active[N];
+  memset(active, 1, N);
+  step(active);
+}
+
+template <uint32_t N>
+void Lockstep<N>::run(uint32_t budget) {
+  memset(cycles, 0, sizeof(cycles));
+  while (true) {
+    uint8_t active[N];
+    uint8_t any = 0;
+    for (uint32_t l = 0; l < N; l++) {
+      active[l] = cycles[l] < budget;
+      any |= active[l];
+    }
+    if (!any) {
+      break;
+    }
+    step(active);
+  }
+}
+
+template <uint32_t N>
+void Lockstep<N>::step(const uint8_t* active) {
+  uint8_t opcodes[N];
+  uint64_t present[4] = {};
+  for (uint32_t l = 0; l < N; l++) {
+    opcodes[l] = read8(l, pc[l]);
+    if (active[l]) {
+      present[opcodes[l] >> 6] |= uint64_t(1) << (opcodes[l] & 0x3f);
+    }
+  }
+
+  // one pass per distinct opcode, usually one or two when lanes run the
+  // same program
+  for (uint32_t word = 0; word < 4; word++) {
+    while (present[word]) {
+      auto opcode = (word << 6) | __builtin_ctzll(present[word]);
+      present[word] &= present[word] - 1;
+      uint8_t mask[N];
+      for (uint32_t l = 0; l < N; l++) {
+        mask[l] = active[l] & (opcodes[l] == opcode);
+      }
+      (this->*kernels[opcode])(decoded[opcode], mask);
+    }
+  }
+}
+
+// computed for every lane, masked lanes only ever read
+template <uint32_t N>
+void Lockstep<N>::resolve(Addressing mode) {
+  switch (mode) {
+    case Addressing::Abs:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = read16(l, pc[l] + 1);
+      }
+      break;
+    case Addressing::Absx:
+    case Addressing::Absy: {
+      auto index = mode == Addressing::Absx ? x : y;
+      for (uint32_t l = 0; l < N; l++) {
+        uint16_t base = read16(l, pc[l] + 1);
+        address[l] = base + index[l];
+        penality[l] = (base & 0xff00) != (address[l] & 0xff00);
+      }
+      break;
+    }
+    case Addressing::Imm:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = pc[l] + 1;
+      }
+      break;
+    case Addressing::Ind:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = read16bug(l, read16(l, pc[l] + 1));
+      }
+      break;
+    case Addressing::Indx:
+      for (uint32_t l = 0; l < N; l++) {
+        uint16_t ptr = uint16_t(read8(l, pc[l] + 1)) + x[l];
+        address[l] = read16bug(l, ptr);
+      }
+      break;
+    case Addressing::Indy:
+      for (uint32_t l = 0; l < N; l++) {
+        uint16_t base = read16bug(l, read8(l, pc[l] + 1));
+        address[l] = base + y[l];
+        penality[l] = (base & 0xff00) != (address[l] & 0xff00);
+      }
+      break;
+    case Addressing::Rel:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = pc[l] + 2 + int8_t(read8(l, pc[l] + 1));
+      }
+      break;
+    case Addressing::Zp:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = read8(l, pc[l] + 1);
+      }
+      break;
+    case Addressing::Zpx:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = (read8(l, pc[l] + 1) + x[l]) & 0x00ff;
+      }
+      break;
+    case Addressing::Zpy:
+      for (uint32_t l = 0; l < N; l++) {
+        address[l] = (read8(l, pc[l] + 1) + y[l]) & 0x00ff;
+      }
+      break;
+    case Addressing::Acc:
+    case Addressing::Imp:
+      break;
+  }
+}
+
+template <uint32_t N>
+template <typename Lockstep<N>::Op O>
+void Lockstep<N>::kernel(const Decoded& info, const uint8_t* mask) {
+  resolve(info.mode);
+  auto accumulator = info.mode == Addressing::Acc;
+  auto memory = !accumulator && info.mode != Addressing::Imp &&
+                info.mode != Addressing::Rel;
+
+  for (uint32_t l = 0; l < N; l++) {
+    uint8_t m = mask[l];
+    auto blend = [m](auto& r, auto value) { r = m ? value : r; };
+    auto zn = [&](uint8_t value) {
+      blend(zResult[l], value);
+      blend(nResult[l], value);
+    };
+    auto operand = [&]() -> uint8_t {
+      return accumulator ? a[l] : memory ? read8(l, address[l]) : 0;
+    };
+    auto store = [&](uint8_t value) {
+      if (accumulator) {
+        blend(a[l], value);
+      } else if (memory) {
+        write8(l, address[l], value, m);
+      }
+    };
+    auto push8 = [&](uint8_t value) {
+      write8(l, STACK_PAGE + sp[l], value, m);
+      sp[l] -= m;
+    };
+    auto pop8 = [&]() -> uint8_t {
+      sp[l] += m;
+      return read8(l, STACK_PAGE + sp[l]);
+    };
+    auto branch = [&](bool condition) {
+      auto taken = m & condition;
+      auto page = pc[l] & 0xff00;
+      blend(pc[l], taken ? address[l] : pc[l]);
+      cycles[l] += taken + (taken & (page != (address[l] & 0xff00)));
+    };
+    auto adc = [&](uint8_t value) {
+      uint16_t sum = uint16_t(a[l]) + value + carry[l];
+      uint8_t result = sum & 0x00ff;
+      blend(carry[l], uint8_t(sum >> 8));
+      blend(vResult[l], uint8_t((result ^ a[l]) & (result ^ value)));
+      blend(a[l], result);
+      zn(result);
+    };
+    auto compare = [&](uint8_t r) {
+      uint16_t difference = uint16_t(r) - operand();
+      blend(carry[l], uint8_t((~difference >> 8) & 0x01));
+      zn(difference);
+    };
+    auto status = [&]() { return getStatus(l); };
+    auto restore = [&](uint8_t value) {
+      blend(p[l], value);
+      blend(carry[l], uint8_t(value & 0x01));
+      blend(zResult[l], uint8_t(~value & 0x02));
+      blend(nResult[l], value);
+      blend(vResult[l], uint8_t(value << 1));
+    };
+
+    cycles[l] += m ? info.cycles : 0;
+    pc[l] += m ? info.bytes : 0;
+    auto penalty = m & info.penality & penality[l];
+
+    if constexpr (O == Op::ADC) {
+      adc(operand());
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::SBC) {
+      adc(~operand());
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::AND) {
+      auto value = uint8_t(a[l] & operand());
+      blend(a[l], value);
+      zn(value);
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::EOR) {
+      auto value = uint8_t(a[l] ^ operand());
+      blend(a[l], value);
+      zn(value);
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::ORA) {
+      auto value = uint8_t(a[l] | operand());
+      blend(a[l], value);
+      zn(value);
+    } else if constexpr (O == Op::ASL) {
+      auto value = operand();
+      blend(carry[l], uint8_t(value >> 7));
+      value <<= 1;
+      zn(value);
+      store(value);
+    } else if constexpr (O == Op::LSR) {
+      auto value = operand();
+      blend(carry[l], uint8_t(value & 0x01));
+      value >>= 1;
+      zn(value);
+      store(value);
+    } else if constexpr (O == Op::ROL) {
+      auto value = operand();
+      uint8_t result = (value << 1) | carry[l];
+      blend(carry[l], uint8_t(value >> 7));
+      zn(result);
+      store(result);
+    } else if constexpr (O == Op::ROR) {
+      auto value = operand();
+      uint8_t result = (carry[l] << 7) | (value >> 1);
+      blend(carry[l], uint8_t(value & 0x01));
+      zn(result);
+      store(result);
+    } else if constexpr (O == Op::BIT) {
+      auto value = operand();
+      blend(zResult[l], uint8_t(a[l] & value));
+      blend(nResult[l], value);
+      blend(vResult[l], uint8_t(value << 1));
+    } else if constexpr (O == Op::BCC) {
+      branch(!carry[l]);
+    } else if constexpr (O == Op::BCS) {
+      branch(carry[l]);
+    } else if constexpr (O == Op::BEQ) {
+      branch(zResult[l] == 0);
+    } else if constexpr (O == Op::BNE) {
+      branch(zResult[l] != 0);
+    } else if constexpr (O == Op::BMI) {
+      branch(nResult[l] & 0x80);
+    } else if constexpr (O == Op::BPL) {
+      branch(!(nResult[l] & 0x80));
+    } else if constexpr (O == Op::BVC) {
+      branch(!(vResult[l] & 0x80));
+    } else if constexpr (O == Op::BVS) {
+      branch(vResult[l] & 0x80);
+    } else if constexpr (O == Op::BRK) {
+      push8(pc[l] >> 8);
+      push8(pc[l] & 0xff);
+      blend(pc[l], read16(l, IRQ_PROC_ADDR));
+      push8(status() | 0x30);
+      blend(p[l], uint8_t(p[l] | 0x04));
+    } else if constexpr (O == Op::CLC) {
+      blend(carry[l], uint8_t(0));
+    } else if constexpr (O == Op::SEC) {
+      blend(carry[l], uint8_t(1));
+    } else if constexpr (O == Op::CLD) {
+      blend(p[l], uint8_t(p[l] & ~0x08));
+    } else if constexpr (O == Op::SED) {
+      blend(p[l], uint8_t(p[l] | 0x08));
+    } else if constexpr (O == Op::CLI) {
+      blend(p[l], uint8_t(p[l] & ~0x04));
+    } else if constexpr (O == Op::SEI) {
+      blend(p[l], uint8_t(p[l] | 0x04));
+    } else if constexpr (O == Op::CLV) {
+      blend(vResult[l], uint8_t(0));
+    } else if constexpr (O == Op::CMP) {
+      compare(a[l]);
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::CPX) {
+      compare(x[l]);
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::CPY) {
+      compare(y[l]);
+      cycles[l] += penalty;
+    } else if constexpr (O == Op::DEC) {
+      uint8_t value = operand() - 1;
+      zn(value);
+      store(value);
+    } else if constexpr (O == Op::INC) {
+      uint8_t value = operand() + 1;
+      zn(value);
+      store(value);
+    } else if constexpr (O == Op::DEX) {
+      blend(x[l], uint8_t(x[l] - 1));
+      zn(x[l]);
+    } else if constexpr (O == Op::DEY) {
+      blend(y[l], uint8_t(y[l] - 1));
+      zn(y[l]);
+    } else if constexpr (O == Op::INX) {
+      blend(x[l], uint8_t(x[l] + 1));
+      zn(x[l]);
+    } else if constexpr (O == Op::INY) {
+      blend(y[l], uint8_t(y[l] + 1));
+      zn(y[l]);
+    } else if constexpr (O == Op::JMP) {
+      blend(pc[l], address[l]);
+    } else if constexpr (O == Op::JSR) {
+      push8(pc[l] >> 8);
+      push8(pc[l] & 0xff);
+      blend(pc[l], address[l]);
+    } else if constexpr (O == Op::LDA) {
+      auto value = operand();
+      blend(a[l], value);
+      zn(value);
+    } else if constexpr (O == Op::LDX) {
+      auto value = operand();
+      blend(x[l], value);
+      zn(value);
+    } else if constexpr (O == Op::LDY) {
+      auto value = operand();
+      blend(y[l], value);
+      zn(value);
+    } else if constexpr (O == Op::PHA) {
+      push8(a[l]);
+    } else if constexpr (O == Op::PHP) {
+      push8(status() | 0x30);
+    } else if constexpr (O == Op::PLA) {
+      auto value = pop8();
+      blend(a[l], value);
+      zn(value);
+    } else if constexpr (O == Op::PLP) {
+      restore((pop8() & 0xef) | 0x20);
+    } else if constexpr (O == Op::RTI) {
+      restore((pop8() & 0xef) | 0x20);
+      uint16_t lo = pop8();
+      uint16_t hi = pop8();
+      blend(pc[l], uint16_t((hi << 8) | lo));
+    } else if constexpr (O == Op::RTS) {
+      uint16_t lo = pop8();
+      uint16_t hi = pop8();
+      blend(pc[l], uint16_t((hi << 8) | lo));
+    } else if constexpr (O == Op::STA) {
+      store(a[l]);
+    } else if constexpr (O == Op::STX) {
+      store(x[l]);
+    } else if constexpr (O == Op::STY) {
+      store(y[l]);
+    } else if constexpr (O == Op::TAX) {
+      blend(x[l], a[l]);
+      zn(a[l]);
+    } else if constexpr (O == Op::TAY) {
+      blend(y[l], a[l]);
+      zn(a[l]);
+    } else if constexpr (O == Op::TSX) {
+      blend(x[l], sp[l]);
+      zn(sp[l]);
+    } else if constexpr (O == Op::TXA) {
+      blend(a[l], x[l]);
+      zn(x[l]);
+    } else if constexpr (O == Op::TXS) {
+      blend(sp[l], x[l]);
+    } else if constexpr (O == Op::TYA) {
+      blend(a[l], y[l]);
+      zn(y[l]);
+    }
+  }
+}
+
+template class Lockstep<8>;
+template class Lockstep<16>;
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::vector;
+
+#define LANE_RAM_SIZE 0x10000
+
+// Steps N independent 6502s, each with its own 64 KB of RAM, in lockstep.
+// Registers are laid out as one array per register so every instruction is a
+// loop over lanes with fixed trip count that the compiler can vectorize.
+// Lanes at different PCs are grouped by opcode: each opcode present in a step
+// runs once over all lanes with the others masked out, register updates are
+// blends and only stores and pushes branch on the mask. Behaviour, quirks and
+// cycle counts match the scalar interpreter instruction for instruction.
+template <uint32_t N>
+class Lockstep {
+  Lockstep(const Lockstep&) = delete;
+  Lockstep& operator=(const Lockstep&) = delete;
+
+ public:
+  Lockstep();
+  ~Lockstep() = default;
+
+  static constexpr uint32_t lanes = N;
+
+  uint8_t* getRam(uint32_t lane) { return &ram[lane * LANE_RAM_SIZE]; }
+  void load(uint16_t addr, const uint8_t* data, uint32_t len);
+  void reset();
+  // executes one instruction on every lane
+  void step();
+  // runs each lane by whole instructions until it has spent budget cycles,
+  // cycles holds what each lane actually spent afterwards
+  void run(uint32_t budget);
+
+  uint8_t getStatus(uint32_t lane) const {
+    return (p[lane] & 0x3c) | carry[lane] | ((zResult[lane] == 0) << 1) |
+           ((vResult[lane] & 0x80) >> 1) | (nResult[lane] & 0x80);
+  }
+  void setStatus(uint32_t lane, uint8_t value);
+
+  alignas(64) uint8_t a[N] = {};
+  alignas(64) uint8_t x[N] = {};
+  alignas(64) uint8_t y[N] = {};
+  alignas(64) uint8_t p[N] = {};
+  alignas(64) uint8_t carry[N] = {};
+  alignas(64) uint8_t zResult[N] = {};
+  alignas(64) uint8_t nResult[N] = {};
+  alignas(64) uint8_t vResult[N] = {};
+  alignas(64) uint8_t sp[N] = {};
+  alignas(64) uint16_t pc[N] = {};
+  alignas(64) uint32_t cycles[N] = {};
+
+ private:
+  enum class Op : uint8_t {
+    ADC, AND, ASL, BCC, BCS, BEQ, BIT, BMI, BNE, BPL, BRK, BVC, BVS, CLC, CLD,
+    CLI, CLV, CMP, CPX, CPY, DEC, DEX, DEY, EOR, INC, INX, INY, JMP, JSR, LDA,
+    LDX, LDY, LSR, NOP, ORA, PHA, PHP, PLA, PLP, ROL, ROR, RTI, RTS, SBC, SEC,
+    SED, SEI, STA, STX, STY, TAX, TAY, TSX, TXA, TXS, TYA, XXX, Count,
+  };
+
+  struct Decoded {
+    Addressing mode;
+    uint8_t bytes;
+    uint8_t cycles;
+    uint8_t penality;
+  };
+
+  using Kernel = void (Lockstep::*)(const Decoded&, const uint8_t*);
+
+  uint8_t read8(uint32_t lane, uint16_t addr) const {
+    return ram[lane * LANE_RAM_SIZE + addr];
+  }
+  uint16_t read16(uint32_t lane, uint16_t addr) const {
+    return read8(lane, addr) | (read8(lane, addr + 1) << 8);
+  }
+  uint16_t read16bug(uint32_t lane, uint16_t addr) const {
+    auto baddr = (addr & 0xff00) | ((addr + 1) & 0x00ff);
+    return read8(lane, addr) | (read8(lane, baddr) << 8);
+  }
+  void write8(uint32_t lane, uint16_t addr, uint8_t value, uint8_t m) {
+    if (m) {
+      ram[lane * LANE_RAM_SIZE + addr] = value;
+    }
+  }
+
+  void step(const uint8_t* active);
+  void resolve(Addressing mode);
+  template <Op O>
+  void kernel(const Decoded& info, const uint8_t* mask);
+
+  vector<uint8_t> ram;
+  alignas(64) uint16_t address[N] = {};
+  alignas(64) uint8_t penality[N] = {};
+  Decoded decoded[256];
+  Kernel kernels[256];
+};
+
+extern template class Lockstep<8>;
+extern template class Lockstep<16>;
@@ -1,37 +1,232 @@
 #include "memory.hpp"
 
+using std::make_shared;
+
+#define WATCH_READ 0x01
+#define WATCH_WRITE 0x02
+
 Memory::Memory(uint16_t sa, uint16_t ea)
     : start(sa), end(ea), size(ea - sa + 1) {
-  memory = (uint8_t*)calloc(size, sizeof(uint8_t));
+  auto count = getPages();
+  pages.resize(count);
+  readPages.resize(count);
+  writePages.resize(count);
+  codePages.resize(count);
+  for (uint32_t page = 0; page < count; page++) {
+    pages[page] = make_shared<Page>();
+    readPages[page] = writePages[page] = pages[page]->data();
+  }
+#ifdef DIRTY_TRACKING
+  generations.resize(count);
+#endif
 }
 
-Memory::~Memory() { free(memory); }
+Memory::~Memory() {}
 
 uint8_t Memory::read8(uint16_t addr) {
   auto offset = index(addr);
-  return memory[offset];
+  auto data = readPages[offset >> 8];
+  return data ? data[offset & 0xff] : watchedRead(addr);
 }
 
 void Memory::write8(uint16_t addr, uint8_t value) {
   auto offset = index(addr);
-  memory[offset] = value;
+  auto data = writePages[offset >> 8];
+  if (!data) {
+    watchedWrite(addr, value);
+    return;
+  }
+  data[offset & 0xff] = value;
+#ifdef DIRTY_TRACKING
+  generations[offset >> 8] = generation;
+#endif
+}
+
+uint8_t Memory::watchedRead(uint16_t addr) {
+  auto offset = index(addr);
+  auto value = (*pages[offset >> 8])[offset & 0xff];
+  if (watcher && (watches[offset] & WATCH_READ)) {
+    watcher(addr, value, false);
+  }
+  return value;
+}
+
+// also the copy-on-write path of pages shared with a fork
+void Memory::watchedWrite(uint16_t addr, uint8_t value) {
+  auto offset = index(addr);
+  if (codePages[offset >> 8]) {
+    codeWritten(offset, 1);
+  }
+  writable(offset >> 8)[offset & 0xff] = value;
+#ifdef DIRTY_TRACKING
+  generations[offset >> 8] = generation;
+#endif
+  if (watcher && !watches.empty() && (watches[offset] & WATCH_WRITE)) {
+    watcher(addr, value, true);
+  }
+}
+
+void Memory::watch(uint16_t addr, bool read, bool write) {
+  auto offset = index(addr);
+  if (watches.empty()) {
+    watches.resize(size);
+    watchedPages.resize(getPages());
+  }
+  watches[offset] = (read ? WATCH_READ : 0) | (write ? WATCH_WRITE : 0);
+  route(offset >> 8);
+}
+
+void Memory::watchCode(uint16_t addr) {
+  auto page = index(addr) >> 8;
+  codePages[page] = 1;
+  writePages[page] = nullptr;
+}
+
+// the write table entry comes back with the next write through writable()
+void Memory::codeWritten(uint32_t offset, uint32_t len) {
+  codePages[offset >> 8] = 0;
+  if (codeWatcher) {
+    codeWatcher(offset, len);
+  }
+}
+
+// reports the bytes between the first and the last one set() changes
+void Memory::codeChanged(uint32_t offset, const uint8_t* data, uint32_t len) {
+  auto old = pages[offset >> 8]->data() + (offset & 0xff);
+  uint32_t first = 0;
+  while (first < len && old[first] == data[first]) {
+    first++;
+  }
+  if (first == len) {
+    return;
+  }
+  auto last = len - 1;
+  while (old[last] == data[last]) {
+    last--;
+  }
+  codeWritten(offset + first, last - first + 1);
+}
+
+void Memory::clearWatches() {
+  watches.clear();
+  watchedPages.clear();
+  for (uint32_t page = 0; page < getPages(); page++) {
+    readPages[page] = pages[page]->data();
+  }
+}
+
+void Memory::route(uint32_t page) {
+  auto first = page << 8;
+  auto last = std::min(size, first + MEMORY_PAGE_SIZE);
+  uint8_t flags = 0;
+  for (auto offset = first; offset < last; offset++) {
+    flags |= watches[offset];
+  }
+  watchedPages[page] = flags;
+  readPages[page] = flags & WATCH_READ ? nullptr : pages[page]->data();
+  if (flags & WATCH_WRITE) {
+    writePages[page] = nullptr;
+  }
 }
 
 void Memory::set(uint16_t addr, const vector<uint8_t>& data) {
+  set(addr, data.data(), data.size());
+}
+
+void Memory::set(uint16_t addr, const uint8_t* data, const uint32_t len) {
   auto offset = index(addr);
   if (offset < size) {
     auto available = size - offset;
-    auto len = data.size();
     auto copy = len > available ? available : len;
-    memcpy(memory + offset, data.data(), copy);
+    touch(offset, copy);
+    for (uint32_t done = 0; done < copy;) {
+      auto at = offset + done;
+      auto chunk = std::min(copy - done, uint32_t(MEMORY_PAGE_SIZE) - (at & 0xff));
+      auto page = at >> 8;
+      if (codePages[page]) {
+        codeChanged(at, data + done, chunk);
+      }
+      memcpy(writable(page) + (at & 0xff), data + done, chunk);
+      done += chunk;
+    }
   }
 }
 
-void Memory::set(uint16_t addr, const uint8_t* data, const uint32_t len) {
+void Memory::get(uint16_t addr, uint8_t* data, const uint32_t len) {
   auto offset = index(addr);
   if (offset < size) {
     auto available = size - offset;
     auto copy = len > available ? available : len;
-    memcpy(memory + offset, data, copy);
+    for (uint32_t done = 0; done < copy;) {
+      auto at = offset + done;
+      auto chunk = std::min(copy - done, uint32_t(MEMORY_PAGE_SIZE) - (at & 0xff));
+      memcpy(data + done, pages[at >> 8]->data() + (at & 0xff), chunk);
+      done += chunk;
+    }
+  }
+}
+
+void Memory::clear() {
+  for (uint32_t page = 0; page < getPages(); page++) {
+    if (codePages[page]) {
+      codeWritten(page << 8, std::min(size - (page << 8), 0x100u));
+    }
+    memset(writable(page), 0, MEMORY_PAGE_SIZE);
+  }
+  touch(0, size);
+}
+
+shared_ptr<Memory> Memory::fork() {
+  auto child = shared_ptr<Memory>(new Memory(this));
+  // the parent gives up write access too, whoever writes first copies;
+  // forking again only reads the table, so a parent nobody writes to can
+  // be forked from several threads at once
+  for (auto& page : writePages) {
+    if (page) {
+      page = nullptr;
+    }
+  }
+  return child;
+}
+
+Memory::Memory(const Memory* parent)
+    : start(parent->start),
+      end(parent->end),
+      size(parent->size),
+      pages(parent->pages),
+      readPages(parent->pages.size()),
+      writePages(parent->pages.size(), nullptr),
+      codePages(parent->pages.size()) {
+  // watches and code watches stay with the parent
+  for (uint32_t page = 0; page < pages.size(); page++) {
+    readPages[page] = pages[page]->data();
+  }
+#ifdef DIRTY_TRACKING
+  generation = parent->generation;
+  generations = parent->generations;
+#endif
+}
+
+uint8_t* Memory::unshare(uint32_t page) {
+  auto& shared = pages[page];
+  if (shared.use_count() > 1) {
+    shared = make_shared<Page>(*shared);
+    if (readPages[page]) {
+      readPages[page] = shared->data();
+    }
+  }
+  auto watched = codePages[page] ||
+                 (!watchedPages.empty() && (watchedPages[page] & WATCH_WRITE));
+  return watched ? shared->data() : writePages[page] = shared->data();
+}
+
+void Memory::touch([[maybe_unused]] uint32_t offset,
+                   [[maybe_unused]] uint32_t len) {
+#ifdef DIRTY_TRACKING
+  if (len > 0) {
+    for (auto page = offset >> 8; page <= (offset + len - 1) >> 8; page++) {
+      generations[page] = generation;
+    }
   }
+#endif
 }
@@ -2,8 +2,21 @@
 
 #include "device.hpp"
 
+using std::array;
+using std::function;
+using std::shared_ptr;
 using std::vector;
 
+#define MEMORY_PAGE_SIZE 0x100
+
+// RAM split into 256 byte pages reached through a page table. Pages are
+// reference counted so fork() can share all of them with a child; shared
+// pages have no entry in the write table, so the first write to one takes
+// the slow path, copies the page and installs the private copy. Watched
+// pages have no entry in the tables they are watched for either, so the
+// accesses to them alone go through the slow path calling the watcher.
+// Pages holding translated code are left out of the write table the same
+// way, so whoever writes to them first calls the code watcher.
 class Memory : public Device {
   Memory(const Memory&) = delete;
   Memory& operator=(const Memory&) = delete;
@@ -16,15 +29,79 @@ class Memory : public Device {
 
   void set(uint16_t addr, const vector<uint8_t>& data);
   void set(uint16_t addr, const uint8_t* data, const uint32_t len);
+  void get(uint16_t addr, uint8_t* data, const uint32_t len);
+  void clear();
+  // copy-on-write clone, costs one page table copy whatever the size
+  shared_ptr<Memory> fork();
 
   uint32_t getSize() const { return size; }
+  // read-only view of one page, valid until the next write or fork
+  const uint8_t* getPage(uint32_t page) const { return pages[page]->data(); }
+
+  // Watchpoints, called with the address as given to read8() or write8()
+  // and the value read or written. set() and get() are not watched.
+  using Watcher = function<void(uint16_t addr, uint8_t value, bool write)>;
+  void setWatcher(Watcher awatcher) { watcher = awatcher; }
+  void watch(uint16_t addr, bool read, bool write);
+  void clearWatches();
+
+  // Code watches, for the recompiler: the first write to a watched page,
+  // through write8(), set() or clear(), drops the watch and calls the code
+  // watcher with the offset and length of the bytes written. set() only
+  // reports the bytes it changes, and nothing when it changes none.
+  using CodeWatcher = function<void(uint32_t offset, uint32_t len)>;
+  void setCodeWatcher(CodeWatcher awatcher) { codeWatcher = awatcher; }
+  void watchCode(uint16_t addr);
+
+  // Dirty page tracking, built with DIRTY_TRACKING. Every 256 byte page
+  // records the generation it was last written in; a checkpoint starts a new
+  // generation so each consumer can keep its own. Without tracking every page
+  // is reported dirty and the write path is untouched.
+#ifdef DIRTY_TRACKING
+  uint32_t checkpoint() { return ++generation; }
+  bool dirty(uint32_t page, uint32_t since) const {
+    return generations[page] >= since;
+  }
+#else
+  uint32_t checkpoint() { return 0; }
+  bool dirty(uint32_t, uint32_t) const { return true; }
+#endif
+  uint32_t getPages() const { return (size + 0xff) >> 8; }
 
  private:
+  using Page = array<uint8_t, MEMORY_PAGE_SIZE>;
+
+  Memory(const Memory* parent);
+
   uint16_t index(uint16_t addr) { return addr % size; }
+  uint8_t watchedRead(uint16_t addr);
+  void watchedWrite(uint16_t addr, uint8_t value);
+  // drops the table entries of the pages watched for reads or writes
+  void route(uint32_t page);
+  void codeWritten(uint32_t offset, uint32_t len);
+  void codeChanged(uint32_t offset, const uint8_t* data, uint32_t len);
+  void touch(uint32_t offset, uint32_t len);
+  uint8_t* writable(uint32_t page) {
+    auto data = writePages[page];
+    return data ? data : unshare(page);
+  }
+  uint8_t* unshare(uint32_t page);
 
  private:
   uint16_t start;
   uint16_t end;
   uint32_t size;
-  uint8_t* memory;
+  vector<shared_ptr<Page>> pages;
+  vector<uint8_t*> readPages;
+  vector<uint8_t*> writePages;
+  // WATCH_READ and WATCH_WRITE per address, empty until the first watch
+  vector<uint8_t> watches;
+  vector<uint8_t> watchedPages;
+  Watcher watcher;
+  vector<uint8_t> codePages;
+  CodeWatcher codeWatcher;
+#ifdef DIRTY_TRACKING
+  uint32_t generation = 0;
+  vector<uint32_t> generations;
+#endif
 };
\ No newline at end of file
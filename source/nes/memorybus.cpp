@@ -16,4 +16,28 @@ uint16_t MemoryBus::read16(uint16_t addr) { return memory->read16(addr); }
 
 void MemoryBus::write16(uint16_t addr, uint16_t value) {
   memory->write16(addr, value);
-}
\ No newline at end of file
+}
+
+// Memory::get() is not watched
+void MemoryBus::peek(uint16_t addr, uint8_t* data, uint32_t len) {
+  auto first = std::min<uint32_t>(len, 0x10000 - addr);
+  memory->get(addr, data, first);
+  memory->get(0x0000, data + first, len - first);
+}
+
+// a memory smaller than the address space is mirrored, its bytes are
+// reported at every address they appear at
+void MemoryBus::setCodeWatcher(CodeWatcher watcher) {
+  if (!watcher) {
+    memory->setCodeWatcher(nullptr);
+    return;
+  }
+  auto size = memory->getSize();
+  memory->setCodeWatcher([watcher, size](uint32_t offset, uint32_t len) {
+    for (auto mirror = offset; mirror < 0x10000; mirror += size) {
+      watcher(mirror, len);
+    }
+  });
+}
+
+void MemoryBus::watchCode(uint8_t page) { memory->watchCode(page << 8); }
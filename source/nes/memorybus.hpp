@@ -18,6 +18,9 @@ class MemoryBus final : public Bus {
   virtual void write8(uint16_t addr, uint8_t value) override;
   virtual uint16_t read16(uint16_t addr) override;
   virtual void write16(uint16_t addr, uint16_t value) override;
+  virtual void peek(uint16_t addr, uint8_t* data, uint32_t len) override;
+  virtual void setCodeWatcher(CodeWatcher watcher) override;
+  virtual void watchCode(uint8_t page) override;
 
  private:
   shared_ptr<Memory> memory = nullptr;
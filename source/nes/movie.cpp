@@ -0,0 +1,63 @@
+#include "movie.hpp"
+
+#include "endian.hpp"
+
+using std::ifstream;
+using std::ios;
+using std::istreambuf_iterator;
+using std::ofstream;
+
+void Movie::serialize(vector<uint8_t>& data) const {
+  data.resize(MOVIE_HEADER_SIZE + inputs.size());
+  auto ptr = putLE(data.data(), MOVIE_MAGIC, 4);
+  ptr = putLE(ptr, MOVIE_VERSION, 2);
+  ptr = putLE(ptr, 0, 2);
+  ptr = putLE(ptr, seed, 4);
+  ptr = putLE(ptr, inputs.size(), 4);
+  ptr = putLE(ptr, hash, 8);
+  memcpy(ptr, inputs.data(), inputs.size());
+}
+
+bool Movie::deserialize(const uint8_t* data, uint32_t size) {
+  if (size < MOVIE_HEADER_SIZE || getLE(data, 4) != MOVIE_MAGIC ||
+      getLE(data + 4, 2) != MOVIE_VERSION ||
+      getLE(data + 12, 4) != size - MOVIE_HEADER_SIZE) {
+    return false;
+  }
+  seed = getLE(data + 8, 4);
+  hash = getLE(data + 16, 8);
+  inputs.assign(data + MOVIE_HEADER_SIZE, data + size);
+  return true;
+}
+
+bool Movie::save(const string& path) const {
+  vector<uint8_t> data;
+  serialize(data);
+  ofstream file(path, ios::binary);
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+  return file.good();
+}
+
+bool Movie::load(const string& path) {
+  ifstream file(path, ios::binary);
+  if (!file) {
+    return false;
+  }
+  vector<uint8_t> data((istreambuf_iterator<char>(file)),
+                       istreambuf_iterator<char>());
+  return deserialize(data.data(), data.size());
+}
+
+uint64_t Movie::hashRam(Console& console) {
+  uint8_t page[0x100];
+  uint64_t hash = 0xcbf29ce484222325;
+  auto size = console.memory->getSize();
+  for (uint32_t addr = 0; addr < size; addr += sizeof(page)) {
+    auto len = std::min(size - addr, uint32_t(sizeof(page)));
+    console.memory->get(addr, page, len);
+    for (uint32_t i = 0; i < len; i++) {
+      hash = (hash ^ page[i]) * 0x100000001b3;
+    }
+  }
+  return hash;
+}
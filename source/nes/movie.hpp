@@ -0,0 +1,31 @@
+#pragma once
+
+#include "console.hpp"
+
+using std::string;
+using std::vector;
+
+#define MOVIE_MAGIC 0x4d53454e  // "NESM"
+#define MOVIE_VERSION 1
+#define MOVIE_HEADER_SIZE 24
+
+// A deterministic input log: the seed the frontend derives its randomness
+// from, one controller byte per frame, and the RAM hash reached after the
+// last frame so a replay can be verified. Serialized little-endian as magic
+// u32, version u16, reserved u16, seed u32, frames u32, hash u64, inputs.
+struct Movie {
+  uint32_t seed = 0;
+  vector<uint8_t> inputs;
+  uint64_t hash = 0;
+
+  void record(uint8_t input) { inputs.push_back(input); }
+  uint32_t frames() const { return inputs.size(); }
+
+  void serialize(vector<uint8_t>& data) const;
+  bool deserialize(const uint8_t* data, uint32_t size);
+  bool save(const string& path) const;
+  bool load(const string& path);
+
+  // FNV-1a over the whole memory of the console
+  static uint64_t hashRam(Console& console);
+};
@@ -0,0 +1,99 @@
+#include "profiler.hpp"
+
+using std::dec;
+using std::hex;
+using std::ofstream;
+using std::setfill;
+using std::setw;
+
+Profiler::Profiler()
+    : counts(PROFILER_ADDRESSES),
+      pcCycles(PROFILER_ADDRESSES),
+      opcodes(PROFILER_ADDRESSES) {}
+
+void Profiler::clear() {
+  std::fill(counts.begin(), counts.end(), 0);
+  std::fill(pcCycles.begin(), pcCycles.end(), 0);
+  std::fill(opcodes.begin(), opcodes.end(), 0);
+  memset(opcodeCounts, 0, sizeof(opcodeCounts));
+  memset(opcodeCycles, 0, sizeof(opcodeCycles));
+}
+
+uint64_t Profiler::getInstructions() const {
+  uint64_t total = 0;
+  for (auto count : opcodeCounts) {
+    total += count;
+  }
+  return total;
+}
+
+uint64_t Profiler::getTotalCycles() const {
+  uint64_t total = 0;
+  for (auto cycles : opcodeCycles) {
+    total += cycles;
+  }
+  return total;
+}
+
+vector<Profiler::Spot> Profiler::hotSpots(uint32_t limit) const {
+  vector<Spot> spots;
+  for (uint32_t pc = 0; pc < PROFILER_ADDRESSES; pc++) {
+    if (counts[pc]) {
+      spots.push_back({uint16_t(pc), opcodes[pc], counts[pc], pcCycles[pc]});
+    }
+  }
+  auto hotter = [](const Spot& a, const Spot& b) {
+    return a.cycles != b.cycles ? a.cycles > b.cycles : a.pc < b.pc;
+  };
+  if (spots.size() > limit) {
+    std::partial_sort(spots.begin(), spots.begin() + limit, spots.end(),
+                      hotter);
+    spots.resize(limit);
+  } else {
+    std::sort(spots.begin(), spots.end(), hotter);
+  }
+  return spots;
+}
+
+void Profiler::report(ostream& out, uint32_t limit) const {
+  auto table = CPU::opcodeTable();
+  auto total = getTotalCycles();
+  auto flags = out.flags();
+  out << "instructions " << getInstructions() << " cycles " << total << "\n";
+  out << "  pc   op  mnemonic      count     cycles      %\n";
+  for (auto& spot : hotSpots(limit)) {
+    out << setfill('0') << hex << setw(4) << spot.pc << "  " << setw(2)
+        << uint32_t(spot.opcode) << "  " << table[spot.opcode].mnemonic
+        << setfill(' ') << dec << setw(16) << spot.count << setw(11)
+        << spot.cycles << std::fixed << std::setprecision(2) << setw(7)
+        << (total ? 100.0 * spot.cycles / total : 0.0) << "\n";
+  }
+  out.flags(flags);
+}
+
+void Profiler::writeCsv(ostream& out) const {
+  auto table = CPU::opcodeTable();
+  auto flags = out.flags();
+  out << "kind,key,mnemonic,count,cycles\n" << setfill('0');
+  for (uint32_t pc = 0; pc < PROFILER_ADDRESSES; pc++) {
+    if (counts[pc]) {
+      out << "pc," << hex << setw(4) << pc << "," << table[opcodes[pc]].mnemonic
+          << "," << dec << counts[pc] << "," << pcCycles[pc] << "\n";
+    }
+  }
+  for (uint32_t opcode = 0; opcode < PROFILER_OPCODES; opcode++) {
+    if (opcodeCounts[opcode]) {
+      out << "opcode," << hex << setw(2) << opcode << ","
+          << table[opcode].mnemonic << "," << dec << opcodeCounts[opcode]
+          << "," << opcodeCycles[opcode] << "\n";
+    }
+  }
+  out.flags(flags);
+  out << setfill(' ');
+}
+
+bool Profiler::saveCsv(const string& path) const {
+  ofstream file(path);
+  writeCsv(file);
+  return file.good();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::ostream;
+using std::string;
+using std::vector;
+
+#define PROFILER_ADDRESSES 0x10000
+#define PROFILER_OPCODES 0x100
+
+// Counts instructions and cycles per PC and per opcode. Pass it as the hooks
+// of CPU::run() or Console::frame(); runs without it are not slowed down.
+class Profiler : public NoHooks {
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+ public:
+  struct Spot {
+    uint16_t pc;
+    uint8_t opcode;
+    uint64_t count;
+    uint64_t cycles;
+  };
+
+  Profiler();
+  ~Profiler() = default;
+
+  void instruction(uint16_t pc, uint8_t opcode, uint32_t cycles) {
+    counts[pc]++;
+    pcCycles[pc] += cycles;
+    opcodes[pc] = opcode;
+    opcodeCounts[opcode]++;
+    opcodeCycles[opcode] += cycles;
+  }
+  void clear();
+
+  uint64_t getCount(uint16_t pc) const { return counts[pc]; }
+  uint64_t getCycles(uint16_t pc) const { return pcCycles[pc]; }
+  uint64_t getOpcodeCount(uint8_t opcode) const { return opcodeCounts[opcode]; }
+  uint64_t getOpcodeCycles(uint8_t opcode) const {
+    return opcodeCycles[opcode];
+  }
+  uint64_t getInstructions() const;
+  uint64_t getTotalCycles() const;
+
+  // executed PCs by cycles spent, most first, at most limit of them
+  vector<Spot> hotSpots(uint32_t limit) const;
+  void report(ostream& out, uint32_t limit = 20) const;
+  // kind,key,mnemonic,count,cycles with one row per executed PC ("pc") and
+  // one per executed opcode ("opcode"), keys in hex
+  void writeCsv(ostream& out) const;
+  bool saveCsv(const string& path) const;
+
+ private:
+  vector<uint64_t> counts;
+  vector<uint64_t> pcCycles;
+  vector<uint8_t> opcodes;
+  uint64_t opcodeCounts[PROFILER_OPCODES] = {};
+  uint64_t opcodeCycles[PROFILER_OPCODES] = {};
+};
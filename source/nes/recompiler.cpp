@@ -0,0 +1,474 @@
+#include "recompiler.hpp"
+
+#include "cpu.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define JIT_SUPPORTED 1
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+namespace {
+
+enum Reg8 : uint8_t { AL = 0 };
+
+// Minimal x86-64 encoder: every memory operand is [rbx + disp32], rbx holds
+// the address of the CPU being recompiled.
+class Emitter {
+ public:
+  Emitter(uint8_t* acode) : code(acode) {}
+
+  uint32_t size() const { return length; }
+  void patch8(uint32_t at, uint8_t value) { code[at] = value; }
+
+  void raw(uint8_t byte) { code[length++] = byte; }
+  template <typename... Bytes>
+  void raw(uint8_t byte, Bytes... bytes) {
+    raw(byte);
+    raw(bytes...);
+  }
+  void imm16(uint16_t value) {
+    memcpy(code + length, &value, sizeof(value));
+    length += sizeof(value);
+  }
+  void imm32(int32_t value) {
+    memcpy(code + length, &value, sizeof(value));
+    length += sizeof(value);
+  }
+  void imm64(uint64_t value) {
+    memcpy(code + length, &value, sizeof(value));
+    length += sizeof(value);
+  }
+
+  void load8(Reg8 reg, int32_t disp) {
+    raw(0x8a, 0x83 | (reg << 3));
+    imm32(disp);
+  }
+  void store8(Reg8 reg, int32_t disp) {
+    raw(0x88, 0x83 | (reg << 3));
+    imm32(disp);
+  }
+  void storeImm8(int32_t disp, uint8_t value) {
+    raw(0xc6, 0x83);
+    imm32(disp);
+    raw(value);
+  }
+  void storeImm16(int32_t disp, uint16_t value) {
+    raw(0x66, 0xc7, 0x83);
+    imm32(disp);
+    imm16(value);
+  }
+  void addImm16(int32_t disp, uint16_t value) {
+    raw(0x66, 0x81, 0x83);
+    imm32(disp);
+    imm16(value);
+  }
+  void andImm8(int32_t disp, uint8_t value) {
+    raw(0x80, 0xa3);
+    imm32(disp);
+    raw(value);
+  }
+  void orImm8(int32_t disp, uint8_t value) {
+    raw(0x80, 0x8b);
+    imm32(disp);
+    raw(value);
+  }
+  void call(const void* jit, const void* info, const void* fn) {
+    raw(0x48, 0xbf);
+    imm64(reinterpret_cast<uint64_t>(jit));
+    raw(0x48, 0xbe);
+    imm64(reinterpret_cast<uint64_t>(info));
+    raw(0x48, 0xb8);
+    imm64(reinterpret_cast<uint64_t>(fn));
+    raw(0xff, 0xd0);
+  }
+
+ private:
+  uint8_t* code;
+  uint32_t length = 0;
+};
+
+}  // namespace
+
+Recompiler::Recompiler(CPU& acpu)
+    : cpu(acpu), runs(0x10000, -1), steps(0x10000, -1) {
+#if JIT_SUPPORTED
+  auto buffer =
+      mmap(nullptr, JIT_CACHE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (buffer != MAP_FAILED) {
+    cache = static_cast<uint8_t*>(buffer);
+  }
+#endif
+  cpu.bus->setCodeWatcher(
+      [this](uint16_t addr, uint32_t len) { written(addr, len); });
+}
+
+Recompiler::~Recompiler() {
+  cpu.bus->setCodeWatcher(nullptr);
+#if JIT_SUPPORTED
+  if (cache != nullptr) {
+    munmap(cache, JIT_CACHE_SIZE);
+  }
+#endif
+}
+
+void Recompiler::flush() {
+  reclaim();
+  memset(smcHits, 0, sizeof(smcHits));
+  memset(interpreted, 0, sizeof(interpreted));
+}
+
+void Recompiler::reclaim() {
+  used = 0;
+  blocks.clear();
+  std::fill(runs.begin(), runs.end(), -1);
+  std::fill(steps.begin(), steps.end(), -1);
+  memset(codePages, 0, sizeof(codePages));
+  codeBytes.reset();
+}
+
+uint32_t Recompiler::run(uint32_t budget) {
+  uint32_t elapsed = cpu.cycles;
+  while (elapsed < budget) {
+    cpu.cycles = 0;
+    auto entry = lookup(runs, JIT_BLOCK_INSTRUCTIONS);
+    if (entry != nullptr) {
+      entry();
+    } else {
+      interpret();
+    }
+    elapsed += cpu.cycles;
+  }
+  cpu.cycles = 0;
+  return elapsed;
+}
+
+void Recompiler::step() {
+  auto entry = lookup(steps, 1);
+  if (entry != nullptr) {
+    entry();
+  } else {
+    interpret();
+  }
+}
+
+Recompiler::Entry Recompiler::lookup(vector<int32_t>& table, uint32_t count) {
+  auto pc = cpu.pc;
+  auto index = table[pc];
+  if (index >= 0) {
+    return blocks[index].entry;
+  }
+  if (cache == nullptr || interpreted[pc >> 8]) {
+    return nullptr;
+  }
+  auto entry = translate(pc, count);
+  if (entry != nullptr) {
+    table[pc] = blocks.size() - 1;
+  }
+  return entry;
+}
+
+namespace {
+
+bool isNative(const OpcodeInfo& info) {
+  if (info.bytes == 0) {
+    return false;
+  }
+  if (info.resolve == &CPU::imm) {
+    return info.execute == &CPU::LDA || info.execute == &CPU::LDX ||
+           info.execute == &CPU::LDY || info.execute == &CPU::AND ||
+           info.execute == &CPU::ORA || info.execute == &CPU::EOR;
+  }
+  if (info.resolve == &CPU::imp) {
+    return info.execute == &CPU::CLC || info.execute == &CPU::SEC ||
+           info.execute == &CPU::CLI || info.execute == &CPU::SEI ||
+           info.execute == &CPU::CLD || info.execute == &CPU::SED ||
+           info.execute == &CPU::CLV || info.execute == &CPU::NOP ||
+           info.execute == &CPU::TAX || info.execute == &CPU::TAY ||
+           info.execute == &CPU::TXA || info.execute == &CPU::TYA ||
+           info.execute == &CPU::TSX || info.execute == &CPU::TXS ||
+           info.execute == &CPU::INX || info.execute == &CPU::INY ||
+           info.execute == &CPU::DEX || info.execute == &CPU::DEY;
+  }
+  return false;
+}
+
+bool isTerminator(const OpcodeInfo& info) {
+  return info.bytes == 0 || info.resolve == &CPU::rel ||
+         info.execute == &CPU::JMP || info.execute == &CPU::JSR ||
+         info.execute == &CPU::RTS || info.execute == &CPU::RTI ||
+         info.execute == &CPU::BRK;
+}
+
+bool isStore(const OpcodeInfo& info) {
+  if (info.execute == &CPU::STA || info.execute == &CPU::STX ||
+      info.execute == &CPU::STY || info.execute == &CPU::INC ||
+      info.execute == &CPU::DEC) {
+    return true;
+  }
+  return info.resolve != &CPU::acc &&
+         (info.execute == &CPU::ASL || info.execute == &CPU::LSR ||
+          info.execute == &CPU::ROL || info.execute == &CPU::ROR);
+}
+
+bool isPush(const OpcodeInfo& info) {
+  return info.execute == &CPU::PHA || info.execute == &CPU::PHP ||
+         info.execute == &CPU::JSR || info.execute == &CPU::BRK;
+}
+
+}  // namespace
+
+Recompiler::Entry Recompiler::translate(uint16_t start, uint32_t count) {
+  if (used + count * 96 + 64 > JIT_CACHE_SIZE) {
+    reclaim();
+  }
+
+  auto base = reinterpret_cast<const uint8_t*>(&cpu);
+  auto disp = [base](const void* field) {
+    return int32_t(static_cast<const uint8_t*>(field) - base);
+  };
+  auto a = disp(&cpu.a);
+  auto x = disp(&cpu.x);
+  auto y = disp(&cpu.y);
+  auto p = disp(&cpu.p);
+  auto carry = disp(&cpu.carry);
+  auto zResult = disp(&cpu.zResult);
+  auto nResult = disp(&cpu.nResult);
+  auto vResult = disp(&cpu.vResult);
+  auto sp = disp(&cpu.sp);
+  auto pc = disp(&cpu.pc);
+  auto cycles = disp(&cpu.cycles);
+  auto address = disp(&cpu.address);
+  auto addressing = disp(&cpu.addressing);
+
+  Emitter e(cache + used);
+  uint16_t pending = 0;
+  const OpcodeInfo* native = nullptr;
+  uint16_t nativePc = 0;
+
+  // N and Z derive from the value in al
+  auto zn = [&]() {
+    e.store8(AL, zResult);
+    e.store8(AL, nResult);
+  };
+  auto transfer = [&](int32_t from, int32_t to, bool flags) {
+    e.load8(AL, from);
+    e.store8(AL, to);
+    if (flags) {
+      zn();
+    }
+  };
+  auto increment = [&](int32_t reg, uint8_t op) {
+    e.load8(AL, reg);
+    e.raw(0xfe, op);  // inc al / dec al
+    e.store8(AL, reg);
+    zn();
+  };
+  auto exit = [&](const OpcodeInfo* last, uint16_t lastPc) {
+    if (pending > 0) {
+      e.addImm16(cycles, pending);
+    }
+    if (last != nullptr) {
+      e.storeImm16(pc, lastPc + last->bytes);
+      if (last->resolve == &CPU::imm) {
+        e.storeImm8(addressing, uint8_t(Addressing::Imm));
+        e.storeImm16(address, lastPc + 1);
+      } else {
+        e.storeImm8(addressing, uint8_t(Addressing::Imp));
+      }
+    }
+    e.raw(0x5b);  // pop rbx
+    e.raw(0xc3);  // ret
+  };
+
+  e.raw(0x53);  // push rbx
+  e.raw(0x48, 0xbb);
+  e.imm64(reinterpret_cast<uint64_t>(&cpu));
+
+  uint32_t address6502 = start;
+  uint32_t translated = 0;
+  while (translated < count) {
+    auto opcode = cpu.bus->read8(address6502);
+    auto& info = cpu.opcodes[opcode];
+    auto last = address6502 + (info.bytes > 0 ? info.bytes - 1 : 0);
+    if (last > 0xffff || interpreted[last >> 8]) {
+      break;
+    }
+
+    if (isNative(info)) {
+      uint8_t operand = cpu.bus->read8(address6502 + 1);
+      auto fn = info.execute;
+      if (fn == &CPU::CLC) {
+        e.storeImm8(carry, 0x00);
+      } else if (fn == &CPU::SEC) {
+        e.storeImm8(carry, 0x01);
+      } else if (fn == &CPU::CLI) {
+        e.andImm8(p, ~static_cast<uint8_t>(Flags::I));
+      } else if (fn == &CPU::SEI) {
+        e.orImm8(p, static_cast<uint8_t>(Flags::I));
+      } else if (fn == &CPU::CLD) {
+        e.andImm8(p, ~static_cast<uint8_t>(Flags::D));
+      } else if (fn == &CPU::SED) {
+        e.orImm8(p, static_cast<uint8_t>(Flags::D));
+      } else if (fn == &CPU::CLV) {
+        e.storeImm8(vResult, 0x00);
+      } else if (fn == &CPU::TAX) {
+        transfer(a, x, true);
+      } else if (fn == &CPU::TAY) {
+        transfer(a, y, true);
+      } else if (fn == &CPU::TXA) {
+        transfer(x, a, true);
+      } else if (fn == &CPU::TYA) {
+        transfer(y, a, true);
+      } else if (fn == &CPU::TSX) {
+        transfer(sp, x, true);
+      } else if (fn == &CPU::TXS) {
+        transfer(x, sp, false);
+      } else if (fn == &CPU::INX) {
+        increment(x, 0xc0);
+      } else if (fn == &CPU::INY) {
+        increment(y, 0xc0);
+      } else if (fn == &CPU::DEX) {
+        increment(x, 0xc8);
+      } else if (fn == &CPU::DEY) {
+        increment(y, 0xc8);
+      } else if (fn == &CPU::LDA || fn == &CPU::LDX || fn == &CPU::LDY) {
+        e.raw(0xb0, operand);  // mov al, imm8
+        e.store8(AL, fn == &CPU::LDA ? a : fn == &CPU::LDX ? x : y);
+        zn();
+      } else if (fn == &CPU::AND || fn == &CPU::ORA || fn == &CPU::EOR) {
+        e.load8(AL, a);
+        e.raw(fn == &CPU::AND ? 0x24 : fn == &CPU::ORA ? 0x0c : 0x34, operand);
+        e.store8(AL, a);
+        zn();
+      }
+      pending += info.cycles;
+      native = &info;
+      nativePc = address6502;
+    } else {
+      auto helper = isStore(info) || isPush(info) ? &Recompiler::store
+                                                  : &Recompiler::execute;
+      e.storeImm16(pc, address6502);
+      e.call(this, &info, reinterpret_cast<const void*>(helper));
+      native = nullptr;
+      if (helper != &Recompiler::execute) {
+        // leave the block as soon as translated code has been overwritten
+        e.raw(0x84, 0xc0);  // test al, al
+        e.raw(0x74, 0x00);  // jz skip
+        auto skip = e.size();
+        exit(nullptr, 0);
+        e.patch8(skip - 1, uint8_t(e.size() - skip));
+      }
+    }
+
+    address6502 += info.bytes;
+    translated++;
+    if (isTerminator(info)) {
+      break;
+    }
+  }
+
+  if (translated == 0) {
+    return nullptr;
+  }
+  exit(native, nativePc);
+
+  auto entry = reinterpret_cast<Entry>(cache + used);
+  used += (e.size() + 15) & ~15u;
+  uint16_t end = address6502 > start ? address6502 - 1 : start;
+  blocks.push_back(Block{start, end, entry});
+  for (uint32_t addr = start; addr <= end; addr++) {
+    codeBytes[addr] = true;
+  }
+  for (auto page = start >> 8; page <= end >> 8; page++) {
+    codePages[page] = 1;
+    cpu.bus->watchCode(page);
+  }
+  return entry;
+}
+
+void Recompiler::interpret() {
+  auto& info = cpu.opcodes[cpu.bus->read8(cpu.pc)];
+  if (isStore(info) || isPush(info)) {
+    store(this, &info);
+  } else {
+    execute(this, &info);
+  }
+}
+
+// Called by the bus whoever writes, from inside store() when it is the
+// translated code; only those writes count as self-modifying, so loading
+// other code over a page does not leave it interpreted. The bus stops
+// watching the page until it is watched again, which happens here when the
+// write missed the code or left some of it.
+void Recompiler::written(uint16_t addr, uint32_t len) {
+  uint8_t page = addr >> 8;
+  if (!codePages[page]) {
+    return;
+  }
+  auto hit = false;
+  for (uint32_t i = 0; i < len && !hit; i++) {
+    hit = codeBytes[addr + i];
+  }
+  if (hit) {
+    if (storing) {
+      overwritten = true;
+      if (++smcHits[page] >= JIT_SMC_LIMIT) {
+        interpreted[page] = true;
+      }
+    }
+    discard(addr, len);
+  }
+  if (codePages[page]) {
+    cpu.bus->watchCode(page);
+  }
+}
+
+// drops the blocks overlapping the bytes, the others keep their code
+void Recompiler::discard(uint16_t addr, uint32_t len) {
+  uint32_t last = addr + len - 1;
+  memset(codePages, 0, sizeof(codePages));
+  codeBytes.reset();
+  for (int32_t i = 0; i < int32_t(blocks.size()); i++) {
+    auto& block = blocks[i];
+    if (block.entry == nullptr) {
+      continue;
+    }
+    if (block.start <= last && addr <= block.end) {
+      if (runs[block.start] == i) {
+        runs[block.start] = -1;
+      }
+      if (steps[block.start] == i) {
+        steps[block.start] = -1;
+      }
+      block.entry = nullptr;
+      continue;
+    }
+    for (uint32_t byte = block.start; byte <= block.end; byte++) {
+      codeBytes[byte] = true;
+    }
+    for (auto p = block.start >> 8; p <= block.end >> 8; p++) {
+      codePages[p] = 1;
+    }
+  }
+}
+
+bool Recompiler::execute(Recompiler* jit, const OpcodeInfo* info) {
+  auto& cpu = jit->cpu;
+  cpu.opcodeInfo = *info;
+  (cpu.*info->resolve)();
+  cpu.cycles += info->cycles;
+  cpu.pc += info->bytes;
+  (cpu.*info->execute)();
+  return false;
+}
+
+bool Recompiler::store(Recompiler* jit, const OpcodeInfo* info) {
+  jit->storing = true;
+  jit->overwritten = false;
+  execute(jit, info);
+  jit->storing = false;
+  return jit->overwritten;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "pch.h"
+
+using std::bitset;
+using std::vector;
+
+#define JIT_CACHE_SIZE 0x100000
+#define JIT_BLOCK_INSTRUCTIONS 32
+#define JIT_SMC_LIMIT 4
+
+class CPU;
+struct OpcodeInfo;
+
+// Translates 6502 basic blocks into x86-64 machine code. Register, flag and
+// immediate instructions are emitted natively, everything touching the bus is
+// emitted as a call into the interpreter handlers so devices see the same
+// accesses. Cycles are accumulated at block boundaries. The bus reports writes
+// to pages holding translated code, whoever makes them, and the blocks whose
+// bytes were written are dropped; pages the code itself keeps modifying fall
+// back to the interpreter. Only available on Linux x86-64.
+class Recompiler {
+  Recompiler(const Recompiler&) = delete;
+  Recompiler& operator=(const Recompiler&) = delete;
+
+ public:
+  Recompiler(CPU& acpu);
+  ~Recompiler();
+
+  bool available() const { return cache != nullptr; }
+  uint32_t run(uint32_t budget);
+  void step();
+  void flush();
+
+ private:
+  using Entry = void (*)();
+
+  struct Block {
+    uint16_t start;
+    uint16_t end;
+    Entry entry;
+  };
+
+  Entry translate(uint16_t start, uint32_t count);
+  Entry lookup(vector<int32_t>& table, uint32_t count);
+  void interpret();
+  void written(uint16_t addr, uint32_t len);
+  void discard(uint16_t addr, uint32_t len);
+  void reclaim();
+
+  static bool execute(Recompiler* jit, const OpcodeInfo* info);
+  static bool store(Recompiler* jit, const OpcodeInfo* info);
+
+  CPU& cpu;
+  uint8_t* cache = nullptr;
+  uint32_t used = 0;
+  vector<Block> blocks;
+  vector<int32_t> runs;
+  vector<int32_t> steps;
+  uint8_t codePages[256] = {};
+  // the bytes blocks were translated from, so data written next to code
+  // leaves it alone
+  bitset<0x10000> codeBytes;
+  uint8_t smcHits[256] = {};
+  bool interpreted[256] = {};
+  // set by store() around the write, and when it overwrote translated code
+  bool storing = false;
+  bool overwritten = false;
+};
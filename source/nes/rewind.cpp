@@ -0,0 +1,212 @@
+#include "rewind.hpp"
+
+Rewind::Rewind(Console& aconsole, uint32_t ainterval, uint32_t capacity)
+    : console(aconsole), interval(ainterval ? ainterval : 1) {
+  auto size = console.stateSize();
+  ring.resize(capacity);
+  slots.resize(capacity / 32 + 1);
+  latest.resize(size);
+  current.resize(size);
+  delta.resize(size);
+  scratch.resize(2 * size + 16);
+}
+
+void Rewind::frame() {
+  if (++elapsed >= interval) {
+    elapsed = 0;
+    capture();
+  }
+}
+
+// latest and current both hold the newest state; only the pages written since
+// the previous capture are saved again and diffed, the rest of the delta
+// buffer stays zero
+void Rewind::capture() {
+  auto& memory = *console.memory;
+  auto previous = since;
+  console.saveState(current.data(), previous);
+  since = memory.checkpoint();
+  if (!hasLatest) {
+    latest = current;
+    hasLatest = true;
+    return;
+  }
+
+  auto ram = console.stateRamOffset();
+  auto diff = [&](uint32_t start, uint32_t end) {
+    for (auto i = start; i < end; i++) {
+      delta[i] = latest[i] ^ current[i];
+      latest[i] = current[i];
+    }
+  };
+  diff(0, ram);
+  for (uint32_t page = 0; page < memory.getPages(); page++) {
+    if (previous == 0 || memory.dirty(page, previous)) {
+      diff(ram + (page << 8),
+           ram + std::min((page + 1) << 8, memory.getSize()));
+    }
+  }
+  diff(ram + memory.getSize(), delta.size());
+
+  auto length = encode(delta.data(), delta.size(), scratch.data());
+  push(scratch.data(), length);
+  capturedBytes += length;
+  captured++;
+  memset(delta.data(), 0, delta.size());
+}
+
+// the older state is decoded aside into delta first, so a corrupt delta
+// leaves the console and the history as they were
+bool Rewind::rewind() {
+  if (!hasLatest) {
+    return false;
+  }
+  uint32_t length = 0;
+  if (count > 0) {
+    auto& slot = slots[(first + count - 1) % slots.size()];
+    length = slot.length;
+    memcpy(delta.data(), latest.data(), latest.size());
+    if (!decode(&ring[slot.offset], length, delta.data(), delta.size())) {
+      memset(delta.data(), 0, delta.size());
+      return false;
+    }
+  }
+  if (!console.loadState(latest)) {
+    memset(delta.data(), 0, delta.size());
+    return false;
+  }
+  elapsed = 0;
+  if (count == 0) {
+    hasLatest = false;
+    return true;
+  }
+
+  latest.swap(delta);
+  memset(delta.data(), 0, delta.size());
+  usedBytes -= length;
+  count--;
+  return true;
+}
+
+void Rewind::clear() {
+  first = 0;
+  count = 0;
+  usedBytes = 0;
+  elapsed = 0;
+  hasLatest = false;
+}
+
+uint64_t Rewind::bytesPerMinute() const {
+  if (captured == 0) {
+    return 0;
+  }
+  return capturedBytes * REWIND_FRAMES_PER_MINUTE / (captured * interval);
+}
+
+// finds room after the newest delta, wrapping to the start of the ring when
+// the tail is too short, and evicts the oldest deltas until it fits
+void Rewind::push(const uint8_t* data, uint32_t length) {
+  if (length > ring.size()) {
+    // the chain to every older snapshot goes through this delta
+    first = 0;
+    count = 0;
+    usedBytes = 0;
+    return;
+  }
+
+  uint32_t offset = 0;
+  while (count > 0) {
+    auto& oldest = slots[first];
+    auto& newest = slots[(first + count - 1) % slots.size()];
+    offset = newest.offset + newest.length;
+    if (count < slots.size()) {
+      if (oldest.offset <= newest.offset) {
+        if (offset + length <= ring.size()) {
+          break;
+        }
+        if (length <= oldest.offset) {
+          offset = 0;
+          break;
+        }
+      } else if (offset + length <= oldest.offset) {
+        break;
+      }
+    }
+    dropOldest();
+    offset = 0;
+  }
+
+  memcpy(&ring[offset], data, length);
+  slots[(first + count) % slots.size()] = {offset, length};
+  count++;
+  usedBytes += length;
+}
+
+void Rewind::dropOldest() {
+  usedBytes -= slots[first].length;
+  first = (first + 1) % slots.size();
+  count--;
+}
+
+// Tokens of a little-endian u16 count of unchanged bytes, a u16 count of
+// changed bytes and the changed bytes themselves. Zero runs shorter than
+// REWIND_MIN_ZERO_RUN stay inside the literal to keep tokens from dominating.
+uint32_t Rewind::encode(const uint8_t* delta, uint32_t size, uint8_t* out) {
+  uint32_t length = 0;
+  uint32_t i = 0;
+  while (i < size) {
+    uint32_t zeros = 0;
+    while (i < size && delta[i] == 0 && zeros < 0xffff) {
+      zeros++;
+      i++;
+    }
+
+    auto start = i;
+    uint32_t literals = 0;
+    while (i < size && literals < 0xffff) {
+      uint32_t run = 0;
+      while (i + run < size && delta[i + run] == 0 &&
+             run < REWIND_MIN_ZERO_RUN) {
+        run++;
+      }
+      if (run == REWIND_MIN_ZERO_RUN || i + run == size) {
+        break;
+      }
+      auto step = run ? run : 1;
+      if (literals + step > 0xffff) {
+        break;
+      }
+      literals += step;
+      i += step;
+    }
+
+    out[length++] = zeros;
+    out[length++] = zeros >> 8;
+    out[length++] = literals;
+    out[length++] = literals >> 8;
+    memcpy(out + length, delta + start, literals);
+    length += literals;
+  }
+  return length;
+}
+
+bool Rewind::decode(const uint8_t* in, uint32_t length, uint8_t* state,
+                    uint32_t size) {
+  uint32_t offset = 0;
+  uint32_t i = 0;
+  while (i + 4 <= length) {
+    uint32_t zeros = in[i] | (in[i + 1] << 8);
+    uint32_t literals = in[i + 2] | (in[i + 3] << 8);
+    i += 4;
+    offset += zeros;
+    if (offset + literals > size || i + literals > length) {
+      return false;
+    }
+    for (uint32_t j = 0; j < literals; j++) {
+      state[offset + j] ^= in[i + j];
+    }
+    offset += literals;
+    i += literals;
+  }
+  return i == length && offset == size;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "console.hpp"
+
+using std::vector;
+
+#define REWIND_FRAMES_PER_MINUTE 3600
+#define REWIND_MIN_ZERO_RUN 4
+
+// Keeps a history of console save states in a preallocated ring buffer. Only
+// the newest snapshot is kept whole, every older one is stored as the XOR
+// against its successor, run-length encoded since consecutive states mostly
+// agree. With dirty tracking only pages written since the previous capture
+// are copied and diffed. When the ring is full the oldest snapshots are
+// dropped.
+class Rewind {
+  Rewind(const Rewind&) = delete;
+  Rewind& operator=(const Rewind&) = delete;
+
+ public:
+  Rewind(Console& aconsole, uint32_t ainterval, uint32_t capacity);
+  ~Rewind() = default;
+
+  // call once per emulated frame, captures every interval frames
+  void frame();
+  void capture();
+  // restores the newest snapshot and drops it, so repeated calls walk back
+  bool rewind();
+  void clear();
+
+  uint32_t snapshots() const { return count + (hasLatest ? 1 : 0); }
+  uint32_t used() const { return usedBytes; }
+  uint32_t capacity() const { return ring.size(); }
+  // average ring usage for one minute of history at 60 frames per second
+  uint64_t bytesPerMinute() const;
+
+  static uint32_t encode(const uint8_t* delta, uint32_t size, uint8_t* out);
+  static bool decode(const uint8_t* in, uint32_t length, uint8_t* state,
+                     uint32_t size);
+
+ private:
+  friend class RewindTest;
+
+  struct Slot {
+    uint32_t offset;
+    uint32_t length;
+  };
+
+  void push(const uint8_t* data, uint32_t length);
+  void dropOldest();
+
+  Console& console;
+  uint32_t interval;
+  uint32_t elapsed = 0;
+  vector<uint8_t> ring;
+  vector<Slot> slots;
+  uint32_t first = 0;
+  uint32_t count = 0;
+  uint32_t usedBytes = 0;
+  vector<uint8_t> latest;
+  vector<uint8_t> current;
+  vector<uint8_t> delta;
+  vector<uint8_t> scratch;
+  bool hasLatest = false;
+  uint32_t since = 0;
+  uint64_t capturedBytes = 0;
+  uint64_t captured = 0;
+};
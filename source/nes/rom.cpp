@@ -0,0 +1,78 @@
+#include "rom.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::ifstream;
+using std::ios;
+
+Rom::Rom(const uint8_t* adata, uint32_t asize) : size(asize) {
+  data = (uint8_t*)malloc(size ? size : 1);
+  memcpy(data, adata, size);
+}
+
+Rom::Rom(const string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    auto memory = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (memory != MAP_FAILED) {
+      data = (uint8_t*)memory;
+      size = info.st_size;
+      mapped = true;
+    }
+  }
+  close(fd);
+#endif
+  if (!data) {
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file) {
+      return;
+    }
+    size = file.tellg();
+    file.seekg(0);
+    data = (uint8_t*)malloc(size ? size : 1);
+    file.read(reinterpret_cast<char*>(data), size);
+  }
+}
+
+Rom::~Rom() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped) {
+    munmap(data, size);
+    return;
+  }
+#endif
+  free(data);
+}
+
+bool Rom::isINes() const {
+  if (size < INES_HEADER_SIZE || memcmp(data, "NES\x1a", 4) != 0) {
+    return false;
+  }
+  uint32_t start = INES_HEADER_SIZE + (data[6] & 0x04 ? INES_TRAINER_SIZE : 0);
+  return size >= start && size - start >= data[4] * INES_PRG_BANK_SIZE;
+}
+
+uint32_t Rom::getMapper() const {
+  return isINes() ? (data[6] >> 4) | (data[7] & 0xf0) : 0;
+}
+
+const uint8_t* Rom::getPrg() const {
+  if (!isINes()) {
+    return nullptr;
+  }
+  return data + INES_HEADER_SIZE + (data[6] & 0x04 ? INES_TRAINER_SIZE : 0);
+}
+
+uint32_t Rom::getPrgSize() const {
+  return isINes() ? data[4] * INES_PRG_BANK_SIZE : 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "pch.h"
+
+using std::string;
+
+#define INES_HEADER_SIZE 16
+#define INES_TRAINER_SIZE 512
+#define INES_PRG_BANK_SIZE 0x4000
+
+// Read-only program image. Files are mapped rather than read, so opening
+// one costs no copy; BatchRunner copies each image once into the start
+// state its jobs load.
+class Rom {
+  Rom(const Rom&) = delete;
+  Rom& operator=(const Rom&) = delete;
+
+ public:
+  Rom(const uint8_t* adata, uint32_t asize);
+  Rom(const string& path);
+  ~Rom();
+
+  bool valid() const { return data != nullptr; }
+  bool isMapped() const { return mapped; }
+  const uint8_t* getData() const { return data; }
+  uint32_t getSize() const { return size; }
+
+  // iNES images: a 16 byte header, an optional trainer, then PRG ROM in
+  // 16 KB banks. The accessors return nullptr and 0 for anything else.
+  bool isINes() const;
+  uint32_t getMapper() const;
+  const uint8_t* getPrg() const;
+  uint32_t getPrgSize() const;
+
+ private:
+  uint8_t* data = nullptr;
+  uint32_t size = 0;
+  bool mapped = false;
+};
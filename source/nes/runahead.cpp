@@ -0,0 +1,35 @@
+#include "runahead.hpp"
+
+using std::chrono::duration_cast;
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+RunAhead::RunAhead(Console& aconsole, uint32_t aframes)
+    : console(aconsole), frames(aframes) {
+  state.resize(console.stateSize());
+  ahead.cyclesPerFrame = console.cyclesPerFrame;
+  ahead.cpu->setBackend(console.cpu->getBackend());
+}
+
+Console& RunAhead::frame() {
+  console.frame();
+  if (frames == 0) {
+    return console;
+  }
+
+  auto start = steady_clock::now();
+  auto previous = since;
+  console.saveState(state.data(), previous);
+  since = console.memory->checkpoint();
+  ahead.loadState(state);
+  for (uint32_t i = 0; i < frames; i++) {
+    ahead.frame();
+  }
+  elapsed += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+  emulated += frames;
+  return ahead;
+}
+
+double RunAhead::costPerFrame() const {
+  return emulated ? double(elapsed) / emulated / 1000.0 : 0.0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "console.hpp"
+
+using std::vector;
+
+// Hides input latency by presenting a frame emulated ahead of the real one.
+// Every frame the state of the console is copied into a second, preallocated
+// console which then runs the extra frames with the same input, so the real
+// console never has to be rolled back.
+class RunAhead {
+  RunAhead(const RunAhead&) = delete;
+  RunAhead& operator=(const RunAhead&) = delete;
+
+ public:
+  RunAhead(Console& aconsole, uint32_t aframes);
+  ~RunAhead() = default;
+
+  // runs one frame of the console and returns the console to present
+  Console& frame();
+  uint32_t getFrames() const { return frames; }
+  // average host microseconds per frame emulated ahead, state copy included
+  double costPerFrame() const;
+
+  Console ahead;
+
+ private:
+  Console& console;
+  uint32_t frames;
+  vector<uint8_t> state;
+  uint32_t since = 0;
+  uint64_t emulated = 0;
+  uint64_t elapsed = 0;
+};
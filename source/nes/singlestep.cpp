@@ -0,0 +1,271 @@
+#include "singlestep.hpp"
+
+#include "json.hpp"
+#include "memorybus.hpp"
+#include "rom.hpp"
+
+using std::atomic;
+using std::make_shared;
+using std::thread;
+
+CpuCore::CpuCore(Backend backend) {
+  memory = make_shared<Memory>(0x0000, 0xffff);
+  auto bus = make_shared<MemoryBus>();
+  bus->connect(memory);
+  cpu = make_shared<CPU>(bus);
+  cpu->setBackend(backend);
+}
+
+void CpuCore::set(const StepState& state) {
+  for (auto& cell : state.ram) {
+    memory->write8(cell.first, cell.second);
+  }
+  if (cpu->recompiler) {
+    cpu->recompiler->flush();
+  }
+  cpu->pc = state.pc;
+  cpu->sp = state.s;
+  cpu->a = state.a;
+  cpu->x = state.x;
+  cpu->y = state.y;
+  cpu->setStatus(state.p);
+  cpu->cycles = 0;
+}
+
+uint32_t CpuCore::step() {
+  cpu->step();
+  return cpu->cycles;
+}
+
+void CpuCore::get(StepState& state) {
+  state.pc = cpu->pc;
+  state.s = cpu->sp;
+  state.a = cpu->a;
+  state.x = cpu->x;
+  state.y = cpu->y;
+  state.p = cpu->getStatus();
+  for (auto& cell : state.ram) {
+    cell.second = memory->read8(cell.first);
+  }
+}
+
+void LockstepCore::set(const StepState& state) {
+  auto ram = lockstep.getRam(0);
+  for (auto& cell : state.ram) {
+    ram[cell.first] = cell.second;
+  }
+  lockstep.pc[0] = state.pc;
+  lockstep.sp[0] = state.s;
+  lockstep.a[0] = state.a;
+  lockstep.x[0] = state.x;
+  lockstep.y[0] = state.y;
+  lockstep.setStatus(0, state.p);
+  lockstep.cycles[0] = 0;
+}
+
+uint32_t LockstepCore::step() {
+  lockstep.step();
+  return lockstep.cycles[0];
+}
+
+void LockstepCore::get(StepState& state) {
+  state.pc = lockstep.pc[0];
+  state.s = lockstep.sp[0];
+  state.a = lockstep.a[0];
+  state.x = lockstep.x[0];
+  state.y = lockstep.y[0];
+  state.p = lockstep.getStatus(0);
+  auto ram = lockstep.getRam(0);
+  for (auto& cell : state.ram) {
+    cell.second = ram[cell.first];
+  }
+}
+
+SingleStep::SingleStep(Factory afactory, uint32_t athreads)
+    : factory(afactory), threads(athreads) {
+  if (threads == 0) {
+    threads = std::max(1u, thread::hardware_concurrency());
+  }
+}
+
+// reads an array of count numbers, optionally followed by a string
+static void parseTuple(JsonReader& reader, double* numbers, uint32_t count,
+                       string* text = nullptr) {
+  reader.beginArray();
+  for (uint32_t i = 0; reader.nextItem(); i++) {
+    if (i < count) {
+      reader.readNumber(numbers[i]);
+    } else if (i == count && text) {
+      reader.readString(*text);
+    } else {
+      reader.skip();
+    }
+  }
+}
+
+static uint8_t* getRegister(StepState& state, const string& key) {
+  if (key.size() != 1) {
+    return nullptr;
+  }
+  switch (key[0]) {
+    case 's':
+      return &state.s;
+    case 'a':
+      return &state.a;
+    case 'x':
+      return &state.x;
+    case 'y':
+      return &state.y;
+    case 'p':
+      return &state.p;
+    default:
+      return nullptr;
+  }
+}
+
+static bool parseState(JsonReader& reader, StepState& state) {
+  if (!reader.beginObject()) {
+    return false;
+  }
+  string key;
+  double value;
+  while (reader.nextKey(key)) {
+    if (key == "ram") {
+      reader.beginArray();
+      while (reader.nextItem()) {
+        double cell[2] = {};
+        parseTuple(reader, cell, 2);
+        state.ram.emplace_back(uint16_t(cell[0]), uint8_t(cell[1]));
+      }
+    } else if (key == "pc") {
+      reader.readNumber(value);
+      state.pc = value;
+    } else if (auto field = getRegister(state, key)) {
+      reader.readNumber(value);
+      *field = value;
+    } else {
+      reader.skip();
+    }
+  }
+  return !reader.failed();
+}
+
+static bool parseCycles(JsonReader& reader, vector<StepCycle>& cycles) {
+  reader.beginArray();
+  while (reader.nextItem()) {
+    double access[2] = {};
+    string kind;
+    parseTuple(reader, access, 2, &kind);
+    cycles.push_back(
+        {uint16_t(access[0]), uint8_t(access[1]), kind == "write"});
+  }
+  return !reader.failed();
+}
+
+bool SingleStep::parse(const char* text, size_t size,
+                       vector<StepVector>& vectors) {
+  JsonReader reader(text, size);
+  reader.beginArray();
+  while (reader.nextItem()) {
+    StepVector test;
+    string key;
+    reader.beginObject();
+    while (reader.nextKey(key)) {
+      if (key == "name") {
+        reader.readString(test.name);
+      } else if (key == "initial") {
+        parseState(reader, test.initial);
+      } else if (key == "final") {
+        parseState(reader, test.final);
+      } else if (key == "cycles") {
+        parseCycles(reader, test.cycles);
+      } else {
+        reader.skip();
+      }
+    }
+    if (reader.failed()) {
+      break;
+    }
+    vectors.push_back(std::move(test));
+  }
+  return !reader.failed() && reader.atEnd();
+}
+
+bool SingleStep::load(const string& path, vector<StepVector>& vectors) {
+  Rom file(path);
+  return file.valid() &&
+         parse(reinterpret_cast<const char*>(file.getData()), file.getSize(),
+               vectors);
+}
+
+static string describe(const StepState& state, uint32_t cycles) {
+  char text[80];
+  snprintf(text, sizeof(text),
+           "pc:%04x s:%02x a:%02x x:%02x y:%02x p:%02x cycles:%u", state.pc,
+           state.s, state.a, state.x, state.y, state.p, cycles);
+  string result = text;
+  for (auto& cell : state.ram) {
+    snprintf(text, sizeof(text), " [%04x]=%02x", cell.first, cell.second);
+    result += text;
+  }
+  return result;
+}
+
+bool SingleStep::check(StepCore& core, const StepVector& test,
+                       string& report) {
+  core.set(test.initial);
+  auto cycles = core.step();
+  auto actual = test.final;
+  core.get(actual);
+
+  auto& expected = test.final;
+  auto same = actual.pc == expected.pc && actual.s == expected.s &&
+              actual.a == expected.a && actual.x == expected.x &&
+              actual.y == expected.y && actual.p == expected.p &&
+              actual.ram == expected.ram && cycles == test.cycles.size();
+  if (!same) {
+    report = test.name + "\n  expected " +
+             describe(expected, test.cycles.size()) + "\n  actual   " +
+             describe(actual, cycles);
+  }
+  return same;
+}
+
+vector<StepFileResult> SingleStep::run(const vector<string>& paths) {
+  vector<StepFileResult> results(paths.size());
+  atomic<uint32_t> next(0);
+  auto work = [&]() {
+    auto core = factory();
+    vector<StepVector> vectors;
+    string report;
+    for (uint32_t i; (i = next++) < paths.size();) {
+      auto& result = results[i];
+      result.path = paths[i];
+      vectors.clear();
+      if (!load(paths[i], vectors)) {
+        result.report = "cannot parse " + paths[i];
+        result.failures = 1;
+        continue;
+      }
+      result.vectors = vectors.size();
+      for (auto& test : vectors) {
+        if (!check(*core, test, report)) {
+          if (result.failures++ == 0) {
+            result.report = report;
+          }
+        }
+      }
+    }
+  };
+
+  vector<thread> workers;
+  auto count = std::min<uint32_t>(threads, paths.size());
+  for (uint32_t i = 1; i < count; i++) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return results;
+}
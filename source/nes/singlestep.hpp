@@ -0,0 +1,116 @@
+#pragma once
+
+#include "lockstep.hpp"
+#include "memory.hpp"
+
+using std::function;
+using std::pair;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+// Registers plus the RAM cells a single-step vector lists.
+struct StepState {
+  uint16_t pc = 0;
+  uint8_t s = 0;
+  uint8_t a = 0;
+  uint8_t x = 0;
+  uint8_t y = 0;
+  uint8_t p = 0;
+  vector<pair<uint16_t, uint8_t>> ram;
+};
+
+struct StepCycle {
+  uint16_t address;
+  uint8_t value;
+  bool write;
+};
+
+// One instruction in the single-step JSON format: the state before, the
+// state after and every bus access it makes.
+struct StepVector {
+  string name;
+  StepState initial;
+  StepState final;
+  vector<StepCycle> cycles;
+};
+
+// A 6502 implementation under test. set() installs registers and RAM cells,
+// step() executes one instruction and returns its cycles, get() fills the
+// registers and the values of the RAM cells already listed in state.
+class StepCore {
+ public:
+  virtual ~StepCore() = default;
+  virtual void set(const StepState& state) = 0;
+  virtual uint32_t step() = 0;
+  virtual void get(StepState& state) = 0;
+};
+
+// CPU on a flat 64 KB memory, interpreted or recompiled.
+class CpuCore : public StepCore {
+  CpuCore(const CpuCore&) = delete;
+  CpuCore& operator=(const CpuCore&) = delete;
+
+ public:
+  CpuCore(Backend backend = Backend::Interpreter);
+  virtual ~CpuCore() = default;
+  virtual void set(const StepState& state) override;
+  virtual uint32_t step() override;
+  virtual void get(StepState& state) override;
+
+ private:
+  shared_ptr<Memory> memory;
+  shared_ptr<CPU> cpu;
+};
+
+// Lane 0 of the lockstep core; the other lanes run alongside untouched.
+class LockstepCore : public StepCore {
+  LockstepCore(const LockstepCore&) = delete;
+  LockstepCore& operator=(const LockstepCore&) = delete;
+
+ public:
+  LockstepCore() = default;
+  virtual ~LockstepCore() = default;
+  virtual void set(const StepState& state) override;
+  virtual uint32_t step() override;
+  virtual void get(StepState& state) override;
+
+ private:
+  Lockstep<8> lockstep;
+};
+
+struct StepFileResult {
+  string path;
+  uint32_t vectors = 0;
+  uint32_t failures = 0;
+  // what went wrong with the first failing vector, or the load error
+  string report;
+};
+
+// Runs files of single-step vectors against cores from a factory, one
+// core per thread. Workers take whole files from a shared atomic cursor
+// since parsing dominates. The bus accesses of a vector are only checked
+// by count against the cycles spent; none of the cores models individual
+// bus cycles.
+class SingleStep {
+  SingleStep(const SingleStep&) = delete;
+  SingleStep& operator=(const SingleStep&) = delete;
+
+ public:
+  using Factory = function<unique_ptr<StepCore>()>;
+
+  SingleStep(Factory afactory, uint32_t athreads = 0);
+  ~SingleStep() = default;
+
+  static bool parse(const char* text, size_t size, vector<StepVector>& vectors);
+  static bool load(const string& path, vector<StepVector>& vectors);
+  // true when the core ends in the final state, otherwise report says why
+  static bool check(StepCore& core, const StepVector& test, string& report);
+
+  vector<StepFileResult> run(const vector<string>& paths);
+  uint32_t getThreads() const { return threads; }
+
+ private:
+  Factory factory;
+  uint32_t threads;
+};
@@ -0,0 +1,60 @@
+#include "tracer.hpp"
+
+#include "disassembler.hpp"
+#include "endian.hpp"
+
+using std::ios;
+
+// where nestest logs put the registers
+#define TRACE_REGISTERS_COLUMN 48
+
+uint64_t TraceRecord::getCycle() const { return getLE(cycle, sizeof(cycle)); }
+
+Tracer::Tracer(const string& path, uint64_t acycle, uint32_t records)
+    : file(path, ios::binary), buffer(records ? records : 1), cycle(acycle) {
+  uint8_t header[TRACE_HEADER_SIZE];
+  auto ptr = putLE(header, TRACE_MAGIC, 4);
+  ptr = putLE(ptr, TRACE_VERSION, 2);
+  putLE(ptr, sizeof(TraceRecord), 2);
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+Tracer::~Tracer() { flush(); }
+
+void Tracer::flush() {
+  file.write(reinterpret_cast<const char*>(buffer.data()),
+             used * sizeof(TraceRecord));
+  file.flush();
+  records += used;
+  used = 0;
+}
+
+TraceReader::TraceReader(const string& path) : file(path, ios::binary) {
+  uint8_t header[TRACE_HEADER_SIZE];
+  file.read(reinterpret_cast<char*>(header), sizeof(header));
+  ok = file.good() && getLE(header, 4) == TRACE_MAGIC &&
+       getLE(header + 4, 2) == TRACE_VERSION &&
+       getLE(header + 6, 2) == sizeof(TraceRecord);
+}
+
+bool TraceReader::next(TraceRecord& record) {
+  if (!ok) {
+    return false;
+  }
+  file.read(reinterpret_cast<char*>(&record), sizeof(record));
+  return file.gcount() == sizeof(record);
+}
+
+string TraceReader::render(const TraceRecord& record) {
+  uint8_t code[] = {record.opcode, record.operands[0], record.operands[1]};
+  char line[128];
+  auto len = Disassembler::line(record.getPc(), code, line);
+  while (len < TRACE_REGISTERS_COLUMN) {
+    line[len++] = ' ';
+  }
+  snprintf(line + len, sizeof(line) - len,
+           "A:%02X X:%02X Y:%02X P:%02X SP:%02X CYC:%llu", record.a, record.x,
+           record.y, record.p, record.sp,
+           (unsigned long long)record.getCycle());
+  return line;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "cpu.hpp"
+
+using std::ifstream;
+using std::ofstream;
+using std::string;
+using std::vector;
+
+#define TRACE_MAGIC 0x4352544e  // "NTRC"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 8
+#define TRACE_BUFFER_RECORDS 0x10000
+
+// One executed instruction with the registers before it ran. Multi-byte
+// fields are stored little-endian as bytes so the struct is written as is.
+struct TraceRecord {
+  uint8_t pc[2];
+  uint8_t opcode;
+  uint8_t operands[2];
+  uint8_t a;
+  uint8_t x;
+  uint8_t y;
+  uint8_t p;
+  uint8_t sp;
+  uint8_t cycle[6];
+
+  uint16_t getPc() const { return pc[0] | (pc[1] << 8); }
+  uint64_t getCycle() const;
+};
+
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord must stay 16 bytes");
+
+// Appends a record per instruction to a trace file. Pass it as the hooks of
+// CPU::run() or Console::frame(); records are collected in a preallocated
+// buffer written out whenever it fills. The file is a header, magic u32,
+// version u16 and record size u16, followed by the records.
+class Tracer : public NoHooks {
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+ public:
+  // cycle is the count the first record shows
+  Tracer(const string& path, uint64_t acycle = 0,
+         uint32_t records = TRACE_BUFFER_RECORDS);
+  ~Tracer();
+
+  bool valid() const { return file.good(); }
+
+  void fetch(const CPU& cpu) {
+    auto& record = buffer[used];
+    record.pc[0] = cpu.pc;
+    record.pc[1] = cpu.pc >> 8;
+    record.opcode = cpu.opcodeInfo.opcode;
+    record.operands[0] = 0;
+    record.operands[1] = 0;
+    if (cpu.opcodeInfo.bytes >= 2) {
+      cpu.bus->peek(cpu.pc + 1, record.operands, cpu.opcodeInfo.bytes - 1);
+    }
+    record.a = cpu.a;
+    record.x = cpu.x;
+    record.y = cpu.y;
+    record.p = cpu.getStatus();
+    record.sp = cpu.sp;
+    for (uint32_t i = 0; i < sizeof(record.cycle); i++) {
+      record.cycle[i] = cycle >> (8 * i);
+    }
+  }
+  void instruction(uint16_t, uint8_t, uint32_t cycles) {
+    cycle += cycles;
+    if (++used == buffer.size()) {
+      flush();
+    }
+  }
+  void flush();
+  uint64_t getRecords() const { return records + used; }
+
+ private:
+  ofstream file;
+  vector<TraceRecord> buffer;
+  uint32_t used = 0;
+  uint64_t cycle;
+  uint64_t records = 0;
+};
+
+// Reads back the records of a trace file.
+class TraceReader {
+  TraceReader(const TraceReader&) = delete;
+  TraceReader& operator=(const TraceReader&) = delete;
+
+ public:
+  TraceReader(const string& path);
+  ~TraceReader() = default;
+
+  bool valid() const { return ok; }
+  bool next(TraceRecord& record);
+
+  // nestest log style line: PC, instruction bytes, disassembly, registers
+  // and cycle count, e.g.
+  // C000  4C F5 C5  JMP $C5F5                       A:00 X:00 Y:00 P:24 ...
+  static string render(const TraceRecord& record);
+
+ private:
+  ifstream file;
+  bool ok = false;
+};
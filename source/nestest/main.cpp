@@ -0,0 +1,67 @@
+#include "nes/console.hpp"
+#include "nes/goldenlog.hpp"
+
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+// runs the checked part of the log runs times from a pristine copy of the
+// console and returns the instructions per second
+static double bench(Console& pristine, Backend backend, uint64_t cycles,
+                    uint32_t instructions, uint32_t runs) {
+  duration<double> elapsed(0);
+  for (uint32_t i = 0; i < runs; i++) {
+    auto console = pristine.fork();
+    console->cpu->setBackend(backend);
+    GoldenLog::startNestest(*console->cpu);
+    auto begin = steady_clock::now();
+    console->cpu->run(cycles);
+    elapsed += steady_clock::now() - begin;
+  }
+  return double(instructions) * runs / elapsed.count();
+}
+
+// nes-nestest nestest.nes nestest.log [runs]
+// checks the CPU against the official opcode section of the nestest log,
+// then times that section runs times on every backend
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s nestest.nes nestest.log [runs]\n", argv[0]);
+    return 1;
+  }
+  Rom rom(argv[1]);
+  Console console;
+  if (!rom.valid() || !console.loadCartridge(rom)) {
+    fprintf(stderr, "Cannot load cartridge %s\n", argv[1]);
+    return 1;
+  }
+  GoldenLog log;
+  if (!log.load(argv[2])) {
+    fprintf(stderr, "Cannot read log %s\n", argv[2]);
+    return 1;
+  }
+
+  auto pristine = console.fork();
+  GoldenLog::startNestest(*console.cpu);
+  while (!log.done() && !log.failed()) {
+    console.cpu->step(log);
+  }
+  if (log.failed()) {
+    fprintf(stderr, "Mismatch at %s\n", log.getMismatch().c_str());
+    return 1;
+  }
+  printf("%u instructions match\n", log.getChecked());
+
+  auto runs = argc > 3 ? strtoul(argv[3], nullptr, 0) : 0;
+  if (runs) {
+    auto cycles = log.getCycle() - NESTEST_START_CYCLE;
+    printf("interpreter %.1f M instructions/s\n",
+           bench(*pristine, Backend::Interpreter, cycles, log.getChecked(),
+                 runs) /
+               1e6);
+    printf("recompiler  %.1f M instructions/s\n",
+           bench(*pristine, Backend::Recompiler, cycles, log.getChecked(),
+                 runs) /
+               1e6);
+  }
+  return 0;
+}
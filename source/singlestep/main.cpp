@@ -0,0 +1,87 @@
+#include <filesystem>
+
+#include "nes/singlestep.hpp"
+
+using std::make_unique;
+using std::sort;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+// nes-singlestep dir [--core interpreter|recompiler|lockstep] [--threads n]
+//                [--all]
+// runs every <opcode>.json of single-step vectors in dir, skipping opcodes
+// the CPU does not implement unless --all is given
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr,
+            "usage: %s dir [--core interpreter|recompiler|lockstep] "
+            "[--threads n] [--all]\n",
+            argv[0]);
+    return 1;
+  }
+  string core = "interpreter";
+  uint32_t threads = 0;
+  auto all = false;
+  for (auto i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--core") == 0 && i + 1 < argc) {
+      core = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = strtoul(argv[++i], nullptr, 0);
+    } else if (strcmp(argv[i], "--all") == 0) {
+      all = true;
+    }
+  }
+
+  SingleStep::Factory factory;
+  if (core == "interpreter") {
+    factory = [] { return make_unique<CpuCore>(Backend::Interpreter); };
+  } else if (core == "recompiler") {
+    factory = [] { return make_unique<CpuCore>(Backend::Recompiler); };
+  } else if (core == "lockstep") {
+    factory = [] { return make_unique<LockstepCore>(); };
+  } else {
+    fprintf(stderr, "Unknown core %s\n", core.c_str());
+    return 1;
+  }
+
+  vector<string> paths;
+  std::error_code error;
+  auto table = CPU::opcodeTable();
+  for (auto& entry : fs::directory_iterator(argv[1], error)) {
+    auto name = entry.path().stem().string();
+    if (entry.path().extension() != ".json" || name.size() != 2) {
+      continue;
+    }
+    auto opcode = strtoul(name.c_str(), nullptr, 16);
+    if (all || strcmp(table[opcode].mnemonic, "XXX") != 0) {
+      paths.push_back(entry.path().string());
+    }
+  }
+  if (error || paths.empty()) {
+    fprintf(stderr, "No vectors found in %s\n", argv[1]);
+    return 1;
+  }
+  sort(paths.begin(), paths.end());
+
+  SingleStep harness(factory, threads);
+  auto start = steady_clock::now();
+  auto results = harness.run(paths);
+  duration<double> elapsed = steady_clock::now() - start;
+
+  uint64_t vectors = 0;
+  uint64_t failures = 0;
+  for (auto& result : results) {
+    vectors += result.vectors;
+    failures += result.failures;
+    if (result.failures) {
+      printf("%s: %u of %u failed, first %s\n", result.path.c_str(),
+             result.failures, result.vectors, result.report.c_str());
+    }
+  }
+  printf("%llu vectors in %zu files, %llu failed, %.2f s on %u threads\n",
+         (unsigned long long)vectors, results.size(),
+         (unsigned long long)failures, elapsed.count(),
+         harness.getThreads());
+  return failures ? 1 : 0;
+}
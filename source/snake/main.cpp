@@ -1,11 +1,18 @@
-#include "nes/cpu.hpp"
-#include "nes/memory.hpp"
-#include "nes/memorybus.hpp"
+#include "nes/console.hpp"
+#include "nes/coverage.hpp"
+#include "nes/movie.hpp"
+#include "nes/profiler.hpp"
+#include "nes/tracer.hpp"
 #include "raylib.h"
+#include "snake.hpp"
 
 using std::make_shared;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+using std::mt19937;
+using std::random_device;
 
-#define PROGRAM_ADDR 0x0600
+#define CYCLES_PER_FRAME 400
 #define RANDOM_ADDR 0x00fe
 #define BUTTON_ADDR 0x00ff
 #define SCREEN_ADDR 0x0200
@@ -13,34 +20,6 @@ using std::make_shared;
 #define SCREEN_HEIGHT 32
 #define SCREEN_SIZE 1024
 
-static uint8_t code[309] = {
-    0x20, 0x06, 0x06, 0x20, 0x38, 0x06, 0x20, 0x0d, 0x06, 0x20, 0x2a, 0x06,
-    0x60, 0xa9, 0x02, 0x85, 0x02, 0xa9, 0x04, 0x85, 0x03, 0xa9, 0x11, 0x85,
-    0x10, 0xa9, 0x10, 0x85, 0x12, 0xa9, 0x0f, 0x85, 0x14, 0xa9, 0x04, 0x85,
-    0x11, 0x85, 0x13, 0x85, 0x15, 0x60, 0xa5, 0xfe, 0x85, 0x00, 0xa5, 0xfe,
-    0x29, 0x03, 0x18, 0x69, 0x02, 0x85, 0x01, 0x60, 0x20, 0x4d, 0x06, 0x20,
-    0x8d, 0x06, 0x20, 0xc3, 0x06, 0x20, 0x19, 0x07, 0x20, 0x20, 0x07, 0x20,
-    0x2d, 0x07, 0x4c, 0x38, 0x06, 0xa5, 0xff, 0xc9, 0x77, 0xf0, 0x0d, 0xc9,
-    0x64, 0xf0, 0x14, 0xc9, 0x73, 0xf0, 0x1b, 0xc9, 0x61, 0xf0, 0x22, 0x60,
-    0xa9, 0x04, 0x24, 0x02, 0xd0, 0x26, 0xa9, 0x01, 0x85, 0x02, 0x60, 0xa9,
-    0x08, 0x24, 0x02, 0xd0, 0x1b, 0xa9, 0x02, 0x85, 0x02, 0x60, 0xa9, 0x01,
-    0x24, 0x02, 0xd0, 0x10, 0xa9, 0x04, 0x85, 0x02, 0x60, 0xa9, 0x02, 0x24,
-    0x02, 0xd0, 0x05, 0xa9, 0x08, 0x85, 0x02, 0x60, 0x60, 0x20, 0x94, 0x06,
-    0x20, 0xa8, 0x06, 0x60, 0xa5, 0x00, 0xc5, 0x10, 0xd0, 0x0d, 0xa5, 0x01,
-    0xc5, 0x11, 0xd0, 0x07, 0xe6, 0x03, 0xe6, 0x03, 0x20, 0x2a, 0x06, 0x60,
-    0xa2, 0x02, 0xb5, 0x10, 0xc5, 0x10, 0xd0, 0x06, 0xb5, 0x11, 0xc5, 0x11,
-    0xf0, 0x09, 0xe8, 0xe8, 0xe4, 0x03, 0xf0, 0x06, 0x4c, 0xaa, 0x06, 0x4c,
-    0x35, 0x07, 0x60, 0xa6, 0x03, 0xca, 0x8a, 0xb5, 0x10, 0x95, 0x12, 0xca,
-    0x10, 0xf9, 0xa5, 0x02, 0x4a, 0xb0, 0x09, 0x4a, 0xb0, 0x19, 0x4a, 0xb0,
-    0x1f, 0x4a, 0xb0, 0x2f, 0xa5, 0x10, 0x38, 0xe9, 0x20, 0x85, 0x10, 0x90,
-    0x01, 0x60, 0xc6, 0x11, 0xa9, 0x01, 0xc5, 0x11, 0xf0, 0x28, 0x60, 0xe6,
-    0x10, 0xa9, 0x1f, 0x24, 0x10, 0xf0, 0x1f, 0x60, 0xa5, 0x10, 0x18, 0x69,
-    0x20, 0x85, 0x10, 0xb0, 0x01, 0x60, 0xe6, 0x11, 0xa9, 0x06, 0xc5, 0x11,
-    0xf0, 0x0c, 0x60, 0xc6, 0x10, 0xa5, 0x10, 0x29, 0x1f, 0xc9, 0x1f, 0xf0,
-    0x01, 0x60, 0x4c, 0x35, 0x07, 0xa0, 0x00, 0xa5, 0xfe, 0x91, 0x00, 0x60,
-    0xa6, 0x03, 0xa9, 0x00, 0x81, 0x10, 0xa2, 0x00, 0xa9, 0x01, 0x81, 0x10,
-    0x60, 0xa2, 0x00, 0xea, 0xea, 0xca, 0xd0, 0xfb, 0x60};
-
 int32_t getColor(Color color) {
   return (color.r << 24) | (color.g << 16) | (color.b << 8) | color.a;
 }
@@ -68,16 +47,92 @@ int32_t getColor(uint8_t value) {
   }
 }
 
-void handleKeys(shared_ptr<Memory> memory) {
+uint8_t handleKeys() {
   if (IsKeyDown(KEY_W)) {
-    memory->write8(BUTTON_ADDR, 0x77);
+    return 0x77;
   } else if (IsKeyDown(KEY_S)) {
-    memory->write8(BUTTON_ADDR, 0x73);
+    return 0x73;
   } else if (IsKeyDown(KEY_A)) {
-    memory->write8(BUTTON_ADDR, 0x61);
+    return 0x61;
   } else if (IsKeyDown(KEY_D)) {
-    memory->write8(BUTTON_ADDR, 0x64);
+    return 0x64;
+  }
+  return 0x00;
+}
+
+void setup(Console& console, mt19937& random, uint32_t seed) {
+  console.loadProgram(SNAKE_PROGRAM_ADDR, SNAKE_PROGRAM,
+                      sizeof(SNAKE_PROGRAM));
+  console.cyclesPerFrame = CYCLES_PER_FRAME;
+  console.reset();
+  random.seed(seed);
+}
+
+// everything the program sees from outside comes through here, so a movie of
+// the inputs and the seed replays the same game
+template <typename Hooks = NoHooks>
+void frame(Console& console, mt19937& random, uint8_t input,
+           Hooks* hooks = nullptr) {
+  if (input) {
+    console.memory->write8(BUTTON_ADDR, input);
+  }
+  console.memory->write8(RANDOM_ADDR, random());
+  if (hooks) {
+    console.frame(*hooks);
+  } else {
+    console.frame();
+  }
+}
+
+int play(const char* path, const char* profile, const char* cover) {
+  Movie movie;
+  if (!movie.load(path)) {
+    fprintf(stderr, "Cannot load movie %s\n", path);
+    return 1;
+  }
+
+  Console console;
+  mt19937 random;
+  setup(console, random, movie.seed);
+  shared_ptr<Profiler> profiler;
+  if (profile) {
+    profiler = make_shared<Profiler>();
+  }
+  shared_ptr<Coverage> coverage;
+  if (cover) {
+    coverage = make_shared<Coverage>();
   }
+  auto start = steady_clock::now();
+  for (auto input : movie.inputs) {
+    if (coverage) {
+      frame(console, random, input, coverage.get());
+    } else {
+      frame(console, random, input, profiler.get());
+    }
+  }
+  duration<double> elapsed = steady_clock::now() - start;
+  if (profiler) {
+    profiler->report(std::cout);
+    if (!profiler->saveCsv(profile)) {
+      fprintf(stderr, "Cannot save profile %s\n", profile);
+    }
+  }
+  if (coverage) {
+    coverage->report(std::cout);
+    if (!coverage->saveCdl(cover)) {
+      fprintf(stderr, "Cannot save coverage %s\n", cover);
+    }
+  }
+
+  auto hash = Movie::hashRam(console);
+  printf("frames %u hash %016llx fps %.0f\n", movie.frames(),
+         (unsigned long long)hash, movie.frames() / elapsed.count());
+  if (hash != movie.hash) {
+    fprintf(stderr, "Hash mismatch, movie expects %016llx\n",
+            (unsigned long long)movie.hash);
+    return 1;
+  }
+  return 0;
 }
 
 void getScreen(shared_ptr<Memory> memory, int32_t* video) {
@@ -117,31 +172,68 @@ void draw(int32_t* video) {
   UnloadTexture(texture);
 }
 
-int main() {
+// snake [--record movie] [--play movie [--profile csv | --coverage cdl]]
+//       [--seed n] [--trace file]
+int main(int argc, char* argv[]) {
+  const char* record = nullptr;
+  const char* trace = nullptr;
+  const char* replay = nullptr;
+  const char* profile = nullptr;
+  const char* cover = nullptr;
+  Movie movie;
+  movie.seed = random_device()();
+  for (auto i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--play") == 0) {
+      replay = argv[i + 1];
+    } else if (strcmp(argv[i], "--profile") == 0) {
+      profile = argv[i + 1];
+    } else if (strcmp(argv[i], "--coverage") == 0) {
+      cover = argv[i + 1];
+    } else if (strcmp(argv[i], "--trace") == 0) {
+      trace = argv[i + 1];
+    } else if (strcmp(argv[i], "--record") == 0) {
+      record = argv[i + 1];
+    } else if (strcmp(argv[i], "--seed") == 0) {
+      movie.seed = strtoul(argv[i + 1], nullptr, 0);
+    }
+  }
+  // a frame runs with one set of hooks
+  if (profile && cover) {
+    fprintf(stderr, "--profile and --coverage cannot be combined\n");
+    return 1;
+  }
+  if (replay) {
+    return play(replay, profile, cover);
+  }
+  shared_ptr<Tracer> tracer;
+  if (trace) {
+    tracer = make_shared<Tracer>(trace);
+    if (!tracer->valid()) {
+      fprintf(stderr, "Cannot write trace %s\n", trace);
+      return 1;
+    }
+  }
+
   // Initialization
   auto screenWidth = 32 * SCREEN_WIDTH;
   auto screenHeight = 32 * SCREEN_HEIGHT;
   SetTraceLogLevel(LOG_NONE);
   InitWindow(screenWidth, screenHeight, "raylib Snake");
+  SetTargetFPS(60);
 
-  auto memory = make_shared<Memory>(0x0000, 0xffff);
-  memory->set(PROGRAM_ADDR, code, sizeof(code));
-  memory->write16(RESET_PROC_ADDR, PROGRAM_ADDR);
-  uint8_t color = rand() % 8;
-  memory->write8(RANDOM_ADDR, color);
-  auto bus = make_shared<MemoryBus>();
-  bus->connect(memory);
-  auto cpu = make_shared<CPU>(bus, true);
-  cpu->reset();
+  Console console;
+  mt19937 random;
+  setup(console, random, movie.seed);
 
   int32_t video[SCREEN_SIZE];
 
   // Main game loop
   while (!WindowShouldClose()) {
     // Update
-    cpu->clock(true);
-    handleKeys(memory);
-    getScreen(memory, video);
+    auto input = handleKeys();
+    movie.record(input);
+    frame(console, random, input, tracer.get());
+    getScreen(console.memory, video);
     // Draw
     draw(video);
   }
@@ -149,5 +241,13 @@ int main() {
   // De-Initialization
   CloseWindow();
 
+  if (record) {
+    movie.hash = Movie::hashRam(console);
+    if (!movie.save(record)) {
+      fprintf(stderr, "Cannot save movie %s\n", record);
+      return 1;
+    }
+  }
+
   return 0;
 }
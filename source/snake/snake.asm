@@ -419,11 +419,6 @@ drawApple:
 
 
 drawSnake:
-  ldx #0      ;set the value of the X register to 0
-  lda #1      ;set the value of the A register to 1
-  sta ($10,x) ;dereference to the memory address that's stored at address
-              ;$10 (the two bytes for the location of the head of the snake) and
-              ;set its value to the one stored in register A
   ldx $03     ;set the value of the x register to the value stored in memory at
               ;location $03 (the length of the snake)
   lda #0      ;set the value of the a register to 0
@@ -433,6 +428,13 @@ drawSnake:
               ;tail. Because the snake is moving, the head "draws" on the screen in
               ;white as it moves, and the tail works as an eraser, erasing the white trail
               ;using black pixels
+  ;erase the tail before drawing the head, the head may have just moved
+  ;onto the old tail
+  ldx #0      ;set the value of the X register to 0
+  lda #1      ;set the value of the A register to 1
+  sta ($10,x) ;dereference to the memory address that's stored at address
+              ;$10 (the two bytes for the location of the head of the snake) and
+              ;set its value to the one stored in register A
   rts         ;return
 
 
@@ -0,0 +1,21 @@
+#include "nes/tracer.hpp"
+
+// nes-trace trace.bin [count]
+// renders a binary trace as a nestest style log on stdout
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s trace.bin [count]\n", argv[0]);
+    return 1;
+  }
+  TraceReader reader(argv[1]);
+  if (!reader.valid()) {
+    fprintf(stderr, "Cannot read trace %s\n", argv[1]);
+    return 1;
+  }
+  auto count = argc > 2 ? strtoull(argv[2], nullptr, 0) : ~0ull;
+  TraceRecord record;
+  for (uint64_t i = 0; i < count && reader.next(record); i++) {
+    puts(TraceReader::render(record).c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "nes/assembler.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/console.hpp"
+#include "nes/hash.hpp"
+
+using testing::Test;
+
+class AssemblerTest : public Test {
+ protected:
+  Assembler assembler;
+
+  vector<uint8_t> assemble(const string& source) {
+    EXPECT_TRUE(assembler.assemble(source)) << assembler.getError();
+    return assembler.getCode();
+  }
+};
+
+TEST_F(AssemblerTest, AddressingModes) {
+  auto code = assemble(
+      "  nop\n"
+      "  asl\n"
+      "  rol a\n"
+      "  lda #$10\n"
+      "  lda $10\n"
+      "  lda $10,x\n"
+      "  ldx $10,y\n"
+      "  lda $1234\n"
+      "  lda $1234,x\n"
+      "  lda $1234,y\n"
+      "  jmp ($1234)\n"
+      "  lda ($10,x)\n"
+      "  lda ($10),y\n"
+      "  lda $0010\n"
+      "  lda $10,y\n");
+  vector<uint8_t> expected = {
+      0xea, 0x0a, 0x2a, 0xa9, 0x10, 0xa5, 0x10, 0xb5, 0x10, 0xb6, 0x10,
+      0xad, 0x34, 0x12, 0xbd, 0x34, 0x12, 0xb9, 0x34, 0x12, 0x6c, 0x34,
+      0x12, 0xa1, 0x10, 0xb1, 0x10, 0xad, 0x10, 0x00, 0xb9, 0x10, 0x00};
+  ASSERT_EQ(code, expected);
+}
+
+TEST_F(AssemblerTest, LabelsAndBranches) {
+  auto code = assemble(
+      "start:\n"
+      "  ldx #3\n"
+      "loop: dex\n"
+      "  bne loop\n"
+      "  beq done\n"
+      "  jmp start\n"
+      "done:\n"
+      "  lda table,x\n"
+      "  rts\n"
+      "table:\n");
+  vector<uint8_t> expected = {0xa2, 0x03, 0xca, 0xd0, 0xfd, 0xf0, 0x03,
+                              0x4c, 0x00, 0x06, 0xbd, 0x0e, 0x06, 0x60};
+  ASSERT_EQ(code, expected);
+  uint16_t value;
+  ASSERT_TRUE(assembler.getSymbol("done", value));
+  ASSERT_EQ(value, 0x060a);
+  ASSERT_TRUE(assembler.getSymbol("table", value));
+  ASSERT_EQ(value, 0x060e);
+  ASSERT_FALSE(assembler.getSymbol("missing", value));
+}
+
+TEST_F(AssemblerTest, Directives) {
+  auto code = assemble(
+      "define apple $00\n"
+      "SCREEN = $0200\n"
+      "  *= $c000\n"
+      "  lda apple\n"
+      "  sta SCREEN+1\n"
+      "  lda #<vector\n"
+      "  ldx #>vector\n"
+      "  .org $c00c\n"
+      "vector: .word vector, $1234\n"
+      "  .byte 1, -1, %101, 'A', \"hi;\" ; comment\n"
+      "  dcb 7\n");
+  vector<uint8_t> expected = {0xa5, 0x00, 0x8d, 0x01, 0x02, 0xa9, 0x0c,
+                              0xa2, 0xc0, 0x00, 0x00, 0x00, 0x0c, 0xc0,
+                              0x34, 0x12, 0x01, 0xff, 0x05, 0x41, 0x68,
+                              0x69, 0x3b, 0x07};
+  ASSERT_EQ(code, expected);
+  ASSERT_EQ(assembler.getOrigin(), 0xc000);
+}
+
+TEST_F(AssemblerTest, Errors) {
+  ASSERT_FALSE(assembler.assemble("  lda #1\n  foo $10\n"));
+  ASSERT_EQ(assembler.getError(), "line 2: unknown instruction FOO");
+  ASSERT_FALSE(assembler.assemble("  jmp nowhere\n"));
+  ASSERT_EQ(assembler.getError(), "line 1: unknown symbol nowhere");
+  ASSERT_FALSE(assembler.assemble("  lda #$100\n"));
+  ASSERT_EQ(assembler.getError(), "line 1: value out of range");
+  ASSERT_FALSE(assembler.assemble("a:\na:\n"));
+  ASSERT_EQ(assembler.getError(), "line 2: duplicate symbol a");
+  ASSERT_FALSE(assembler.assemble("  stx $1234,x\n"));
+  ASSERT_EQ(assembler.getError(),
+            "line 1: addressing mode not available for STX");
+  ASSERT_FALSE(assembler.assemble("  beq far\n  .org $0700\nfar:\n"));
+  ASSERT_EQ(assembler.getError(), "line 1: branch out of range");
+}
+
+TEST_F(AssemblerTest, RunsOnCpu) {
+  // sums 1 to 10 into $00
+  auto code = assemble(
+      "  lda #0\n"
+      "  ldx #10\n"
+      "loop:\n"
+      "  stx $01\n"
+      "  clc\n"
+      "  adc $01\n"
+      "  dex\n"
+      "  bne loop\n"
+      "  sta $00\n"
+      "done: jmp done\n");
+  Console console;
+  console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+  console.reset();
+  console.cyclesPerFrame = 500;
+  console.frame();
+  ASSERT_EQ(console.memory->read8(0x00), 55);
+}
+
+TEST_F(AssemblerTest, Snake) {
+  ASSERT_TRUE(assembler.assembleFile(SNAKE_ASM)) << assembler.getError();
+  auto& code = assembler.getCode();
+  ASSERT_EQ(code.size(), 309);
+  // the program snake shipped with when it was copied by hand
+  ASSERT_EQ(hash64(code.data(), code.size()), 0x123985aa71721f2dull);
+  uint16_t gameOver;
+  ASSERT_TRUE(assembler.getSymbol("gameOver", gameOver));
+  ASSERT_EQ(gameOver, 0x0735);
+}
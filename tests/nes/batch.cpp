@@ -0,0 +1,100 @@
+#include "nes/batch.hpp"
+
+#include <gtest/gtest.h>
+
+using std::make_shared;
+using testing::Test;
+
+class BatchTest : public Test {
+ protected:
+  // LDA $ff / CLC / ADC $fe / STA $0300,x / INX / JMP $0600
+  uint8_t code[12] = {0xa5, 0xff, 0x18, 0x65, 0xfe, 0x9d,
+                      0x00, 0x03, 0xe8, 0x4c, 0x00, 0x06};
+
+  vector<BatchJob> jobs(uint32_t count) {
+    auto rom = make_shared<const Rom>(code, sizeof(code));
+    vector<BatchJob> jobs(count);
+    for (uint32_t i = 0; i < count; i++) {
+      jobs[i].rom = rom;
+      jobs[i].frames = 10 + i % 7;
+      jobs[i].cyclesPerFrame = 500;
+      jobs[i].input = [i](Console& console, uint32_t frame) {
+        console.memory->write8(0x00ff, i);
+        console.memory->write8(0x00fe, frame * 3);
+      };
+    }
+    return jobs;
+  }
+};
+
+TEST_F(BatchTest, MatchesSingleThread) {
+  auto batch = jobs(64);
+  BatchRunner single(1);
+  auto expected = single.run(batch);
+
+  for (auto threads : {2u, 3u, 8u}) {
+    BatchRunner runner(threads);
+    ASSERT_EQ(runner.getThreads(), threads);
+    // run twice so the second run starts from consoles the first one used
+    for (auto pass = 0; pass < 2; pass++) {
+      auto results = runner.run(batch);
+      ASSERT_EQ(results.size(), expected.size());
+      for (uint32_t i = 0; i < results.size(); i++) {
+        ASSERT_EQ(results[i].frames, batch[i].frames);
+        ASSERT_EQ(results[i].hash, expected[i].hash) << i;
+        ASSERT_EQ(results[i].cycles, expected[i].cycles) << i;
+      }
+      ASSERT_GT(runner.framesPerSecond(), 0.0);
+    }
+  }
+}
+
+// every worker keeps its console from job to job and run to run, each job
+// must still see only its own ROM, whatever ran there before
+TEST_F(BatchTest, ReusedConsolesMatchFreshOnes) {
+  // LDA #$07 / STA $0301 / JMP $0600, loaded over the same address
+  uint8_t other[] = {0xa9, 0x07, 0x8d, 0x01, 0x03, 0x4c, 0x00, 0x06};
+  auto otherRom = make_shared<const Rom>(other, sizeof(other));
+  auto batch = jobs(24);
+  for (uint32_t i = 0; i < batch.size(); i += 3) {
+    batch[i].rom = otherRom;
+  }
+  for (auto backend : {Backend::Interpreter, Backend::Recompiler}) {
+    BatchRunner runner(3, backend);
+    for (auto pass = 0; pass < 2; pass++) {
+      auto results = runner.run(batch);
+      for (uint32_t i = 0; i < batch.size(); i++) {
+        auto fresh = BatchRunner(1, backend).run({batch[i]});
+        ASSERT_EQ(results[i].hash, fresh[0].hash) << i;
+        ASSERT_EQ(results[i].cycles, fresh[0].cycles) << i;
+      }
+    }
+  }
+}
+
+TEST_F(BatchTest, DistinctJobs) {
+  BatchRunner runner;
+  ASSERT_GE(runner.getThreads(), 1);
+  auto results = runner.run(jobs(8));
+  ASSERT_NE(results[0].hash, results[1].hash);
+}
+
+TEST_F(BatchTest, FewerJobsThanThreads) {
+  BatchRunner runner(8);
+  ASSERT_EQ(runner.run(jobs(3)).size(), 3);
+  ASSERT_TRUE(runner.run({}).empty());
+}
+
+TEST_F(BatchTest, MappedRom) {
+  auto path = testing::TempDir() + "batch.rom";
+  FILE* file = fopen(path.c_str(), "wb");
+  fwrite(code, 1, sizeof(code), file);
+  fclose(file);
+
+  Rom rom(path);
+  ASSERT_TRUE(rom.valid());
+  ASSERT_EQ(rom.getSize(), sizeof(code));
+  ASSERT_EQ(memcmp(rom.getData(), code, sizeof(code)), 0);
+  ASSERT_FALSE(Rom(path + ".missing").valid());
+  remove(path.c_str());
+}
@@ -0,0 +1,238 @@
+#include "nes/console.hpp"
+
+#include <gtest/gtest.h>
+
+#include "programs.hpp"
+
+using testing::Test;
+
+class ConsoleTest : public Test {
+ protected:
+  Console console;
+
+  void SetUp() override {
+    console.loadProgram(LOOP_PROGRAM_ADDR, LOOP_PROGRAM, sizeof(LOOP_PROGRAM));
+    console.reset();
+  }
+};
+
+TEST_F(ConsoleTest, Frame) {
+  uint64_t elapsed = 0;
+  for (auto i = 0; i < 10; i++) {
+    elapsed += console.frame();
+  }
+  ASSERT_EQ(console.frames, 10);
+  ASSERT_EQ(console.cycles, elapsed);
+  ASSERT_GE(console.cycles, 10 * CPU_CYCLES_PER_FRAME);
+  ASSERT_LT(console.cycles, 10 * CPU_CYCLES_PER_FRAME + 8);
+}
+
+TEST_F(ConsoleTest, Header) {
+  vector<uint8_t> state;
+  console.saveState(state);
+  ASSERT_EQ(state.size(), console.stateSize());
+  ASSERT_EQ(memcmp(state.data(), "NESS", 4), 0);
+  ASSERT_EQ(state[4], STATE_VERSION);
+  ASSERT_EQ(state[5], 0x00);
+  ASSERT_EQ(state[8] | (state[9] << 8) | (state[10] << 16) | (state[11] << 24),
+            state.size());
+  ASSERT_EQ(memcmp(state.data() + 12, "CPU ", 4), 0);
+}
+
+TEST_F(ConsoleTest, SaveLoad) {
+  for (auto i = 0; i < 3; i++) {
+    console.frame();
+  }
+  vector<uint8_t> state;
+  console.saveState(state);
+
+  for (auto i = 0; i < 5; i++) {
+    console.frame();
+  }
+  vector<uint8_t> expected;
+  console.saveState(expected);
+
+  ASSERT_TRUE(console.loadState(state));
+  ASSERT_EQ(console.frames, 3);
+  for (auto i = 0; i < 5; i++) {
+    console.frame();
+  }
+  vector<uint8_t> actual;
+  console.saveState(actual);
+  ASSERT_EQ(actual, expected);
+}
+
+TEST_F(ConsoleTest, LoadIntoOtherConsole) {
+  console.cpu->setBackend(Backend::Recompiler);
+  console.frame();
+  vector<uint8_t> state;
+  console.saveState(state);
+
+  Console other;
+  other.cpu->setBackend(Backend::Recompiler);
+  ASSERT_TRUE(other.loadState(state));
+  console.frame();
+  other.frame();
+  ASSERT_EQ(other.cpu->getStatus(), console.cpu->getStatus());
+  ASSERT_EQ(other.cpu->pc, console.cpu->pc);
+  ASSERT_EQ(other.cycles, console.cycles);
+  for (uint32_t addr = 0; addr <= 0xffff; addr++) {
+    ASSERT_EQ(other.memory->read8(addr), console.memory->read8(addr)) << addr;
+  }
+}
+
+// translations of code the loaded state changes must not run
+TEST_F(ConsoleTest, LoadStateReplacesTranslatedCode) {
+  console.cpu->setBackend(Backend::Recompiler);
+  console.frame();
+  vector<uint8_t> state;
+  console.saveState(state);
+  // the inner loop starts from 8 rather than 16
+  state[console.stateRamOffset() + LOOP_PROGRAM_ADDR + 3] = 0x08;
+
+  // blocks overrun the frame alike on both, so compare with a fresh one
+  Console fresh;
+  fresh.cpu->setBackend(Backend::Recompiler);
+  ASSERT_TRUE(fresh.loadState(state));
+  ASSERT_TRUE(console.loadState(state));
+  for (auto i = 0; i < 3; i++) {
+    ASSERT_EQ(console.frame(), fresh.frame());
+  }
+  vector<uint8_t> expected;
+  vector<uint8_t> actual;
+  fresh.saveState(expected);
+  console.saveState(actual);
+  ASSERT_EQ(actual, expected);
+}
+
+TEST_F(ConsoleTest, SkipsUnknownChunks) {
+  vector<uint8_t> state;
+  console.saveState(state);
+  uint8_t chunk[] = {'A', 'P', 'U', ' ', 0x02, 0x00, 0x00, 0x00, 0xaa, 0xbb};
+  state.insert(state.end(), chunk, chunk + sizeof(chunk));
+  state[6]++;
+  auto size = state.size();
+  for (auto i = 0; i < 4; i++) {
+    state[8 + i] = size >> (8 * i);
+  }
+  ASSERT_TRUE(console.loadState(state));
+}
+
+TEST_F(ConsoleTest, RejectsInvalidStates) {
+  console.frame();
+  vector<uint8_t> state;
+  console.saveState(state);
+  auto pc = console.cpu->pc;
+  console.frame();
+
+  auto corrupt = state;
+  corrupt[0] = 'X';
+  ASSERT_FALSE(console.loadState(corrupt));
+
+  corrupt = state;
+  corrupt[4] = STATE_VERSION + 1;
+  ASSERT_FALSE(console.loadState(corrupt));
+
+  corrupt = state;
+  corrupt.pop_back();
+  ASSERT_FALSE(console.loadState(corrupt));
+
+  corrupt = state;
+  corrupt[16] = 0xff;  // CPU chunk length
+  ASSERT_FALSE(console.loadState(corrupt));
+
+  ASSERT_FALSE(console.loadState(state.data(), 4));
+  ASSERT_EQ(console.frames, 2);
+  ASSERT_TRUE(console.loadState(state));
+  ASSERT_EQ(console.cpu->pc, pc);
+}
+
+TEST_F(ConsoleTest, SaveDirtyPages) {
+  vector<uint8_t> state;
+  console.saveState(state);
+  auto since = console.memory->checkpoint();
+  for (auto i = 0; i < 3; i++) {
+    console.frame();
+  }
+  console.memory->write8(0x8000, 0x42);
+  console.saveState(state.data(), since);
+
+  vector<uint8_t> expected;
+  console.saveState(expected);
+  ASSERT_EQ(state, expected);
+}
+
+TEST_F(ConsoleTest, Fork) {
+  console.frame();
+  auto child = console.fork();
+  ASSERT_EQ(child->frames, console.frames);
+  ASSERT_EQ(child->cpu->pc, console.cpu->pc);
+
+  // both continue identically from the fork point
+  vector<uint8_t> expected;
+  vector<uint8_t> actual;
+  for (auto i = 0; i < 5; i++) {
+    console.frame();
+    child->frame();
+    console.saveState(expected);
+    child->saveState(actual);
+    ASSERT_EQ(actual, expected);
+  }
+
+  // and diverge without seeing each other's writes
+  child->memory->write8(0x8000, 0x42);
+  console.memory->write8(0x8001, 0x24);
+  ASSERT_EQ(console.memory->read8(0x8000), 0x00);
+  ASSERT_EQ(child->memory->read8(0x8001), 0x00);
+  ASSERT_EQ(child->memory->read8(0x8000), 0x42);
+  ASSERT_EQ(console.memory->read8(0x8001), 0x24);
+}
+
+TEST_F(ConsoleTest, ForkTree) {
+  vector<shared_ptr<Console>> children;
+  for (auto i = 0; i < 16; i++) {
+    children.push_back(console.fork());
+    children.back()->memory->write8(0x9000, i);
+  }
+  // grandchildren share pages with children that already copied some
+  auto grandchild = children[3]->fork();
+  children[3]->memory->write8(0x9000, 0xff);
+  ASSERT_EQ(grandchild->memory->read8(0x9000), 3);
+  for (auto i = 0; i < 16; i++) {
+    ASSERT_EQ(children[i]->memory->read8(0x9000), i == 3 ? 0xff : i);
+  }
+  ASSERT_EQ(console.memory->read8(0x9000), 0x00);
+  children.clear();
+  console.memory->write8(0x9000, 0x01);
+  ASSERT_EQ(grandchild->memory->read8(0x9000), 3);
+}
+
+TEST_F(ConsoleTest, StateHash) {
+  console.frame();
+  auto hash = console.stateHash();
+  ASSERT_EQ(console.stateHash(), hash);
+
+  // a state restored elsewhere hashes the same, one frame later it differs
+  vector<uint8_t> state;
+  console.saveState(state);
+  Console other;
+  ASSERT_TRUE(other.loadState(state));
+  ASSERT_EQ(other.stateHash(), hash);
+  console.frame();
+  ASSERT_NE(console.stateHash(), hash);
+
+  // incremental hashing agrees with a fresh full hash after every change
+  for (auto i = 0; i < 5; i++) {
+    console.frame();
+    console.memory->write8(0x8000 + i * 0x1234, i + 1);
+    ASSERT_EQ(console.stateHash(), console.fork()->stateHash()) << i;
+  }
+
+  hash = console.stateHash();
+  console.cpu->a ^= 1;
+  ASSERT_NE(console.stateHash(), hash);
+  console.cpu->a ^= 1;
+  ASSERT_EQ(console.stateHash(), hash);
+  console.memory->write8(0xffff, console.memory->read8(0xffff) ^ 0x80);
+  ASSERT_NE(console.stateHash(), hash);
+}
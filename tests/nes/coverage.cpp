@@ -0,0 +1,138 @@
+#include "nes/coverage.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/assembler.hpp"
+#include "nes/console.hpp"
+
+using std::ostringstream;
+using testing::Test;
+
+class CoverageTest : public Test {
+ protected:
+  Console console;
+  Assembler assembler;
+  Coverage coverage;
+
+  void SetUp() override {
+    ASSERT_TRUE(assembler.assemble(
+        "  ldx #0\n"
+        "loop:\n"
+        "  lda table,x\n"
+        "  sta $00\n"
+        "  lda #<table\n"
+        "  sta $10\n"
+        "  lda #>table\n"
+        "  sta $11\n"
+        "  ldy #1\n"
+        "  lda ($10),y\n"
+        "  inx\n"
+        "  cpx #2\n"
+        "branch: bne loop\n"
+        "jump: jmp (vector)\n"
+        "vector: .word done\n"
+        "done: jmp done\n"
+        "table: .byte 1, 2, 3\n"))
+        << assembler.getError();
+    auto& code = assembler.getCode();
+    console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+    console.reset();
+    console.cyclesPerFrame = 200;
+  }
+
+  uint16_t symbol(const string& name) {
+    uint16_t value = 0;
+    EXPECT_TRUE(assembler.getSymbol(name, value));
+    return value;
+  }
+};
+
+TEST_F(CoverageTest, CodeAndDataFlags) {
+  console.frame(coverage);
+  auto origin = assembler.getOrigin();
+  ASSERT_EQ(coverage.getFlags(origin), COVERAGE_CODE | COVERAGE_OPCODE);
+  ASSERT_EQ(coverage.getFlags(origin + 1), COVERAGE_CODE);
+  ASSERT_EQ(coverage.getFlags(symbol("done")),
+            COVERAGE_CODE | COVERAGE_OPCODE);
+  ASSERT_EQ(coverage.getFlags(symbol("done") + 2), COVERAGE_CODE);
+
+  auto table = symbol("table");
+  ASSERT_EQ(coverage.getFlags(table), COVERAGE_DATA);
+  ASSERT_EQ(coverage.getFlags(table + 1), COVERAGE_DATA | COVERAGE_INDIRECT);
+  ASSERT_EQ(coverage.getFlags(table + 2), 0);
+  // pointers, not what is only written
+  ASSERT_EQ(coverage.getFlags(0x10), COVERAGE_DATA);
+  ASSERT_EQ(coverage.getFlags(0x11), COVERAGE_DATA);
+  ASSERT_EQ(coverage.getFlags(symbol("vector")), COVERAGE_DATA);
+  ASSERT_EQ(coverage.getFlags(symbol("vector") + 1), COVERAGE_DATA);
+  ASSERT_EQ(coverage.getFlags(0x00), 0);
+
+  // everything but the vector and the table runs
+  ASSERT_EQ(coverage.count(COVERAGE_CODE), symbol("vector") - origin + 3);
+  ASSERT_EQ(coverage.count(COVERAGE_OPCODE), 14);
+  ASSERT_EQ(coverage.count(COVERAGE_INDIRECT), 1);
+
+  coverage.clear();
+  ASSERT_EQ(coverage.count(0xff), 0);
+}
+
+TEST_F(CoverageTest, MatchesUncoveredRun) {
+  Console plain;
+  auto& code = assembler.getCode();
+  plain.loadProgram(assembler.getOrigin(), code.data(), code.size());
+  plain.reset();
+  plain.cyclesPerFrame = 200;
+  for (auto i = 0; i < 3; i++) {
+    ASSERT_EQ(console.frame(coverage), plain.frame());
+  }
+  ASSERT_EQ(console.stateHash(), plain.stateHash());
+}
+
+TEST_F(CoverageTest, HotBlocks) {
+  console.frame(coverage);
+  auto blocks = coverage.hotBlocks(10);
+  ASSERT_EQ(blocks.size(), 4);
+  ASSERT_EQ(blocks[0].start, symbol("done"));
+  ASSERT_EQ(blocks[0].end, symbol("done"));
+  ASSERT_EQ(blocks[0].cycles, 3 * blocks[0].count);
+  // entered from reset and from the branch, both run up to it
+  for (auto start : {assembler.getOrigin(), symbol("loop")}) {
+    auto block = std::find_if(blocks.begin(), blocks.end(),
+                              [&](auto& b) { return b.start == start; });
+    ASSERT_NE(block, blocks.end());
+    ASSERT_EQ(block->end, symbol("branch"));
+    ASSERT_EQ(block->count, 1);
+  }
+  ASSERT_EQ(blocks.back().start, symbol("jump"));
+  ASSERT_EQ(blocks.back().cycles, 5);
+
+  ostringstream report;
+  coverage.report(report, 1);
+  ASSERT_NE(report.str().find("opcodes 14 code"), string::npos);
+  char done[16];
+  snprintf(done, sizeof(done), "%04x   %04x", symbol("done"), symbol("done"));
+  ASSERT_NE(report.str().find(done), string::npos);
+  ASSERT_EQ(report.str().find("0600   "), string::npos);
+}
+
+TEST_F(CoverageTest, Cdl) {
+  console.frame(coverage);
+  auto origin = assembler.getOrigin();
+  ostringstream cdl;
+  coverage.writeCdl(cdl, origin, 0x40);
+  ASSERT_EQ(cdl.str().size(), 0x40);
+  ASSERT_EQ(uint8_t(cdl.str()[0]), COVERAGE_CODE | COVERAGE_OPCODE);
+  ASSERT_EQ(uint8_t(cdl.str()[symbol("table") - origin]), COVERAGE_DATA);
+
+  // the zero page pointer folds onto the origin page
+  ostringstream folded;
+  coverage.writeCdl(folded, 0, 0x0700, 0x0100);
+  ASSERT_EQ(folded.str().size(), 0x100);
+  ASSERT_EQ(uint8_t(folded.str()[0x10]),
+            coverage.getFlags(0x10) | coverage.getFlags(origin + 0x10));
+
+  auto path = testing::TempDir() + "coverage.cdl";
+  ASSERT_TRUE(coverage.saveCdl(path));
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  ASSERT_EQ(file.tellg(), COVERAGE_ADDRESSES);
+}
@@ -8,9 +8,10 @@
 
 using std::make_shared;
 using std::shared_ptr;
-using testing::Test;
+using testing::TestWithParam;
+using testing::Values;
 
-class CPUTest : public Test {
+class CPUTest : public TestWithParam<Backend> {
  protected:
   shared_ptr<Memory> memory;
   shared_ptr<Bus> bus;
@@ -21,10 +22,14 @@ class CPUTest : public Test {
     bus = make_shared<MemoryBus>();
     bus->connect(memory);
     cpu = make_shared<CPU>(bus);
+    cpu->setBackend(GetParam());
   }
 };
 
-TEST_F(CPUTest, SetFlag) {
+INSTANTIATE_TEST_SUITE_P(Backends, CPUTest,
+                         Values(Backend::Interpreter, Backend::Recompiler));
+
+TEST_P(CPUTest, SetFlag) {
   // arrange
   auto d = cpu->getFlag(Flags::D);
   // act
@@ -35,7 +40,7 @@ TEST_F(CPUTest, SetFlag) {
   ASSERT_EQ(d, true);
 }
 
-TEST_F(CPUTest, ClearFlag) {
+TEST_P(CPUTest, ClearFlag) {
   // arrange
   auto i = cpu->getFlag(Flags::I);
   // act
@@ -46,7 +51,7 @@ TEST_F(CPUTest, ClearFlag) {
   ASSERT_EQ(i, false);
 }
 
-TEST_F(CPUTest, SetFlagTrue) {
+TEST_P(CPUTest, SetFlagTrue) {
   // arrange
   auto d = cpu->getFlag(Flags::D);
   // act
@@ -57,7 +62,7 @@ TEST_F(CPUTest, SetFlagTrue) {
   ASSERT_EQ(d, true);
 }
 
-TEST_F(CPUTest, SetFlagFalse) {
+TEST_P(CPUTest, SetFlagFalse) {
   // arrange
   auto i = cpu->getFlag(Flags::I);
   // act
@@ -68,7 +73,7 @@ TEST_F(CPUTest, SetFlagFalse) {
   ASSERT_EQ(i, false);
 }
 
-TEST_F(CPUTest, SetZero) {
+TEST_P(CPUTest, SetZero) {
   // arrange
   auto z = cpu->getFlag(Flags::Z);
   // act
@@ -79,7 +84,7 @@ TEST_F(CPUTest, SetZero) {
   ASSERT_EQ(z, true);
 }
 
-TEST_F(CPUTest, SetNegative) {
+TEST_P(CPUTest, SetNegative) {
   // arrange
   auto n = cpu->getFlag(Flags::N);
   // act
@@ -90,7 +95,7 @@ TEST_F(CPUTest, SetNegative) {
   ASSERT_EQ(n, true);
 }
 
-TEST_F(CPUTest, Push8) {
+TEST_P(CPUTest, Push8) {
   // arrange
   auto sp = cpu->sp;
   // act
@@ -101,7 +106,7 @@ TEST_F(CPUTest, Push8) {
   ASSERT_EQ(value, 0xf0);
 }
 
-TEST_F(CPUTest, Push16) {
+TEST_P(CPUTest, Push16) {
   // arrange
   auto sp = cpu->sp;
   // act
@@ -112,7 +117,7 @@ TEST_F(CPUTest, Push16) {
   ASSERT_EQ(value, 0xf011);
 }
 
-TEST_F(CPUTest, Pop8) {
+TEST_P(CPUTest, Pop8) {
   // arrange
   auto sp = cpu->sp;
   // act
@@ -123,7 +128,7 @@ TEST_F(CPUTest, Pop8) {
   ASSERT_EQ(value, 0xf0);
 }
 
-TEST_F(CPUTest, Pop16) {
+TEST_P(CPUTest, Pop16) {
   // arrange
   auto sp = cpu->sp;
   // act
@@ -134,7 +139,7 @@ TEST_F(CPUTest, Pop16) {
   ASSERT_EQ(value, 0xf011);
 }
 
-TEST_F(CPUTest, AbsAddressing) {
+TEST_P(CPUTest, AbsAddressing) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0xad, 0x23, 0x45};
@@ -146,7 +151,7 @@ TEST_F(CPUTest, AbsAddressing) {
   ASSERT_EQ(cpu->address, 0x4523);
 }
 
-TEST_F(CPUTest, AbsxAddressingNoPenality) {
+TEST_P(CPUTest, AbsxAddressingNoPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0xf9;
@@ -160,7 +165,7 @@ TEST_F(CPUTest, AbsxAddressingNoPenality) {
   ASSERT_EQ(cpu->penality, false);
 }
 
-TEST_F(CPUTest, AbsxAddressingPenality) {
+TEST_P(CPUTest, AbsxAddressingPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0xf9;
@@ -174,7 +179,7 @@ TEST_F(CPUTest, AbsxAddressingPenality) {
   ASSERT_EQ(cpu->penality, true);
 }
 
-TEST_F(CPUTest, AbsyAddressingNoPenality) {
+TEST_P(CPUTest, AbsyAddressingNoPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0xf9;
@@ -188,7 +193,7 @@ TEST_F(CPUTest, AbsyAddressingNoPenality) {
   ASSERT_EQ(cpu->penality, false);
 }
 
-TEST_F(CPUTest, AbsyAddressingPenality) {
+TEST_P(CPUTest, AbsyAddressingPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0xf9;
@@ -202,7 +207,7 @@ TEST_F(CPUTest, AbsyAddressingPenality) {
   ASSERT_EQ(cpu->penality, true);
 }
 
-TEST_F(CPUTest, AccAddressing) {
+TEST_P(CPUTest, AccAddressing) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf9;
@@ -214,7 +219,7 @@ TEST_F(CPUTest, AccAddressing) {
   ASSERT_EQ(value, cpu->a);
 }
 
-TEST_F(CPUTest, ImmAddressing) {
+TEST_P(CPUTest, ImmAddressing) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0xa9, 0x87};
@@ -228,7 +233,7 @@ TEST_F(CPUTest, ImmAddressing) {
   ASSERT_EQ(value, 0x87);
 }
 
-TEST_F(CPUTest, ImpAddressing) {
+TEST_P(CPUTest, ImpAddressing) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0xea};
@@ -239,7 +244,7 @@ TEST_F(CPUTest, ImpAddressing) {
   ASSERT_EQ(cpu->addressing, Addressing::Imp);
 }
 
-TEST_F(CPUTest, IndAddressing) {
+TEST_P(CPUTest, IndAddressing) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x6c, 0x12, 0x30};
@@ -254,7 +259,7 @@ TEST_F(CPUTest, IndAddressing) {
   ASSERT_EQ(cpu->address, 0x4500);
 }
 
-TEST_F(CPUTest, IndxAddressing) {
+TEST_P(CPUTest, IndxAddressing) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x45;
@@ -270,7 +275,7 @@ TEST_F(CPUTest, IndxAddressing) {
   ASSERT_EQ(cpu->address, 0x4500);
 }
 
-TEST_F(CPUTest, IndyAddressingNoPenality) {
+TEST_P(CPUTest, IndyAddressingNoPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x45;
@@ -287,7 +292,7 @@ TEST_F(CPUTest, IndyAddressingNoPenality) {
   ASSERT_EQ(cpu->penality, false);
 }
 
-TEST_F(CPUTest, IndyAddressingPenality) {
+TEST_P(CPUTest, IndyAddressingPenality) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x45;
@@ -304,7 +309,7 @@ TEST_F(CPUTest, IndyAddressingPenality) {
   ASSERT_EQ(cpu->penality, true);
 }
 
-TEST_F(CPUTest, RelAddressingPositive) {
+TEST_P(CPUTest, RelAddressingPositive) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x30, 0x50};
@@ -319,7 +324,7 @@ TEST_F(CPUTest, RelAddressingPositive) {
   ASSERT_EQ(cpu->address, cpu->pc + 0x52);
 }
 
-TEST_F(CPUTest, RelAddressingNegative) {
+TEST_P(CPUTest, RelAddressingNegative) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x30, 0xf0};
@@ -334,7 +339,7 @@ TEST_F(CPUTest, RelAddressingNegative) {
   ASSERT_EQ(cpu->address, cpu->pc + 2 + 0xf0 - 0x100);
 }
 
-TEST_F(CPUTest, ZpAddressing) {
+TEST_P(CPUTest, ZpAddressing) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x65, 0xf0};
@@ -350,7 +355,7 @@ TEST_F(CPUTest, ZpAddressing) {
   ASSERT_EQ(cpu->read8(), 0x45);
 }
 
-TEST_F(CPUTest, ZpxAddressing) {
+TEST_P(CPUTest, ZpxAddressing) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x30;
@@ -367,7 +372,7 @@ TEST_F(CPUTest, ZpxAddressing) {
   ASSERT_EQ(cpu->read8(), 0x80);
 }
 
-TEST_F(CPUTest, ZpyAddressing) {
+TEST_P(CPUTest, ZpyAddressing) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x45;
@@ -384,7 +389,7 @@ TEST_F(CPUTest, ZpyAddressing) {
   ASSERT_EQ(cpu->read8(), 0x8f);
 }
 
-TEST_F(CPUTest, AdcImmOverflowPositive) {
+TEST_P(CPUTest, AdcImmOverflowPositive) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x7f;
@@ -404,7 +409,7 @@ TEST_F(CPUTest, AdcImmOverflowPositive) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, AdcImmUnderflowNegative) {
+TEST_P(CPUTest, AdcImmUnderflowNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf5;
@@ -424,7 +429,7 @@ TEST_F(CPUTest, AdcImmUnderflowNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, AndZp) {
+TEST_P(CPUTest, AndZp) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf5;
@@ -443,7 +448,7 @@ TEST_F(CPUTest, AndZp) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, AslAcc) {
+TEST_P(CPUTest, AslAcc) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x80;
@@ -461,7 +466,7 @@ TEST_F(CPUTest, AslAcc) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), true);
 }
 
-TEST_F(CPUTest, AslAbs) {
+TEST_P(CPUTest, AslAbs) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x0e, 0x40, 0x30};
@@ -480,7 +485,7 @@ TEST_F(CPUTest, AslAbs) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, BccFailure) {
+TEST_P(CPUTest, BccFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::C, true);
@@ -494,7 +499,7 @@ TEST_F(CPUTest, BccFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BccSuccess) {
+TEST_P(CPUTest, BccSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::C, false);
@@ -508,7 +513,7 @@ TEST_F(CPUTest, BccSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BcsFailure) {
+TEST_P(CPUTest, BcsFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::C, false);
@@ -522,7 +527,7 @@ TEST_F(CPUTest, BcsFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BcsSuccess) {
+TEST_P(CPUTest, BcsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::C, true);
@@ -536,7 +541,7 @@ TEST_F(CPUTest, BcsSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BeqFailure) {
+TEST_P(CPUTest, BeqFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::Z, false);
@@ -550,7 +555,7 @@ TEST_F(CPUTest, BeqFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BeqSuccess) {
+TEST_P(CPUTest, BeqSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::Z, true);
@@ -564,7 +569,7 @@ TEST_F(CPUTest, BeqSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BitZp) {
+TEST_P(CPUTest, BitZp) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf0;
@@ -583,7 +588,7 @@ TEST_F(CPUTest, BitZp) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, BmiFailure) {
+TEST_P(CPUTest, BmiFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::N, false);
@@ -597,7 +602,7 @@ TEST_F(CPUTest, BmiFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BmiSuccess) {
+TEST_P(CPUTest, BmiSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::N, true);
@@ -611,7 +616,7 @@ TEST_F(CPUTest, BmiSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BneFailure) {
+TEST_P(CPUTest, BneFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::Z, true);
@@ -625,7 +630,7 @@ TEST_F(CPUTest, BneFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BneSuccess) {
+TEST_P(CPUTest, BneSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::Z, false);
@@ -639,7 +644,7 @@ TEST_F(CPUTest, BneSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BplFailure) {
+TEST_P(CPUTest, BplFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::N, true);
@@ -653,7 +658,7 @@ TEST_F(CPUTest, BplFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BplSuccess) {
+TEST_P(CPUTest, BplSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::N, false);
@@ -667,7 +672,7 @@ TEST_F(CPUTest, BplSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BrkSuccess) {
+TEST_P(CPUTest, BrkSuccess) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x00, 0x40};
@@ -686,7 +691,7 @@ TEST_F(CPUTest, BrkSuccess) {
   ASSERT_EQ(cpu->pop16(), 0x2002);
 }
 
-TEST_F(CPUTest, BvcFailure) {
+TEST_P(CPUTest, BvcFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::V, true);
@@ -700,7 +705,7 @@ TEST_F(CPUTest, BvcFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BvcSuccess) {
+TEST_P(CPUTest, BvcSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::V, false);
@@ -714,7 +719,7 @@ TEST_F(CPUTest, BvcSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, BvsFailure) {
+TEST_P(CPUTest, BvsFailure) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::V, false);
@@ -728,7 +733,7 @@ TEST_F(CPUTest, BvsFailure) {
   ASSERT_EQ(cpu->pc, 0x02002);
 }
 
-TEST_F(CPUTest, BvsSuccess) {
+TEST_P(CPUTest, BvsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::V, true);
@@ -742,7 +747,7 @@ TEST_F(CPUTest, BvsSuccess) {
   ASSERT_EQ(cpu->pc, 0x02042);
 }
 
-TEST_F(CPUTest, ClcSuccess) {
+TEST_P(CPUTest, ClcSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::C, true);
@@ -759,7 +764,7 @@ TEST_F(CPUTest, ClcSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::C), false);
 }
 
-TEST_F(CPUTest, CldSuccess) {
+TEST_P(CPUTest, CldSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::D, true);
@@ -776,7 +781,7 @@ TEST_F(CPUTest, CldSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::D), false);
 }
 
-TEST_F(CPUTest, CliSuccess) {
+TEST_P(CPUTest, CliSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::I, true);
@@ -793,7 +798,7 @@ TEST_F(CPUTest, CliSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::I), false);
 }
 
-TEST_F(CPUTest, ClvSuccess) {
+TEST_P(CPUTest, ClvSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->setFlag(Flags::V, true);
@@ -810,7 +815,7 @@ TEST_F(CPUTest, ClvSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::V), false);
 }
 
-TEST_F(CPUTest, CmpImmZeroCarry) {
+TEST_P(CPUTest, CmpImmZeroCarry) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf0;
@@ -827,7 +832,7 @@ TEST_F(CPUTest, CmpImmZeroCarry) {
   ASSERT_EQ(cpu->getFlag(Flags::C), true);
 }
 
-TEST_F(CPUTest, CpxImmNegative) {
+TEST_P(CPUTest, CpxImmNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x00;
@@ -844,7 +849,7 @@ TEST_F(CPUTest, CpxImmNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::C), false);
 }
 
-TEST_F(CPUTest, CpyImmCarryNegative) {
+TEST_P(CPUTest, CpyImmCarryNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0xf0;
@@ -861,7 +866,7 @@ TEST_F(CPUTest, CpyImmCarryNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::C), true);
 }
 
-TEST_F(CPUTest, DecZpNegative) {
+TEST_P(CPUTest, DecZpNegative) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0xc6, 0x30};
@@ -879,7 +884,7 @@ TEST_F(CPUTest, DecZpNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, DexZero) {
+TEST_P(CPUTest, DexZero) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x01;
@@ -896,7 +901,7 @@ TEST_F(CPUTest, DexZero) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, DeySuccess) {
+TEST_P(CPUTest, DeySuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x80;
@@ -913,7 +918,7 @@ TEST_F(CPUTest, DeySuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, EorImmNegative) {
+TEST_P(CPUTest, EorImmNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xff;
@@ -930,7 +935,7 @@ TEST_F(CPUTest, EorImmNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, IncZpNegative) {
+TEST_P(CPUTest, IncZpNegative) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0xe6, 0x30};
@@ -948,7 +953,7 @@ TEST_F(CPUTest, IncZpNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, IncZero) {
+TEST_P(CPUTest, IncZero) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0xff;
@@ -965,7 +970,7 @@ TEST_F(CPUTest, IncZero) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, InySuccess) {
+TEST_P(CPUTest, InySuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x50;
@@ -982,7 +987,7 @@ TEST_F(CPUTest, InySuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, JmpAbsSuccess) {
+TEST_P(CPUTest, JmpAbsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x4c, 0x30, 0x20};
@@ -995,7 +1000,7 @@ TEST_F(CPUTest, JmpAbsSuccess) {
   ASSERT_EQ(cpu->pc, 0x2030);
 }
 
-TEST_F(CPUTest, JsrSuccess) {
+TEST_P(CPUTest, JsrSuccess) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x20, 0x30, 0x20};
@@ -1011,7 +1016,7 @@ TEST_F(CPUTest, JsrSuccess) {
   ASSERT_EQ(cpu->pop16(), 0x2003);
 }
 
-TEST_F(CPUTest, LdaImmZero) {
+TEST_P(CPUTest, LdaImmZero) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xff;
@@ -1028,7 +1033,7 @@ TEST_F(CPUTest, LdaImmZero) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, LdxZpNegative) {
+TEST_P(CPUTest, LdxZpNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x00;
@@ -1047,7 +1052,7 @@ TEST_F(CPUTest, LdxZpNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, LdyAbsSucces) {
+TEST_P(CPUTest, LdyAbsSucces) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0xff;
@@ -1066,7 +1071,7 @@ TEST_F(CPUTest, LdyAbsSucces) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, LsrAbsSucces) {
+TEST_P(CPUTest, LsrAbsSucces) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x4e, 0x40, 0x20};
@@ -1085,7 +1090,7 @@ TEST_F(CPUTest, LsrAbsSucces) {
   ASSERT_EQ(cpu->getFlag(Flags::N), false);
 }
 
-TEST_F(CPUTest, OraImmSucces) {
+TEST_P(CPUTest, OraImmSucces) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x0f;
@@ -1102,7 +1107,7 @@ TEST_F(CPUTest, OraImmSucces) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, PhaSucces) {
+TEST_P(CPUTest, PhaSucces) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x0f;
@@ -1117,10 +1122,10 @@ TEST_F(CPUTest, PhaSucces) {
   ASSERT_EQ(memory->read8(STACK_PAGE + cpu->sp + 1), cpu->a);
 }
 
-TEST_F(CPUTest, PhpSucces) {
+TEST_P(CPUTest, PhpSucces) {
   // arrange
   cpu->pc = 0x02000;
-  cpu->p = 0x00;
+  cpu->setStatus(0x00);
   uint8_t code[] = {0x08};
   memory->set(0x02000, code, 1);
 
@@ -1129,10 +1134,10 @@ TEST_F(CPUTest, PhpSucces) {
   // assert
   ASSERT_EQ(cpu->addressing, Addressing::Imp);
   ASSERT_EQ(cpu->pc, 0x2001);
-  ASSERT_EQ(memory->read8(STACK_PAGE + cpu->sp + 1), cpu->p | 0x30);
+  ASSERT_EQ(memory->read8(STACK_PAGE + cpu->sp + 1), cpu->getStatus() | 0x30);
 }
 
-TEST_F(CPUTest, PlaSucces) {
+TEST_P(CPUTest, PlaSucces) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x00;
@@ -1150,10 +1155,10 @@ TEST_F(CPUTest, PlaSucces) {
   ASSERT_EQ(cpu->getFlag(Flags::N), true);
 }
 
-TEST_F(CPUTest, PlpSucces) {
+TEST_P(CPUTest, PlpSucces) {
   // arrange
   cpu->pc = 0x02000;
-  cpu->p = 0x00;
+  cpu->setStatus(0x00);
   uint8_t code[] = {0x28};
   memory->set(0x02000, code, 1);
   memory->write8(STACK_PAGE + 0xff, 0x83);
@@ -1164,10 +1169,10 @@ TEST_F(CPUTest, PlpSucces) {
   // assert
   ASSERT_EQ(cpu->addressing, Addressing::Imp);
   ASSERT_EQ(cpu->pc, 0x2001);
-  ASSERT_EQ(cpu->p, 0xa3);
+  ASSERT_EQ(cpu->getStatus(), 0xa3);
 }
 
-TEST_F(CPUTest, RolAccWithCarry) {
+TEST_P(CPUTest, RolAccWithCarry) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x40;
@@ -1186,7 +1191,7 @@ TEST_F(CPUTest, RolAccWithCarry) {
   ASSERT_EQ(cpu->getFlag(Flags::C), false);
 }
 
-TEST_F(CPUTest, RolAccWithoutCarry) {
+TEST_P(CPUTest, RolAccWithoutCarry) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x80;
@@ -1204,7 +1209,7 @@ TEST_F(CPUTest, RolAccWithoutCarry) {
   ASSERT_EQ(cpu->getFlag(Flags::C), true);
 }
 
-TEST_F(CPUTest, RorAccWithCarry) {
+TEST_P(CPUTest, RorAccWithCarry) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x40;
@@ -1223,7 +1228,7 @@ TEST_F(CPUTest, RorAccWithCarry) {
   ASSERT_EQ(cpu->getFlag(Flags::C), false);
 }
 
-TEST_F(CPUTest, RorAccWithoutCarry) {
+TEST_P(CPUTest, RorAccWithoutCarry) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x01;
@@ -1241,7 +1246,7 @@ TEST_F(CPUTest, RorAccWithoutCarry) {
   ASSERT_EQ(cpu->getFlag(Flags::C), true);
 }
 
-TEST_F(CPUTest, RtiSuccess) {
+TEST_P(CPUTest, RtiSuccess) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x40};
@@ -1255,10 +1260,10 @@ TEST_F(CPUTest, RtiSuccess) {
   // assert
   ASSERT_EQ(cpu->addressing, Addressing::Imp);
   ASSERT_EQ(cpu->pc, 0x4060);
-  ASSERT_EQ(cpu->p, p & 0xef | 0x20);
+  ASSERT_EQ(cpu->getStatus(), p & 0xef | 0x20);
 }
 
-TEST_F(CPUTest, RtsSuccess) {
+TEST_P(CPUTest, RtsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   uint8_t code[] = {0x60};
@@ -1272,7 +1277,7 @@ TEST_F(CPUTest, RtsSuccess) {
   ASSERT_EQ(cpu->pc, 0x4060);
 }
 
-TEST_F(CPUTest, SbcImmOverflowPositive) {
+TEST_P(CPUTest, SbcImmOverflowPositive) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x7f;
@@ -1292,7 +1297,7 @@ TEST_F(CPUTest, SbcImmOverflowPositive) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, SbcImmUnderflowNegative) {
+TEST_P(CPUTest, SbcImmUnderflowNegative) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xf5;
@@ -1312,7 +1317,7 @@ TEST_F(CPUTest, SbcImmUnderflowNegative) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, SecSuccess) {
+TEST_P(CPUTest, SecSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->clearFlag(Flags::C);
@@ -1327,7 +1332,7 @@ TEST_F(CPUTest, SecSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::C), true);
 }
 
-TEST_F(CPUTest, SedSuccess) {
+TEST_P(CPUTest, SedSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->clearFlag(Flags::D);
@@ -1342,7 +1347,7 @@ TEST_F(CPUTest, SedSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::D), true);
 }
 
-TEST_F(CPUTest, SeiSuccess) {
+TEST_P(CPUTest, SeiSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->clearFlag(Flags::I);
@@ -1357,7 +1362,7 @@ TEST_F(CPUTest, SeiSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::I), true);
 }
 
-TEST_F(CPUTest, StaZpSuccess) {
+TEST_P(CPUTest, StaZpSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0x3e;
@@ -1372,7 +1377,7 @@ TEST_F(CPUTest, StaZpSuccess) {
   ASSERT_EQ(memory->read8(0x0044), cpu->a);
 }
 
-TEST_F(CPUTest, StxAbsSuccess) {
+TEST_P(CPUTest, StxAbsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x3f;
@@ -1387,7 +1392,7 @@ TEST_F(CPUTest, StxAbsSuccess) {
   ASSERT_EQ(memory->read8(0x2044), cpu->x);
 }
 
-TEST_F(CPUTest, StyAbsSuccess) {
+TEST_P(CPUTest, StyAbsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0x3f;
@@ -1402,7 +1407,7 @@ TEST_F(CPUTest, StyAbsSuccess) {
   ASSERT_EQ(memory->read8(0x2044), cpu->y);
 }
 
-TEST_F(CPUTest, TaxSuccess) {
+TEST_P(CPUTest, TaxSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->x = 0x00;
@@ -1420,7 +1425,7 @@ TEST_F(CPUTest, TaxSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, TaySuccess) {
+TEST_P(CPUTest, TaySuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->y = 0xff;
@@ -1438,7 +1443,7 @@ TEST_F(CPUTest, TaySuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), true);
 }
 
-TEST_F(CPUTest, TsxSuccess) {
+TEST_P(CPUTest, TsxSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->sp = 0xff;
@@ -1456,7 +1461,7 @@ TEST_F(CPUTest, TsxSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), false);
 }
 
-TEST_F(CPUTest, TxaSuccess) {
+TEST_P(CPUTest, TxaSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xff;
@@ -1474,7 +1479,7 @@ TEST_F(CPUTest, TxaSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), true);
 }
 
-TEST_F(CPUTest, TxsSuccess) {
+TEST_P(CPUTest, TxsSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->sp = 0xff;
@@ -1490,7 +1495,7 @@ TEST_F(CPUTest, TxsSuccess) {
   ASSERT_EQ(cpu->sp, cpu->x);
 }
 
-TEST_F(CPUTest, TyaSuccess) {
+TEST_P(CPUTest, TyaSuccess) {
   // arrange
   cpu->pc = 0x02000;
   cpu->a = 0xff;
@@ -1508,7 +1513,7 @@ TEST_F(CPUTest, TyaSuccess) {
   ASSERT_EQ(cpu->getFlag(Flags::Z), true);
 }
 
-TEST_F(CPUTest, Reset) {
+TEST_P(CPUTest, Reset) {
   // arrange
   memory->write16(RESET_PROC_ADDR, 0x4235);
   // act
@@ -1519,17 +1524,17 @@ TEST_F(CPUTest, Reset) {
   ASSERT_EQ(cpu->y, 0x00);
   ASSERT_EQ(cpu->pc, 0x4235);
   ASSERT_EQ(cpu->sp, 0xfd);
-  ASSERT_EQ(cpu->p, 0x20);
+  ASSERT_EQ(cpu->getStatus(), 0x20);
 }
 
-TEST_F(CPUTest, Nmi) {
+TEST_P(CPUTest, Nmi) {
   // arrange
   memory->write16(NMI_PROC_ADDR, 0x4235);
   auto a = cpu->a;
   auto x = cpu->x;
   auto y = cpu->y;
   auto sp = cpu->sp;
-  auto p = cpu->p;
+  auto p = cpu->getStatus();
   // act
   cpu->nmi();
   // assert
@@ -1538,10 +1543,10 @@ TEST_F(CPUTest, Nmi) {
   ASSERT_EQ(cpu->y, y);
   ASSERT_EQ(cpu->pc, 0x4235);
   ASSERT_EQ(cpu->sp, sp - 3);
-  ASSERT_EQ(cpu->p, p | 0x24);
+  ASSERT_EQ(cpu->getStatus(), p | 0x24);
 }
 
-TEST_F(CPUTest, IrqFailure) {
+TEST_P(CPUTest, IrqFailure) {
   // arrange
   memory->write16(IRQ_PROC_ADDR, 0x4235);
   cpu->setFlag(Flags::I);
@@ -1549,7 +1554,7 @@ TEST_F(CPUTest, IrqFailure) {
   auto x = cpu->x;
   auto y = cpu->y;
   auto sp = cpu->sp;
-  auto p = cpu->p;
+  auto p = cpu->getStatus();
   auto pc = cpu->pc;
   // act
   cpu->irq();
@@ -1559,10 +1564,10 @@ TEST_F(CPUTest, IrqFailure) {
   ASSERT_EQ(cpu->y, y);
   ASSERT_EQ(cpu->pc, pc);
   ASSERT_EQ(cpu->sp, sp);
-  ASSERT_EQ(cpu->p, p);
+  ASSERT_EQ(cpu->getStatus(), p);
 }
 
-TEST_F(CPUTest, IrqSuccess) {
+TEST_P(CPUTest, IrqSuccess) {
   // arrange
   memory->write16(IRQ_PROC_ADDR, 0x4235);
   cpu->clearFlag(Flags::I);
@@ -1570,7 +1575,7 @@ TEST_F(CPUTest, IrqSuccess) {
   auto x = cpu->x;
   auto y = cpu->y;
   auto sp = cpu->sp;
-  auto p = cpu->p;
+  auto p = cpu->getStatus();
   auto pc = cpu->pc;
   // act
   cpu->irq();
@@ -1580,5 +1585,78 @@ TEST_F(CPUTest, IrqSuccess) {
   ASSERT_EQ(cpu->y, y);
   ASSERT_EQ(cpu->pc, 0x4235);
   ASSERT_EQ(cpu->sp, sp - 3);
-  ASSERT_EQ(cpu->p, p | 0x24);
-}
\ No newline at end of file
+  ASSERT_EQ(cpu->getStatus(), p | 0x24);
+}
+
+TEST_P(CPUTest, SaveLoad) {
+  // arrange
+  cpu->pc = 0x02000;
+  cpu->a = 0x7f;
+  cpu->setFlag(Flags::C, true);
+  uint8_t code[] = {0x69, 0x7f, 0xaa};
+  memory->set(0x02000, code, 3);
+  cpu->clock(true);
+  CpuState state;
+  // act
+  cpu->save(state);
+  cpu->clock(true);
+  cpu->load(state);
+  // assert
+  ASSERT_EQ(cpu->pc, 0x02002);
+  ASSERT_EQ(cpu->a, 0xff);
+  ASSERT_EQ(cpu->x, 0x00);
+  ASSERT_EQ(cpu->cycles, 1);
+  ASSERT_EQ(cpu->getFlag(Flags::V), true);
+  ASSERT_EQ(cpu->getFlag(Flags::N), true);
+  ASSERT_EQ(cpu->opcodeInfo.opcode, 0x69);
+}
+
+TEST_P(CPUTest, LoadIntoOtherCPU) {
+  // arrange
+  cpu->pc = 0x02000;
+  cpu->x = 0x10;
+  uint8_t code[] = {0xe8, 0xe8};
+  memory->set(0x02000, code, 2);
+  cpu->clock(true);
+  CpuState state;
+  cpu->save(state);
+  auto other = make_shared<CPU>(bus);
+  other->setBackend(GetParam());
+  // act
+  other->load(state);
+  other->clock(true);
+  // assert
+  ASSERT_EQ(other->pc, 0x02002);
+  ASSERT_EQ(other->x, 0x12);
+  ASSERT_EQ(other->getStatus(), cpu->getStatus());
+}
+
+// the disassembly of a verbose CPU peeks, so it reads what a quiet one reads;
+// only the interpreter disassembles
+TEST(CPUVerboseTest, AddsNoReads) {
+  uint8_t code[] = {0xa2, 0x03, 0xca, 0xd0, 0xfd, 0xa9, 0x01};
+  uint32_t reads[2] = {};
+  for (auto verbose = 0; verbose < 2; verbose++) {
+    auto ram = make_shared<Memory>(0x0000, 0xffff);
+    auto ramBus = make_shared<MemoryBus>();
+    ramBus->connect(ram);
+    CPU probe(ramBus, verbose);
+    ram->set(0x0600, code, sizeof(code));
+    ram->setWatcher([&reads, verbose](uint16_t, uint8_t, bool) {
+      reads[verbose]++;
+    });
+    for (uint16_t addr = 0x0600; addr < 0x0600 + sizeof(code); addr++) {
+      ram->watch(addr, true, false);
+    }
+    probe.pc = 0x0600;
+    testing::internal::CaptureStdout();
+    for (auto i = 0; i < 8; i++) {
+      probe.clock(true);
+    }
+    auto output = testing::internal::GetCapturedStdout();
+    ASSERT_EQ(output.find("LDX #$03") != string::npos, bool(verbose));
+    ASSERT_EQ(probe.a, 0x01);
+  }
+  ASSERT_GT(reads[0], 0);
+  ASSERT_EQ(reads[1], reads[0]);
+}
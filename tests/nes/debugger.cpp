@@ -0,0 +1,152 @@
+#include "nes/debugger.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/assembler.hpp"
+#include "nes/console.hpp"
+
+using testing::Test;
+
+class DebuggerTest : public Test {
+ protected:
+  Console console;
+  Assembler assembler;
+
+  void SetUp() override {
+    ASSERT_TRUE(assembler.assemble(
+        "  ldx #0\n"
+        "loop:\n"
+        "  inx\n"
+        "  stx $0300\n"
+        "  lda $0310\n"
+        "step: cpx #5\n"
+        "  bne loop\n"
+        "done: jmp done\n"))
+        << assembler.getError();
+    auto& code = assembler.getCode();
+    console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+    console.reset();
+    console.cyclesPerFrame = 1000;
+  }
+
+  uint16_t symbol(const string& name) {
+    uint16_t value = 0;
+    EXPECT_TRUE(assembler.getSymbol(name, value));
+    return value;
+  }
+};
+
+TEST_F(DebuggerTest, RunsThroughWithoutBreakpoints) {
+  Debugger debugger(console.memory);
+  ASSERT_GE(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(console.cpu->x, 5);
+  ASSERT_EQ(debugger.getHits(), 0);
+}
+
+TEST_F(DebuggerTest, BreakpointStopsBeforeTheInstruction) {
+  Debugger debugger(console.memory);
+  debugger.setBreakpoint(symbol("step"));
+  ASSERT_TRUE(debugger.hasBreakpoint(symbol("step")));
+  for (uint8_t x = 1; x <= 5; x++) {
+    ASSERT_LT(console.cpu->run(1000, debugger), 1000);
+    ASSERT_EQ(console.cpu->pc, symbol("step"));
+    ASSERT_EQ(console.cpu->x, x);
+    ASSERT_EQ(debugger.getHit().event, DebugEvent::Breakpoint);
+  }
+  ASSERT_GE(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(console.cpu->pc, symbol("done"));
+  ASSERT_EQ(debugger.getHits(), 5);
+
+  debugger.setBreakpoint(symbol("step"), false);
+  ASSERT_FALSE(debugger.hasBreakpoint(symbol("step")));
+}
+
+TEST_F(DebuggerTest, CallbackDecidesToStop) {
+  vector<uint8_t> seen;
+  Debugger debugger(console.memory,
+                    [&](const CpuState& state, const DebugHit& hit) {
+                      seen.push_back(state.x);
+                      return state.x == 3;
+                    });
+  debugger.setBreakpoint(symbol("step"));
+  console.cpu->run(1000, debugger);
+  ASSERT_EQ(console.cpu->x, 3);
+  ASSERT_EQ(seen, vector<uint8_t>({1, 2, 3}));
+}
+
+TEST_F(DebuggerTest, WatchpointsStopAfterTheAccess) {
+  Debugger debugger(console.memory);
+  debugger.watch(0x0300, false, true);
+  debugger.watch(0x0310, true, false);
+  auto stx = symbol("loop") + 1;
+
+  ASSERT_LT(console.cpu->run(1000, debugger), 1000);
+  auto hit = debugger.getHit();
+  ASSERT_EQ(hit.event, DebugEvent::Write);
+  ASSERT_EQ(hit.pc, stx);
+  ASSERT_EQ(hit.address, 0x0300);
+  ASSERT_EQ(hit.value, 1);
+  ASSERT_EQ(console.cpu->pc, stx + 3);
+  ASSERT_EQ(console.memory->read8(0x0300), 1);
+
+  ASSERT_LT(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(debugger.getHit().event, DebugEvent::Read);
+  ASSERT_EQ(debugger.getHit().address, 0x0310);
+  ASSERT_EQ(console.cpu->pc, symbol("step"));
+
+  // reads and writes outside a debugged instruction are not reported
+  console.memory->write8(0x0300, 0xff);
+  debugger.clearWatchpoints();
+  ASSERT_GE(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(debugger.getHits(), 2);
+  ASSERT_EQ(console.memory->read8(0x0300), 5);
+}
+
+// reads of the instruction stream are not data reads
+TEST_F(DebuggerTest, CodeReadsDoNotTriggerWatchpoints) {
+  Debugger debugger(console.memory);
+  auto stx = symbol("loop") + 1;
+  for (auto addr = stx; addr < stx + 3; addr++) {
+    debugger.watch(addr, true, false);
+  }
+  debugger.watch(symbol("step") + 1, true, false);
+  ASSERT_GE(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(debugger.getHits(), 0);
+  ASSERT_EQ(console.cpu->pc, symbol("done"));
+
+  // the same page still reports data reads
+  debugger.watch(0x0310, true, false);
+  debugger.watch(symbol("done"), true, true);
+  console.cpu->pc = symbol("loop");
+  ASSERT_LT(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(debugger.getHit().event, DebugEvent::Read);
+  ASSERT_EQ(debugger.getHit().address, 0x0310);
+}
+
+TEST_F(DebuggerTest, WatchedPagesKeepCopyOnWrite) {
+  console.memory->write8(0x0301, 0x42);
+  Debugger debugger(console.memory);
+  debugger.watch(0x0300, true, true);
+  auto child = console.fork();
+  ASSERT_LT(console.cpu->run(1000, debugger), 1000);
+  ASSERT_EQ(console.memory->read8(0x0300), 1);
+  ASSERT_EQ(console.memory->read8(0x0301), 0x42);
+  ASSERT_EQ(child->memory->read8(0x0300), 0);
+  // the child is not watched
+  Debugger other(child->memory);
+  ASSERT_GE(child->cpu->run(1000, other), 1000);
+  ASSERT_EQ(other.getHits(), 0);
+}
+
+TEST_F(DebuggerTest, StoppedFrameResumes) {
+  Debugger debugger(console.memory);
+  debugger.setBreakpoint(symbol("done"));
+  console.frame(debugger);
+  ASSERT_EQ(console.frames, 0);
+  ASSERT_EQ(console.cpu->pc, symbol("done"));
+  // done jumps to itself, so it would stop again on the next pass
+  debugger.clearBreakpoints();
+  console.frame(debugger);
+  ASSERT_EQ(console.frames, 1);
+  ASSERT_GE(console.cycles, 1000);
+}
@@ -0,0 +1,92 @@
+#include "nes/disassembler.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/assembler.hpp"
+
+using testing::Test;
+
+static string instruction(uint16_t pc, vector<uint8_t> code) {
+  code.resize(3);
+  char text[DISASSEMBLER_TEXT];
+  auto len = Disassembler::instruction(pc, code.data(), text);
+  EXPECT_EQ(len, strlen(text));
+  return text;
+}
+
+TEST(DisassemblerTest, AddressingModes) {
+  ASSERT_EQ(instruction(0, {0xea}), "NOP");
+  ASSERT_EQ(instruction(0, {0x0a}), "ASL A");
+  ASSERT_EQ(instruction(0, {0xa9, 0x0f}), "LDA #$0F");
+  ASSERT_EQ(instruction(0, {0xa5, 0x10}), "LDA $10");
+  ASSERT_EQ(instruction(0, {0xb5, 0x10}), "LDA $10,X");
+  ASSERT_EQ(instruction(0, {0xb6, 0x10}), "LDX $10,Y");
+  ASSERT_EQ(instruction(0, {0xad, 0x34, 0x12}), "LDA $1234");
+  ASSERT_EQ(instruction(0, {0xbd, 0x34, 0x12}), "LDA $1234,X");
+  ASSERT_EQ(instruction(0, {0xb9, 0x34, 0x12}), "LDA $1234,Y");
+  ASSERT_EQ(instruction(0, {0x6c, 0x34, 0x12}), "JMP ($1234)");
+  ASSERT_EQ(instruction(0, {0xa1, 0x10}), "LDA ($10,X)");
+  ASSERT_EQ(instruction(0, {0xb1, 0x10}), "LDA ($10),Y");
+  ASSERT_EQ(instruction(0x0600, {0xd0, 0xfe}), "BNE $0600");
+  ASSERT_EQ(instruction(0x0600, {0x10, 0x10}), "BPL $0612");
+  ASSERT_EQ(instruction(0, {0x02, 0x10}), "XXX");
+}
+
+TEST(DisassemblerTest, Length) {
+  ASSERT_EQ(Disassembler::length(0xea), 1);
+  ASSERT_EQ(Disassembler::length(0xa9), 2);
+  ASSERT_EQ(Disassembler::length(0x4c), 3);
+  // BRK skips a padding byte
+  ASSERT_EQ(Disassembler::length(0x00), 2);
+  ASSERT_EQ(Disassembler::length(0x02), 1);
+}
+
+TEST(DisassemblerTest, Line) {
+  uint8_t code[] = {0x4c, 0xf5, 0xc5};
+  char text[DISASSEMBLER_LINE];
+  Disassembler::line(0xc000, code, text);
+  ASSERT_STREQ(text, "C000  4C F5 C5  JMP $C5F5");
+  code[0] = 0xe8;
+  Disassembler::line(0xc000, code, text);
+  ASSERT_STREQ(text, "C000  E8        INX");
+}
+
+TEST(DisassemblerTest, RoundTripsTheAssembler) {
+  Assembler assembler;
+  ASSERT_TRUE(assembler.assembleFile(SNAKE_ASM)) << assembler.getError();
+  auto& code = assembler.getCode();
+  vector<char> text(code.size() * DISASSEMBLER_LINE + 1);
+  uint32_t written;
+  auto listed = Disassembler::range(assembler.getOrigin(), code.data(),
+                                    code.size(), text.data(), text.size(),
+                                    written);
+  ASSERT_EQ(listed, code.size());
+  ASSERT_EQ(written, strlen(text.data()));
+
+  // every line assembles back to its own bytes
+  string source;
+  std::istringstream lines(string(text.data(), written));
+  for (string line; getline(lines, line);) {
+    source += "  " + line.substr(16) + "\n";
+  }
+  Assembler again;
+  ASSERT_TRUE(again.assemble(source)) << again.getError();
+  ASSERT_EQ(again.getCode(), code);
+}
+
+TEST(DisassemblerTest, RangeStopsAtCapacityAndCutInstructions) {
+  uint8_t code[] = {0xa9, 0x01, 0x8d, 0x00};
+  char text[3 * DISASSEMBLER_LINE + 1];
+  uint32_t written;
+  ASSERT_EQ(Disassembler::range(0x0600, code, sizeof(code), text,
+                                sizeof(text), written),
+            sizeof(code));
+  ASSERT_STREQ(text,
+               "0600  A9 01     LDA #$01\n"
+               "0602  8D        .BYTE $8D\n"
+               "0603  00        .BYTE $00\n");
+  ASSERT_EQ(Disassembler::range(0x0600, code, sizeof(code), text,
+                                DISASSEMBLER_LINE + 1, written),
+            2);
+  ASSERT_STREQ(text, "0600  A9 01     LDA #$01\n");
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+
+#include "nes/cpu.hpp"
+#include "nes/memorybus.hpp"
+
+using std::function;
+using std::make_shared;
+using std::shared_ptr;
+using testing::Test;
+
+// Reference flag computations, updating p eagerly the way the CPU did before
+// flags were evaluated lazily.
+struct EagerFlags {
+  uint8_t p;
+
+  void set(Flags mask, bool on) {
+    if (on) {
+      p |= static_cast<uint8_t>(mask);
+    } else {
+      p &= ~static_cast<uint8_t>(mask);
+    }
+  }
+  void zn(uint8_t value) {
+    set(Flags::Z, value == 0);
+    set(Flags::N, value >= 0x80);
+  }
+  uint8_t adc(uint8_t a, uint8_t value) {
+    uint16_t sum = uint16_t(a) + value + (p & 0x01);
+    set(Flags::C, sum > 0x00ff);
+    uint8_t result = sum & 0x00ff;
+    set(Flags::V, ((result ^ a) & (result ^ value) & 0x80) != 0);
+    zn(result);
+    return result;
+  }
+  void compare(uint8_t r, uint8_t value) {
+    set(Flags::C, r >= value);
+    set(Flags::Z, r == value);
+    set(Flags::N, ((r - value) & 0x80) != 0);
+  }
+};
+
+class FlagsTest : public Test {
+ protected:
+  shared_ptr<Memory> memory;
+  shared_ptr<Bus> bus;
+  shared_ptr<CPU> cpu;
+
+  void SetUp() override {
+    memory = make_shared<Memory>(0x0000, 0xffff);
+    bus = make_shared<MemoryBus>();
+    bus->connect(memory);
+    cpu = make_shared<CPU>(bus);
+  }
+
+  // runs opcode with every accumulator, operand and carry combination and
+  // compares the accumulator and status against the eager reference
+  void differential(uint8_t opcode,
+                    function<uint8_t(EagerFlags&, uint8_t, uint8_t)> eager) {
+    for (uint32_t a = 0; a <= 0xff; a++) {
+      for (uint32_t value = 0; value <= 0xff; value++) {
+        for (uint8_t c = 0; c <= 1; c++) {
+          uint8_t status = (uint8_t(a * 7 + value * 13) & 0xfe) | c | 0x20;
+          auto zp = cpu->opcodes[opcode].resolve == &CPU::zp;
+          uint8_t code[] = {opcode, zp ? uint8_t(0x10) : uint8_t(value)};
+          memory->set(0x0200, code, 2);
+          memory->write8(0x0010, value);
+          cpu->pc = 0x0200;
+          cpu->a = a;
+          cpu->x = a;
+          cpu->y = a;
+          cpu->setStatus(status);
+          cpu->step();
+
+          EagerFlags reference{status};
+          auto result = eager(reference, a, value);
+          ASSERT_EQ(cpu->getStatus(), reference.p)
+              << "opcode " << int(opcode) << " a " << a << " value " << value;
+          ASSERT_EQ(cpu->a, result);
+        }
+      }
+    }
+  }
+};
+
+TEST_F(FlagsTest, AdcImm) {
+  differential(0x69, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    return f.adc(a, value);
+  });
+}
+
+TEST_F(FlagsTest, SbcImm) {
+  differential(0xe9, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    return f.adc(a, ~value);
+  });
+}
+
+TEST_F(FlagsTest, AndImm) {
+  differential(0x29, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(a & value);
+    return a & value;
+  });
+}
+
+TEST_F(FlagsTest, OraImm) {
+  differential(0x09, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(a | value);
+    return a | value;
+  });
+}
+
+TEST_F(FlagsTest, EorImm) {
+  differential(0x49, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(a ^ value);
+    return a ^ value;
+  });
+}
+
+TEST_F(FlagsTest, CmpImm) {
+  differential(0xc9, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.compare(a, value);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, CpxImm) {
+  differential(0xe0, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.compare(a, value);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, CpyImm) {
+  differential(0xc0, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.compare(a, value);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, LdaImm) {
+  differential(0xa9, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(value);
+    return value;
+  });
+}
+
+TEST_F(FlagsTest, BitZp) {
+  differential(0x24, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.set(Flags::Z, (a & value) == 0);
+    f.set(Flags::N, (value & 0x80) != 0);
+    f.set(Flags::V, (value & 0x40) != 0);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, IncZp) {
+  differential(0xe6, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(value + 1);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, DecZp) {
+  differential(0xc6, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(value - 1);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, AslAcc) {
+  differential(0x0a, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.set(Flags::C, (a & 0x80) != 0);
+    uint8_t result = a << 1;
+    f.zn(result);
+    return result;
+  });
+}
+
+TEST_F(FlagsTest, LsrAcc) {
+  differential(0x4a, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.set(Flags::C, (a & 0x01) != 0);
+    uint8_t result = a >> 1;
+    f.zn(result);
+    return result;
+  });
+}
+
+TEST_F(FlagsTest, RolAcc) {
+  differential(0x2a, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    uint8_t c = f.p & 0x01;
+    f.set(Flags::C, (a & 0x80) != 0);
+    uint8_t result = (a << 1) | c;
+    f.zn(result);
+    return result;
+  });
+}
+
+TEST_F(FlagsTest, RorAcc) {
+  differential(0x6a, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    uint8_t c = f.p & 0x01;
+    f.set(Flags::C, (a & 0x01) != 0);
+    uint8_t result = (c << 7) | (a >> 1);
+    f.zn(result);
+    return result;
+  });
+}
+
+TEST_F(FlagsTest, Dex) {
+  differential(0xca, [](EagerFlags& f, uint8_t a, uint8_t value) {
+    f.zn(a - 1);
+    return a;
+  });
+}
+
+TEST_F(FlagsTest, StatusRoundTrip) {
+  for (uint32_t status = 0; status <= 0xff; status++) {
+    cpu->setStatus(status);
+    ASSERT_EQ(cpu->getStatus(), status);
+    ASSERT_EQ(cpu->getFlag(Flags::C), (status & 0x01) != 0);
+    ASSERT_EQ(cpu->getFlag(Flags::Z), (status & 0x02) != 0);
+    ASSERT_EQ(cpu->getFlag(Flags::V), (status & 0x40) != 0);
+    ASSERT_EQ(cpu->getFlag(Flags::N), (status & 0x80) != 0);
+  }
+}
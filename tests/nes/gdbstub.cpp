@@ -0,0 +1,253 @@
+#include "nes/gdbstub.hpp"
+
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "nes/assembler.hpp"
+#include "nes/console.hpp"
+
+using testing::Test;
+
+class GdbStubTest : public Test {
+ protected:
+  Console console;
+  Assembler assembler;
+  shared_ptr<GdbStub> stub;
+  std::atomic<bool> done{false};
+  thread emulation;
+  int client = -1;
+  string received;
+
+  void SetUp() override {
+    // spins until the client writes $0200, wherever it attaches
+    ASSERT_TRUE(assembler.assemble(
+        "wait:\n"
+        "  lda $0200\n"
+        "  beq wait\n"
+        "  ldx #0\n"
+        "loop:\n"
+        "  inx\n"
+        "  stx $0300\n"
+        "step: cpx #5\n"
+        "  bne loop\n"
+        "done: jmp done\n"))
+        << assembler.getError();
+    auto& code = assembler.getCode();
+    console.loadProgram(assembler.getOrigin(), code.data(), code.size());
+    console.reset();
+    stub = std::make_shared<GdbStub>(console.cpu, console.memory);
+  }
+
+  void TearDown() override {
+    if (client >= 0) {
+      close(client);
+    }
+    done = true;
+    stub->close();
+    if (emulation.joinable()) {
+      emulation.join();
+    }
+  }
+
+  void run() {
+    emulation = thread([this] {
+      while (!done && !stub->isKilled()) {
+        console.frame(*stub);
+      }
+    });
+  }
+
+  void connectTcp() {
+    ASSERT_TRUE(stub->listenTcp(0)) << stub->getError();
+    run();
+    client = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(stub->getPort());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(
+        connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)),
+        0);
+  }
+
+  void write(const string& data) {
+    ASSERT_EQ(::send(client, data.data(), data.size(), 0), data.size());
+  }
+
+  void sendPacket(const string& payload) {
+    uint8_t sum = 0;
+    for (auto c : payload) {
+      sum += c;
+    }
+    char checksum[4];
+    snprintf(checksum, sizeof(checksum), "%02x", sum);
+    write("$" + payload + "#" + checksum);
+  }
+
+  // next packet from the stub, skipping acks
+  string reply() {
+    while (true) {
+      auto start = received.find('$');
+      auto end = received.find('#', start);
+      if (start != string::npos && end != string::npos &&
+          end + 2 < received.size()) {
+        auto payload = received.substr(start + 1, end - start - 1);
+        received.erase(0, end + 3);
+        return payload;
+      }
+      char data[256];
+      auto count = recv(client, data, sizeof(data), 0);
+      if (count <= 0) {
+        return "<closed>";
+      }
+      received.append(data, count);
+    }
+  }
+
+  string exchange(const string& payload) {
+    sendPacket(payload);
+    return reply();
+  }
+
+  uint16_t symbol(const string& name) {
+    uint16_t value = 0;
+    EXPECT_TRUE(assembler.getSymbol(name, value));
+    return value;
+  }
+
+  // as a register, little-endian
+  string hex16(uint16_t value) {
+    char text[8];
+    snprintf(text, sizeof(text), "%02x%02x", value & 0xff, value >> 8);
+    return text;
+  }
+
+  // as a packet argument
+  string address(const string& name) {
+    char text[8];
+    snprintf(text, sizeof(text), "%x", symbol(name));
+    return text;
+  }
+};
+
+TEST_F(GdbStubTest, RegistersAndMemory) {
+  connectTcp();
+  ASSERT_EQ(exchange("qSupported:swbreak+"),
+            "PacketSize=1000;QStartNoAckMode+");
+  ASSERT_EQ(exchange("?"), "S05");
+  ASSERT_EQ(exchange("g").size(), 2 * GDB_REGISTER_BYTES);
+  ASSERT_EQ(exchange("m600,3"), "ad0002");
+  ASSERT_EQ(exchange("M300,2:abCD"), "OK");
+  ASSERT_EQ(exchange("m300,2"), "abcd");
+  ASSERT_EQ(console.memory->read8(0x0301), 0xcd);
+  ASSERT_EQ(exchange("P0=42"), "OK");
+  ASSERT_EQ(exchange("p0"), "42");
+  ASSERT_EQ(exchange("P5=3412"), "OK");
+  ASSERT_EQ(exchange("p5"), "3412");
+  ASSERT_EQ(exchange("G01020324ff0006"), "OK");
+  ASSERT_EQ(exchange("g"), "01020324ff0006");
+  ASSERT_EQ(exchange("p9"), "E01");
+  ASSERT_EQ(exchange("m600"), "E01");
+  ASSERT_EQ(exchange("vMustReplyEmpty"), "");
+}
+
+TEST_F(GdbStubTest, BreakpointsAndSteps) {
+  connectTcp();
+  ASSERT_EQ(exchange("QStartNoAckMode"), "OK");
+  ASSERT_EQ(exchange("M200,1:01"), "OK");
+  ASSERT_EQ(exchange("Z0," + address("step") + ",1"), "OK");
+  for (uint32_t x = 1; x <= 3; x++) {
+    ASSERT_EQ(exchange("c"), "S05");
+    ASSERT_EQ(exchange("p5"), hex16(symbol("step")));
+    ASSERT_EQ(exchange("p1"), "0" + std::to_string(x));
+  }
+  ASSERT_EQ(exchange("z0," + address("step") + ",1"), "OK");
+  ASSERT_EQ(exchange("s"), "S05");
+  ASSERT_EQ(exchange("p5"), hex16(symbol("step") + 2));
+  ASSERT_EQ(exchange("s"), "S05");
+  ASSERT_EQ(exchange("p5"), hex16(symbol("loop")));
+  // stepping from an address
+  ASSERT_EQ(exchange("s" + address("done")), "S05");
+  ASSERT_EQ(exchange("p5"), hex16(symbol("done")));
+  ASSERT_EQ(exchange("s" + address("loop")), "S05");
+  ASSERT_EQ(exchange("p5"), hex16(symbol("loop") + 1));
+}
+
+TEST_F(GdbStubTest, Watchpoints) {
+  connectTcp();
+  ASSERT_EQ(exchange("M200,1:01"), "OK");
+  ASSERT_EQ(exchange("Z2,300,1"), "OK");
+  ASSERT_EQ(exchange("c"), "T05watch:0300;");
+  ASSERT_EQ(exchange("p5"), hex16(symbol("step")));
+  ASSERT_EQ(exchange("m300,1"), "01");
+  ASSERT_EQ(exchange("Z3,300,1"), "OK");
+  ASSERT_EQ(exchange("c"), "T05awatch:0300;");
+  ASSERT_EQ(exchange("z2,300,1"), "OK");
+  ASSERT_EQ(exchange("z3,300,1"), "OK");
+  ASSERT_EQ(exchange("Z5,300,1"), "");
+  // lengths past the end of memory or beyond the limit
+  ASSERT_EQ(exchange("Z2,0,ffffffff"), "E01");
+  ASSERT_EQ(exchange("Z2,ffff,2"), "E01");
+  ASSERT_EQ(exchange("Z2,0,101"), "E01");
+  ASSERT_EQ(exchange("Z2,ffff,1"), "OK");
+  ASSERT_EQ(exchange("z2,ffff,1"), "OK");
+}
+
+TEST_F(GdbStubTest, PatchedCodeRunsAfterSession) {
+  // translate the wait loop first, the session then patches it
+  console.cpu->setBackend(Backend::Recompiler);
+  console.frame();
+  ASSERT_EQ(console.memory->read8(0x0300), 0x00);
+  connectTcp();
+  // lda $0200 becomes lda #$01 / nop
+  ASSERT_EQ(exchange("M" + address("wait") + ",3:a901ea"), "OK");
+  sendPacket("k");
+  emulation.join();
+  console.frame();
+  ASSERT_EQ(console.memory->read8(0x0300), 0x05);
+  ASSERT_EQ(console.cpu->pc, symbol("done"));
+}
+
+TEST_F(GdbStubTest, OverlongPacketIsDropped) {
+  connectTcp();
+  // never terminated, so it is dropped once longer than a packet
+  write("$" + string(GDB_PACKET_SIZE + 1, 'm'));
+  ASSERT_EQ(exchange("?"), "S05");
+}
+
+TEST_F(GdbStubTest, InterruptAndDetach) {
+  connectTcp();
+  sendPacket("c");
+  write("\x03");
+  ASSERT_EQ(reply(), "S02");
+  ASSERT_EQ(exchange("p5").size(), 4);
+  ASSERT_EQ(exchange("Z0," + address("loop") + ",1"), "OK");
+  ASSERT_EQ(exchange("D"), "OK");
+  // detaching lets the CPU run and drops the breakpoints
+  auto frames = console.frames;
+  while (console.frames < frames + 2) {
+    std::this_thread::yield();
+  }
+}
+
+TEST_F(GdbStubTest, KillOverUnixSocket) {
+  auto path = testing::TempDir() + "nes-gdbstub.sock";
+  ASSERT_TRUE(stub->listenUnix(path)) << stub->getError();
+  run();
+  client = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path.c_str());
+  ASSERT_EQ(
+      connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)),
+      0);
+  ASSERT_EQ(exchange("?"), "S05");
+  sendPacket("k");
+  emulation.join();
+  ASSERT_TRUE(stub->isKilled());
+  stub->close();
+  ASSERT_NE(access(path.c_str(), F_OK), 0);
+}
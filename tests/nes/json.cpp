@@ -0,0 +1,84 @@
+#include "nes/json.hpp"
+
+#include <gtest/gtest.h>
+
+using std::vector;
+
+TEST(JsonTest, ReadsDocument) {
+  string text =
+      " {\"name\": \"a9 \\\"x\\\"\\u0041\", \"values\": [1, -2.5, 3e2],\n"
+      "  \"nested\": {\"on\": true, \"off\": false, \"none\": null},"
+      "  \"big\": 12345678901234567890}";
+  JsonReader reader(text.data(), text.size());
+  ASSERT_TRUE(reader.beginObject());
+  string key;
+  string name;
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_EQ(key, "name");
+  ASSERT_TRUE(reader.readString(name));
+  ASSERT_EQ(name, "a9 \"x\"A");
+
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_EQ(key, "values");
+  ASSERT_TRUE(reader.beginArray());
+  vector<double> values;
+  double value;
+  while (reader.nextItem()) {
+    ASSERT_TRUE(reader.readNumber(value));
+    values.push_back(value);
+  }
+  ASSERT_EQ(values, (vector<double>{1, -2.5, 300}));
+
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_EQ(key, "nested");
+  ASSERT_TRUE(reader.beginObject());
+  bool on = false;
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_TRUE(reader.readBool(on));
+  ASSERT_TRUE(on);
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_EQ(key, "off");
+  ASSERT_TRUE(reader.skip());
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_TRUE(reader.skip());
+  ASSERT_FALSE(reader.nextKey(key));
+
+  ASSERT_TRUE(reader.nextKey(key));
+  ASSERT_TRUE(reader.readNumber(value));
+  ASSERT_DOUBLE_EQ(value, 12345678901234567890.0);
+  ASSERT_FALSE(reader.nextKey(key));
+  ASSERT_TRUE(reader.atEnd());
+  ASSERT_FALSE(reader.failed());
+}
+
+TEST(JsonTest, SkipsNestedValues) {
+  string text = "[{\"a\": [[1, 2], {\"b\": \"]\"}]}, 7]";
+  JsonReader reader(text.data(), text.size());
+  ASSERT_TRUE(reader.beginArray());
+  ASSERT_TRUE(reader.nextItem());
+  ASSERT_TRUE(reader.skip());
+  ASSERT_TRUE(reader.nextItem());
+  double value;
+  ASSERT_TRUE(reader.readNumber(value));
+  ASSERT_EQ(value, 7);
+  ASSERT_FALSE(reader.nextItem());
+  ASSERT_TRUE(reader.atEnd());
+}
+
+TEST(JsonTest, Errors) {
+  string text = "{\"a\" 1}";
+  JsonReader reader(text.data(), text.size());
+  string key;
+  ASSERT_TRUE(reader.beginObject());
+  ASSERT_FALSE(reader.nextKey(key));
+  ASSERT_TRUE(reader.failed());
+  // sticky: nothing reads after an error
+  ASSERT_FALSE(reader.nextItem());
+  double value;
+  ASSERT_FALSE(reader.readNumber(value));
+
+  string truncated = "[1, \"abc";
+  JsonReader other(truncated.data(), truncated.size());
+  ASSERT_FALSE(other.skip());
+  ASSERT_TRUE(other.failed());
+}
@@ -0,0 +1,137 @@
+#include "nes/lockstep.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/memorybus.hpp"
+
+using std::make_shared;
+using std::mt19937;
+using std::shared_ptr;
+using testing::Test;
+
+// Every lane is checked against its own scalar CPU fed the same RAM.
+class LockstepTest : public Test {
+ protected:
+  static constexpr uint32_t N = 16;
+  Lockstep<N> lockstep;
+  shared_ptr<Memory> memory[N];
+  shared_ptr<CPU> cpu[N];
+
+  void SetUp() override {
+    for (uint32_t l = 0; l < N; l++) {
+      memory[l] = make_shared<Memory>(0x0000, 0xffff);
+      auto bus = make_shared<MemoryBus>();
+      bus->connect(memory[l]);
+      cpu[l] = make_shared<CPU>(bus);
+    }
+  }
+
+  void load(uint32_t lane, const uint8_t* ram) {
+    memcpy(lockstep.getRam(lane), ram, LANE_RAM_SIZE);
+    memory[lane]->set(0x0000, ram, LANE_RAM_SIZE);
+  }
+
+  void expectSameState(uint32_t lane) {
+    SCOPED_TRACE(testing::Message() << "lane " << lane);
+    ASSERT_EQ(lockstep.a[lane], cpu[lane]->a);
+    ASSERT_EQ(lockstep.x[lane], cpu[lane]->x);
+    ASSERT_EQ(lockstep.y[lane], cpu[lane]->y);
+    ASSERT_EQ(lockstep.getStatus(lane), cpu[lane]->getStatus());
+    ASSERT_EQ(lockstep.sp[lane], cpu[lane]->sp);
+    ASSERT_EQ(lockstep.pc[lane], cpu[lane]->pc);
+  }
+
+  void expectSameMemory(uint32_t lane) {
+    static uint8_t ram[LANE_RAM_SIZE];
+    memory[lane]->get(0x0000, ram, LANE_RAM_SIZE);
+    ASSERT_EQ(memcmp(lockstep.getRam(lane), ram, LANE_RAM_SIZE), 0) << lane;
+  }
+};
+
+TEST_F(LockstepTest, EveryOpcodeMatchesInterpreter) {
+  mt19937 random(6502);
+  static uint8_t ram[LANE_RAM_SIZE];
+  for (uint32_t l = 0; l < N; l++) {
+    for (auto& byte : ram) {
+      byte = random();
+    }
+    load(l, ram);
+  }
+
+  for (uint32_t trial = 0; trial < 64; trial++) {
+    for (uint32_t l = 0; l < N; l++) {
+      // lanes diverge: each gets its own opcode, operands, registers and PC
+      uint16_t pc = 0x0200 + random() % 0xfd00;
+      uint8_t code[] = {uint8_t(trial * N + l), uint8_t(random()),
+                        uint8_t(random())};
+      memcpy(lockstep.getRam(l) + pc, code, sizeof(code));
+      memory[l]->set(pc, code, sizeof(code));
+
+      lockstep.a[l] = cpu[l]->a = random();
+      lockstep.x[l] = cpu[l]->x = random();
+      lockstep.y[l] = cpu[l]->y = random();
+      lockstep.sp[l] = cpu[l]->sp = random();
+      lockstep.pc[l] = cpu[l]->pc = pc;
+      uint8_t status = random() | 0x20;
+      lockstep.setStatus(l, status);
+      cpu[l]->setStatus(status);
+      lockstep.cycles[l] = 0;
+      cpu[l]->cycles = 0;
+    }
+
+    lockstep.step();
+    for (uint32_t l = 0; l < N; l++) {
+      cpu[l]->step();
+      SCOPED_TRACE(testing::Message() << "opcode " << (trial * N + l) % 256);
+      expectSameState(l);
+      ASSERT_EQ(lockstep.cycles[l], cpu[l]->cycles) << l;
+      expectSameMemory(l);
+    }
+  }
+}
+
+TEST_F(LockstepTest, ProgramMatchesInterpreter) {
+  // LDA $ff / CLC / ADC $fe / STA $0300,x / INX / JSR $0620 / BCC $0600 /
+  // JMP $0600, subroutine PHA / EOR $0300,y / INY / STA $0400,y / PLA / RTS
+  uint8_t code[] = {0xa5, 0xff, 0x18, 0x65, 0xfe, 0x9d, 0x00, 0x03, 0xe8,
+                    0x20, 0x20, 0x06, 0x90, 0xf2, 0x4c, 0x00, 0x06};
+  uint8_t subroutine[] = {0x48, 0x59, 0x00, 0x03, 0xc8,
+                          0x99, 0x00, 0x04, 0x68, 0x60};
+  static uint8_t ram[LANE_RAM_SIZE];
+  memset(ram, 0, sizeof(ram));
+  memcpy(ram + 0x0600, code, sizeof(code));
+  memcpy(ram + 0x0620, subroutine, sizeof(subroutine));
+  ram[RESET_PROC_ADDR] = 0x00;
+  ram[RESET_PROC_ADDR + 1] = 0x06;
+
+  for (uint32_t l = 0; l < N; l++) {
+    // different inputs so lanes branch apart
+    ram[0xfe] = l * 17;
+    ram[0xff] = l;
+    load(l, ram);
+    cpu[l]->reset();
+  }
+  lockstep.reset();
+
+  for (auto frame = 0; frame < 50; frame++) {
+    lockstep.run(1000);
+    for (uint32_t l = 0; l < N; l++) {
+      ASSERT_EQ(cpu[l]->run(1000), lockstep.cycles[l]) << l;
+      expectSameState(l);
+    }
+  }
+  for (uint32_t l = 0; l < N; l++) {
+    expectSameMemory(l);
+  }
+}
+
+TEST_F(LockstepTest, Load) {
+  Lockstep<8> narrow;
+  uint8_t code[] = {0xa9, 0x42, 0x00};
+  narrow.load(0xfffe, code, sizeof(code));
+  for (uint32_t l = 0; l < narrow.lanes; l++) {
+    ASSERT_EQ(narrow.getRam(l)[0xfffe], 0xa9);
+    ASSERT_EQ(narrow.getRam(l)[0xffff], 0x42);
+    ASSERT_EQ(narrow.getRam(l)[0x0000], 0x00);
+  }
+}
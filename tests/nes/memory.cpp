@@ -127,4 +127,59 @@ TEST_F(MemoryTest, SetArray) {
   ASSERT_EQ(byte12, data[i++]);
   ASSERT_EQ(byte13, data[i++]);
   ASSERT_EQ(byte14, data[i++]);
-}
\ No newline at end of file
+}
+
+TEST_F(MemoryTest, DirtyPages) {
+  // arrange
+  auto since = memory->checkpoint();
+  uint8_t data[] = {0x01, 0x02, 0x03};
+
+  // act
+  memory->write8(0x0240, 0x56);
+  memory->set(0x04ff, data, 3);
+
+  // assert
+  ASSERT_EQ(memory->getPages(), 8);
+  ASSERT_TRUE(memory->dirty(0x02, since));
+  ASSERT_TRUE(memory->dirty(0x04, since));
+  ASSERT_TRUE(memory->dirty(0x05, since));
+#ifdef DIRTY_TRACKING
+  ASSERT_FALSE(memory->dirty(0x00, since));
+  ASSERT_FALSE(memory->dirty(0x03, since));
+  ASSERT_FALSE(memory->dirty(0x06, since));
+
+  auto next = memory->checkpoint();
+  memory->write8(0x0000, 0x01);
+  ASSERT_TRUE(memory->dirty(0x00, next));
+  ASSERT_FALSE(memory->dirty(0x02, next));
+  // an older checkpoint still sees every page written after it
+  ASSERT_TRUE(memory->dirty(0x00, since));
+  ASSERT_TRUE(memory->dirty(0x02, since));
+#endif
+}
+
+TEST_F(MemoryTest, Fork) {
+  // arrange
+  uint8_t data[0x300];
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = i;
+  }
+  memory->set(0x0100, data, sizeof(data));
+
+  // act
+  auto child = memory->fork();
+  child->write8(0x0180, 0xaa);
+  memory->set(0x02ff, data, 2);
+  uint8_t copy[0x300];
+  child->get(0x0100, copy, sizeof(copy));
+
+  // assert
+  ASSERT_EQ(child->getSize(), memory->getSize());
+  ASSERT_EQ(memory->read8(0x0180), 0x80);
+  ASSERT_EQ(child->read8(0x0180), 0xaa);
+  ASSERT_EQ(memory->read8(0x02ff), 0x00);
+  ASSERT_EQ(memory->read8(0x0300), 0x01);
+  ASSERT_EQ(copy[0x1ff], 0xff);
+  ASSERT_EQ(copy[0x200], 0x00);
+  ASSERT_EQ(copy[0x80], 0xaa);
+}
@@ -0,0 +1,87 @@
+#include "nes/movie.hpp"
+
+#include <gtest/gtest.h>
+
+using std::mt19937;
+using testing::Test;
+
+class MovieTest : public Test {
+ protected:
+  // LDA $ff / CLC / ADC $fe / STA $0300,x / INX / JMP $0600
+  uint8_t code[12] = {0xa5, 0xff, 0x18, 0x65, 0xfe, 0x9d,
+                      0x00, 0x03, 0xe8, 0x4c, 0x00, 0x06};
+
+  // drives the console the way a frontend would: the input byte and a
+  // seeded random byte are written before every frame
+  uint64_t replay(const Movie& movie) {
+    Console console;
+    console.loadProgram(0x0600, code, sizeof(code));
+    console.cyclesPerFrame = 1000;
+    console.reset();
+    mt19937 random(movie.seed);
+    for (auto input : movie.inputs) {
+      if (input) {
+        console.memory->write8(0x00ff, input);
+      }
+      console.memory->write8(0x00fe, random());
+      console.frame();
+    }
+    return Movie::hashRam(console);
+  }
+
+  Movie record(uint32_t seed, uint32_t frames) {
+    Movie movie;
+    movie.seed = seed;
+    mt19937 keys(seed * 31);
+    for (uint32_t i = 0; i < frames; i++) {
+      movie.record(keys() % 4 == 0 ? keys() : 0);
+    }
+    movie.hash = replay(movie);
+    return movie;
+  }
+};
+
+TEST_F(MovieTest, Serialize) {
+  auto movie = record(1234, 100);
+  vector<uint8_t> data;
+  movie.serialize(data);
+  ASSERT_EQ(data.size(), MOVIE_HEADER_SIZE + 100);
+  ASSERT_EQ(memcmp(data.data(), "NESM", 4), 0);
+
+  Movie loaded;
+  ASSERT_TRUE(loaded.deserialize(data.data(), data.size()));
+  ASSERT_EQ(loaded.seed, movie.seed);
+  ASSERT_EQ(loaded.hash, movie.hash);
+  ASSERT_EQ(loaded.inputs, movie.inputs);
+
+  ASSERT_FALSE(loaded.deserialize(data.data(), data.size() - 1));
+  data[0] = 'X';
+  ASSERT_FALSE(loaded.deserialize(data.data(), data.size()));
+}
+
+TEST_F(MovieTest, SaveLoad) {
+  auto movie = record(42, 50);
+  auto path = testing::TempDir() + "movie.bin";
+  ASSERT_TRUE(movie.save(path));
+
+  Movie loaded;
+  ASSERT_TRUE(loaded.load(path));
+  ASSERT_EQ(loaded.inputs, movie.inputs);
+  ASSERT_EQ(loaded.hash, movie.hash);
+  ASSERT_FALSE(loaded.load(path + ".missing"));
+  remove(path.c_str());
+}
+
+TEST_F(MovieTest, ReplayIsDeterministic) {
+  auto movie = record(6502, 600);
+  for (auto i = 0; i < 3; i++) {
+    ASSERT_EQ(replay(movie), movie.hash);
+  }
+
+  auto other = movie;
+  other.inputs.back() ^= 0x80;
+  ASSERT_NE(replay(other), movie.hash);
+  other = movie;
+  other.seed++;
+  ASSERT_NE(replay(other), movie.hash);
+}
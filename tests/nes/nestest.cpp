@@ -0,0 +1,158 @@
+#include "nes/goldenlog.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/console.hpp"
+
+using std::ifstream;
+using testing::Test;
+
+static void run(Console& console, GoldenLog& log) {
+  while (!log.done() && !log.failed()) {
+    console.cpu->step(log);
+  }
+}
+
+class NestestTest : public Test {
+ protected:
+  Console console;
+  GoldenLog log;
+
+  // the opening of nestest, with its instruction bytes placed where the
+  // log says they run from in a 16 KB NROM image
+  void SetUp() override {
+    vector<uint8_t> image(INES_HEADER_SIZE + INES_PRG_BANK_SIZE);
+    uint8_t header[] = {'N', 'E', 'S', 0x1a, 0x01, 0x01};
+    memcpy(image.data(), header, sizeof(header));
+    for (auto& text : opening) {
+      GoldenLog::Line line;
+      ASSERT_TRUE(GoldenLog::parse(text, line));
+      memcpy(&image[INES_HEADER_SIZE + (line.pc & 0x3fff)], line.bytes,
+             line.count);
+    }
+    Rom rom(image.data(), image.size());
+    ASSERT_TRUE(console.loadCartridge(rom));
+    GoldenLog::startNestest(*console.cpu);
+  }
+
+  vector<string> opening = {
+      "C000  4C F5 C5  JMP $C5F5                       "
+      "A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7",
+      "C5F5  A2 00     LDX #$00                        "
+      "A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 30 CYC:10",
+      "C5F7  86 00     STX $00 = 00                    "
+      "A:00 X:00 Y:00 P:26 SP:FD PPU:  0, 36 CYC:12",
+      "C5F9  86 10     STX $10 = 00                    "
+      "A:00 X:00 Y:00 P:26 SP:FD PPU:  0, 45 CYC:15",
+      "C5FB  86 11     STX $11 = 00                    "
+      "A:00 X:00 Y:00 P:26 SP:FD PPU:  0, 54 CYC:18",
+      "C5FD  20 2D C7  JSR $C72D                       "
+      "A:00 X:00 Y:00 P:26 SP:FD PPU:  0, 63 CYC:21",
+      "C72D  EA        NOP                             "
+      "A:00 X:00 Y:00 P:26 SP:FB PPU:  0, 81 CYC:27",
+      "C72E  38        SEC                             "
+      "A:00 X:00 Y:00 P:26 SP:FB PPU:  0, 87 CYC:29",
+      "C72F  B0 04     BCS $C735                       "
+      "A:00 X:00 Y:00 P:27 SP:FB PPU:  0, 93 CYC:31",
+  };
+};
+
+TEST_F(NestestTest, Parse) {
+  GoldenLog::Line line;
+  ASSERT_TRUE(GoldenLog::parse(opening[0], line));
+  ASSERT_EQ(line.pc, 0xc000);
+  ASSERT_EQ(line.count, 3);
+  ASSERT_EQ(line.bytes[0], 0x4c);
+  ASSERT_EQ(line.bytes[2], 0xc5);
+  ASSERT_EQ(line.p, 0x24);
+  ASSERT_EQ(line.sp, 0xfd);
+  ASSERT_EQ(line.cycle, 7);
+  ASSERT_FALSE(line.unofficial);
+
+  ASSERT_TRUE(GoldenLog::parse(
+      "C6BD  04 A9    *NOP $A9 = 00                    "
+      "A:AA X:97 Y:4E P:EF SP:F5 PPU: 12,130 CYC:1304",
+      line));
+  ASSERT_EQ(line.count, 2);
+  ASSERT_EQ(line.a, 0xaa);
+  ASSERT_EQ(line.p, 0xef);
+  ASSERT_EQ(line.cycle, 1304);
+  ASSERT_TRUE(line.unofficial);
+
+  ASSERT_FALSE(GoldenLog::parse("C000  4C F5 C5  JMP $C5F5", line));
+  ASSERT_FALSE(GoldenLog::parse("", line));
+}
+
+TEST_F(NestestTest, OpeningMatchesLog) {
+  for (auto& text : opening) {
+    ASSERT_TRUE(log.add(text));
+  }
+  run(console, log);
+  ASSERT_FALSE(log.failed()) << log.getMismatch();
+  ASSERT_EQ(log.getChecked(), opening.size());
+  ASSERT_EQ(log.getCycle(), 34);
+}
+
+TEST_F(NestestTest, ReportsMismatch) {
+  opening[4].replace(opening[4].find("X:00"), 4, "X:01");
+  for (auto& text : opening) {
+    ASSERT_TRUE(log.add(text));
+  }
+  run(console, log);
+  ASSERT_TRUE(log.failed());
+  ASSERT_EQ(log.getChecked(), 5);
+  ASSERT_NE(log.getMismatch().find("instruction 5"), string::npos);
+  ASSERT_NE(log.getMismatch().find("C5FB  86 11  A:00 X:01"), string::npos);
+}
+
+TEST_F(NestestTest, RejectsOtherCartridges) {
+  vector<uint8_t> image(INES_HEADER_SIZE + 3 * INES_PRG_BANK_SIZE);
+  uint8_t header[] = {'N', 'E', 'S', 0x1a, 0x03};
+  memcpy(image.data(), header, sizeof(header));
+  ASSERT_FALSE(console.loadCartridge(Rom(image.data(), image.size())));
+  image[4] = 0x01;
+  image[6] = 0x10;  // mapper 1
+  ASSERT_FALSE(console.loadCartridge(Rom(image.data(), image.size())));
+  image[4] = 0x04;
+  image[6] = 0x00;  // truncated
+  ASSERT_FALSE(console.loadCartridge(Rom(image.data(), image.size())));
+  uint8_t raw[] = {0xa9, 0x00};
+  ASSERT_FALSE(console.loadCartridge(Rom(raw, sizeof(raw))));
+}
+
+TEST_F(NestestTest, RejectsTruncatedImages) {
+  vector<uint8_t> image(100);
+  uint8_t header[] = {'N', 'E', 'S', 0x1a, 0x01, 0x01, 0x04};
+  memcpy(image.data(), header, sizeof(header));
+  Rom shortTrainer(image.data(), image.size());
+  ASSERT_FALSE(shortTrainer.isINes());
+  ASSERT_EQ(shortTrainer.getPrg(), nullptr);
+  ASSERT_EQ(shortTrainer.getPrgSize(), 0);
+  ASSERT_FALSE(console.loadCartridge(shortTrainer));
+
+  image.resize(INES_HEADER_SIZE + INES_TRAINER_SIZE + INES_PRG_BANK_SIZE - 1);
+  ASSERT_FALSE(Rom(image.data(), image.size()).isINes());
+  image.push_back(0xea);
+  Rom trainer(image.data(), image.size());
+  ASSERT_TRUE(trainer.isINes());
+  ASSERT_EQ(trainer.getPrg(),
+            trainer.getData() + INES_HEADER_SIZE + INES_TRAINER_SIZE);
+  ASSERT_EQ(trainer.getPrgSize(), INES_PRG_BANK_SIZE);
+}
+
+// nestest.nes and nestest.log are not redistributed with the sources; drop
+// them into tests/data to run this, it is reported as skipped without them
+TEST_F(NestestTest, FullLog) {
+  string dir = NESTEST_DIR;
+  Rom rom(dir + "/nestest.nes");
+  if (!rom.valid() || !ifstream(dir + "/nestest.log")) {
+    GTEST_SKIP() << "nestest.nes and nestest.log not found in " << dir;
+  }
+  ASSERT_TRUE(log.load(dir + "/nestest.log"));
+  Console full;
+  ASSERT_TRUE(full.loadCartridge(rom));
+  GoldenLog::startNestest(*full.cpu);
+  run(full, log);
+  ASSERT_FALSE(log.failed()) << log.getMismatch();
+  ASSERT_EQ(log.getChecked(), log.getLines());
+}
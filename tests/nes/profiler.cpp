@@ -0,0 +1,91 @@
+#include "nes/profiler.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/console.hpp"
+
+using std::getline;
+using std::istringstream;
+using std::ostringstream;
+using testing::Test;
+
+class ProfilerTest : public Test {
+ protected:
+  Console console;
+  Profiler profiler;
+
+  void SetUp() override {
+    // LDX #$0a / DEX / BNE $0602 / JMP $0605
+    uint8_t code[] = {0xa2, 0x0a, 0xca, 0xd0, 0xfd, 0x4c, 0x05, 0x06};
+    console.loadProgram(0x0600, code, sizeof(code));
+    console.reset();
+    console.cyclesPerFrame = 100;
+  }
+};
+
+TEST_F(ProfilerTest, CountsPerPcAndOpcode) {
+  ASSERT_EQ(console.frame(profiler), 102);
+  ASSERT_EQ(profiler.getCount(0x0600), 1);
+  ASSERT_EQ(profiler.getCycles(0x0600), 2);
+  ASSERT_EQ(profiler.getCount(0x0602), 10);
+  ASSERT_EQ(profiler.getCycles(0x0602), 20);
+  // nine taken branches cost one cycle more than the last one
+  ASSERT_EQ(profiler.getCount(0x0603), 10);
+  ASSERT_EQ(profiler.getCycles(0x0603), 29);
+  ASSERT_EQ(profiler.getCount(0x0605), 17);
+  ASSERT_EQ(profiler.getOpcodeCount(0x4c), 17);
+  ASSERT_EQ(profiler.getOpcodeCycles(0x4c), 51);
+  ASSERT_EQ(profiler.getInstructions(), 38);
+  ASSERT_EQ(profiler.getTotalCycles(), console.cycles);
+
+  profiler.clear();
+  ASSERT_EQ(profiler.getCount(0x0605), 0);
+  ASSERT_EQ(profiler.getInstructions(), 0);
+}
+
+TEST_F(ProfilerTest, MatchesUnprofiledRun) {
+  Console plain;
+  uint8_t code[] = {0xa2, 0x0a, 0xca, 0xd0, 0xfd, 0x4c, 0x05, 0x06};
+  plain.loadProgram(0x0600, code, sizeof(code));
+  plain.reset();
+  plain.cyclesPerFrame = 100;
+  for (auto i = 0; i < 3; i++) {
+    ASSERT_EQ(console.frame(profiler), plain.frame());
+  }
+  ASSERT_EQ(console.stateHash(), plain.stateHash());
+}
+
+TEST_F(ProfilerTest, HotSpots) {
+  console.frame(profiler);
+  auto spots = profiler.hotSpots(3);
+  ASSERT_EQ(spots.size(), 3);
+  ASSERT_EQ(spots[0].pc, 0x0605);
+  ASSERT_EQ(spots[0].opcode, 0x4c);
+  ASSERT_EQ(spots[0].cycles, 51);
+  ASSERT_EQ(spots[1].pc, 0x0603);
+  ASSERT_EQ(spots[2].pc, 0x0602);
+  ASSERT_EQ(profiler.hotSpots(100).size(), 4);
+
+  ostringstream report;
+  profiler.report(report, 2);
+  ASSERT_NE(report.str().find("0605  4c  JMP"), string::npos);
+  ASSERT_EQ(report.str().find("0602"), string::npos);
+}
+
+TEST_F(ProfilerTest, Csv) {
+  console.frame(profiler);
+  ostringstream csv;
+  profiler.writeCsv(csv);
+  istringstream lines(csv.str());
+  string line;
+  vector<string> rows;
+  while (getline(lines, line)) {
+    rows.push_back(line);
+  }
+  ASSERT_EQ(rows.size(), 1 + 4 + 4);
+  ASSERT_EQ(rows[0], "kind,key,mnemonic,count,cycles");
+  ASSERT_EQ(rows[1], "pc,0600,LDX,1,2");
+  ASSERT_EQ(rows[4], "pc,0605,JMP,17,51");
+  ASSERT_EQ(rows[5], "opcode,4c,JMP,17,51");
+  ASSERT_EQ(rows[8], "opcode,d0,BNE,10,29");
+}
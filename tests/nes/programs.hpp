@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+// Test programs shared by several test files.
+
+// counts x down in an inner loop and y up in an outer loop, storing both;
+// the outer loop calls a subroutine and never ends
+#define LOOP_PROGRAM_ADDR 0x0600
+
+static const uint8_t LOOP_PROGRAM[39] = {
+    0xa0, 0x00, 0xa2, 0x10, 0xca, 0x8a, 0x29, 0x0f, 0x99, 0x00,
+    0x03, 0xe0, 0x00, 0xd0, 0xf5, 0xc8, 0x98, 0x18, 0x69, 0x03,
+    0x85, 0x10, 0x20, 0x1e, 0x06, 0x4c, 0x02, 0x06, 0x00, 0x00,
+    0x48, 0xa5, 0x10, 0x49, 0xff, 0x85, 0x11, 0x68, 0x60};
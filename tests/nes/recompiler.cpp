@@ -0,0 +1,262 @@
+#include "nes/recompiler.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/cpu.hpp"
+#include "nes/memorybus.hpp"
+#include "programs.hpp"
+
+using std::make_shared;
+using std::mt19937;
+using std::pair;
+using std::shared_ptr;
+using testing::Test;
+
+// Forwards to a MemoryBus and records every write so that the interpreter and
+// the recompiler can be compared access by access.
+class RecordingBus final : public Bus {
+ public:
+  void connect(shared_ptr<Device> device) override { bus.connect(device); }
+  uint8_t read8(uint16_t addr) override { return bus.read8(addr); }
+  void write8(uint16_t addr, uint8_t value) override {
+    writes.push_back({addr, value});
+    bus.write8(addr, value);
+  }
+  uint16_t read16(uint16_t addr) override { return bus.read16(addr); }
+  void write16(uint16_t addr, uint16_t value) override {
+    writes.push_back({addr, value & 0xff});
+    writes.push_back({uint16_t(addr + 1), value >> 8});
+    bus.write16(addr, value);
+  }
+  void peek(uint16_t addr, uint8_t* data, uint32_t len) override {
+    bus.peek(addr, data, len);
+  }
+  void setCodeWatcher(CodeWatcher watcher) override {
+    bus.setCodeWatcher(watcher);
+  }
+  void watchCode(uint8_t page) override { bus.watchCode(page); }
+
+  MemoryBus bus;
+  vector<pair<uint16_t, uint8_t>> writes;
+};
+
+class RecompilerTest : public Test {
+ protected:
+  shared_ptr<Memory> memory[2];
+  shared_ptr<RecordingBus> bus[2];
+  shared_ptr<CPU> cpu[2];
+
+  void SetUp() override {
+    for (auto i = 0; i < 2; i++) {
+      memory[i] = make_shared<Memory>(0x0000, 0xffff);
+      bus[i] = make_shared<RecordingBus>();
+      bus[i]->connect(memory[i]);
+      cpu[i] = make_shared<CPU>(bus[i]);
+    }
+    cpu[1]->setBackend(Backend::Recompiler);
+  }
+
+  void load(uint16_t addr, const uint8_t* data, uint32_t len) {
+    for (auto i = 0; i < 2; i++) {
+      memory[i]->set(addr, data, len);
+    }
+  }
+
+  // steps the interpreter by whole instructions until it has spent as many
+  // cycles as the recompiler did
+  uint32_t interpret(uint32_t cycles) {
+    uint32_t elapsed = 0;
+    while (elapsed < cycles) {
+      cpu[0]->cycles = 0;
+      cpu[0]->step();
+      elapsed += cpu[0]->cycles;
+    }
+    cpu[0]->cycles = 0;
+    return elapsed;
+  }
+
+  void expectSameState() {
+    auto& interpreter = *cpu[0];
+    auto& recompiler = *cpu[1];
+    ASSERT_EQ(interpreter.a, recompiler.a);
+    ASSERT_EQ(interpreter.x, recompiler.x);
+    ASSERT_EQ(interpreter.y, recompiler.y);
+    ASSERT_EQ(interpreter.getStatus(), recompiler.getStatus());
+    ASSERT_EQ(interpreter.sp, recompiler.sp);
+    ASSERT_EQ(interpreter.pc, recompiler.pc);
+    ASSERT_EQ(interpreter.cycles, recompiler.cycles);
+    ASSERT_EQ(interpreter.addressing, recompiler.addressing);
+    ASSERT_EQ(bus[0]->writes, bus[1]->writes);
+  }
+
+  void expectSameMemory() {
+    for (uint32_t addr = 0; addr <= 0xffff; addr++) {
+      ASSERT_EQ(memory[0]->read8(addr), memory[1]->read8(addr)) << addr;
+    }
+  }
+};
+
+TEST_F(RecompilerTest, Available) {
+  ASSERT_EQ(cpu[1]->getBackend(), Backend::Recompiler);
+}
+
+TEST_F(RecompilerTest, EveryOpcodeMatchesInterpreter) {
+  mt19937 random(6502);
+  uint8_t ram[0x10000];
+
+  for (uint32_t opcode = 0; opcode <= 0xff; opcode++) {
+    for (auto& byte : ram) {
+      byte = random();
+    }
+    for (auto trial = 0; trial < 16; trial++) {
+      uint16_t pc = 0x0200 + random() % 0xfd00;
+      ram[pc] = opcode;
+      ram[pc + 1] = random();
+      ram[pc + 2] = random();
+      load(0x0000, ram, sizeof(ram));
+      for (auto i = 0; i < 2; i++) {
+        cpu[i]->a = ram[0];
+        cpu[i]->x = ram[1];
+        cpu[i]->y = ram[2];
+        cpu[i]->setStatus(ram[3] | 0x20);
+        cpu[i]->sp = ram[4];
+        cpu[i]->pc = pc;
+        cpu[i]->cycles = 0;
+        bus[i]->writes.clear();
+        cpu[i]->step();
+      }
+      cpu[1]->recompiler->flush();
+
+      SCOPED_TRACE(testing::Message() << "opcode " << opcode);
+      expectSameState();
+    }
+  }
+}
+
+// Straight-line blocks of random instructions with every opcode somewhere in
+// them, run through run() so flags and cycles carry between the translated
+// instructions; control flow and undecoded opcodes can only end a block.
+TEST_F(RecompilerTest, EveryOpcodeInBlocksMatchesInterpreter) {
+  mt19937 random(6510);
+  uint8_t ram[0x10000];
+  auto table = CPU::opcodeTable();
+  auto ends = [&](uint32_t opcode) {
+    auto& info = table[opcode];
+    return info.bytes == 0 ||
+           CPU::getAddressing(info) == Addressing::Rel ||
+           strcmp(info.mnemonic, "JMP") == 0 ||
+           strcmp(info.mnemonic, "JSR") == 0 ||
+           strcmp(info.mnemonic, "RTS") == 0 ||
+           strcmp(info.mnemonic, "RTI") == 0 ||
+           strcmp(info.mnemonic, "BRK") == 0;
+  };
+  vector<uint8_t> fillers;
+  for (uint32_t opcode = 0; opcode <= 0xff; opcode++) {
+    if (!ends(opcode)) {
+      fillers.push_back(opcode);
+    }
+  }
+
+  for (uint32_t opcode = 0; opcode <= 0xff; opcode++) {
+    for (auto trial = 0; trial < 8; trial++) {
+      for (auto& byte : ram) {
+        byte = random();
+      }
+      uint16_t pc = 0x0200 + random() % 0xf000;
+      uint32_t length = 2 + random() % 7;
+      auto slot = ends(opcode) ? length - 1 : random() % length;
+      uint16_t at = pc;
+      for (uint32_t i = 0; i < length; i++) {
+        auto next = i == slot ? opcode : fillers[random() % fillers.size()];
+        ram[at] = next;
+        ram[uint16_t(at + 1)] = random();
+        ram[uint16_t(at + 2)] = random();
+        at += std::max<uint32_t>(table[next].bytes, 1);
+      }
+      // JMP back to the start closes blocks that do not end on their own
+      ram[at] = 0x4c;
+      ram[uint16_t(at + 1)] = pc & 0xff;
+      ram[uint16_t(at + 2)] = pc >> 8;
+      load(0x0000, ram, sizeof(ram));
+      for (auto i = 0; i < 2; i++) {
+        cpu[i]->a = ram[0];
+        cpu[i]->x = ram[1];
+        cpu[i]->y = ram[2];
+        cpu[i]->setStatus(ram[3] | 0x20);
+        cpu[i]->sp = ram[4];
+        cpu[i]->pc = pc;
+        cpu[i]->cycles = 0;
+        bus[i]->writes.clear();
+      }
+      auto elapsed = cpu[1]->run(1);
+      ASSERT_EQ(interpret(elapsed), elapsed);
+      cpu[1]->recompiler->flush();
+
+      SCOPED_TRACE(testing::Message() << "opcode " << opcode << " trial "
+                                      << trial);
+      expectSameState();
+    }
+  }
+}
+
+TEST_F(RecompilerTest, ProgramMatchesInterpreter) {
+  load(LOOP_PROGRAM_ADDR, LOOP_PROGRAM, sizeof(LOOP_PROGRAM));
+  for (auto i = 0; i < 2; i++) {
+    memory[i]->write16(RESET_PROC_ADDR, LOOP_PROGRAM_ADDR);
+    cpu[i]->reset();
+  }
+
+  for (auto frame = 0; frame < 100; frame++) {
+    auto elapsed = cpu[1]->run(1000);
+    ASSERT_EQ(interpret(elapsed), elapsed);
+    expectSameState();
+  }
+  expectSameMemory();
+}
+
+TEST_F(RecompilerTest, SelfModifyingCode) {
+  // LDA #$00 / INC $0601 / TAX / JMP $0600
+  uint8_t code[] = {0xa9, 0x00, 0xee, 0x01, 0x06, 0xaa, 0x4c, 0x00, 0x06};
+  load(0x0600, code, sizeof(code));
+  for (auto i = 0; i < 2; i++) {
+    cpu[i]->pc = 0x0600;
+  }
+
+  for (auto iteration = 0; iteration < 20; iteration++) {
+    auto elapsed = cpu[1]->run(1);
+    ASSERT_EQ(interpret(elapsed), elapsed);
+    expectSameState();
+  }
+  ASSERT_NE(cpu[1]->x, 0x00);
+  expectSameMemory();
+}
+
+TEST_F(RecompilerTest, WritesFromOutsideReplaceTranslatedCode) {
+  // LDA #$01 / TAX / JMP $0600
+  uint8_t loop[] = {0xa9, 0x01, 0xaa, 0x4c, 0x00, 0x06};
+  // LDA #$04 / STA $0601 / JMP $0600
+  uint8_t patch[] = {0xa9, 0x04, 0x8d, 0x01, 0x06, 0x4c, 0x00, 0x06};
+  load(0x0600, loop, sizeof(loop));
+  load(0x0700, patch, sizeof(patch));
+  auto& jit = *cpu[1];
+  jit.pc = 0x0600;
+  jit.run(20);
+  ASSERT_EQ(jit.x, 0x01);
+
+  memory[1]->write8(0x0601, 0x02);
+  jit.run(20);
+  ASSERT_EQ(jit.x, 0x02);
+
+  uint8_t three = 0x03;
+  memory[1]->set(0x0601, &three, 1);
+  jit.run(20);
+  ASSERT_EQ(jit.x, 0x03);
+
+  // interpreted with hooks, so the store is not made by translated code
+  NoHooks hooks;
+  jit.pc = 0x0700;
+  jit.run(9, hooks);
+  ASSERT_EQ(jit.pc, 0x0600);
+  jit.run(20);
+  ASSERT_EQ(jit.x, 0x04);
+}
@@ -0,0 +1,150 @@
+#include "nes/rewind.hpp"
+
+#include <gtest/gtest.h>
+
+#include "programs.hpp"
+
+using std::mt19937;
+using testing::Test;
+
+class RewindTest : public Test {
+ protected:
+  Console console;
+
+  void SetUp() override {
+    console.loadProgram(LOOP_PROGRAM_ADDR, LOOP_PROGRAM, sizeof(LOOP_PROGRAM));
+    console.reset();
+  }
+
+  // runs frames capturing each one, returning the states captured
+  vector<vector<uint8_t>> play(Rewind& rewind, uint32_t frames) {
+    vector<vector<uint8_t>> states;
+    for (uint32_t i = 0; i < frames; i++) {
+      console.frame();
+      // scribble over a few bytes so deltas are not all alike
+      console.memory->write8(0x2000 + (i * 37) % 0x1000, i);
+      rewind.capture();
+      states.emplace_back();
+      console.saveState(states.back());
+    }
+    return states;
+  }
+
+  // makes the newest stored delta claim more changed bytes than it holds
+  void corruptNewest(Rewind& rewind) {
+    auto& slot = rewind.slots[(rewind.first + rewind.count - 1) %
+                              rewind.slots.size()];
+    rewind.ring[slot.offset + 2] = 0xff;
+    rewind.ring[slot.offset + 3] = 0xff;
+  }
+};
+
+TEST_F(RewindTest, EncodeDecode) {
+  mt19937 random(6502);
+  for (auto density : {0, 1, 10, 100, 256}) {
+    vector<uint8_t> delta(0x11000);
+    for (auto& byte : delta) {
+      byte = int(random() % 256) < density ? random() : 0;
+    }
+    vector<uint8_t> encoded(2 * delta.size() + 16);
+    auto length = Rewind::encode(delta.data(), delta.size(), encoded.data());
+    ASSERT_LE(length, encoded.size());
+
+    vector<uint8_t> state(delta.size(), 0x5a);
+    ASSERT_TRUE(
+        Rewind::decode(encoded.data(), length, state.data(), state.size()));
+    for (uint32_t i = 0; i < delta.size(); i++) {
+      ASSERT_EQ(state[i], delta[i] ^ 0x5a) << i;
+    }
+  }
+}
+
+TEST_F(RewindTest, DecodeRejectsTruncated) {
+  vector<uint8_t> delta(0x100, 0);
+  delta[0x80] = 1;
+  uint8_t encoded[0x300];
+  auto length = Rewind::encode(delta.data(), delta.size(), encoded);
+  ASSERT_FALSE(Rewind::decode(encoded, length - 1, delta.data(), delta.size()));
+}
+
+TEST_F(RewindTest, WalksBack) {
+  Rewind rewind(console, 1, 0x100000);
+  auto states = play(rewind, 30);
+  ASSERT_EQ(rewind.snapshots(), 30);
+  // a frame of this program touches a handful of bytes out of 64 KB
+  ASSERT_LT(rewind.used(), 30 * 0x800);
+
+  for (auto i = states.size(); i-- > 0;) {
+    ASSERT_TRUE(rewind.rewind());
+    vector<uint8_t> state;
+    console.saveState(state);
+    ASSERT_EQ(state, states[i]) << i;
+  }
+  ASSERT_FALSE(rewind.rewind());
+  ASSERT_EQ(rewind.used(), 0);
+}
+
+TEST_F(RewindTest, ContinuesAfterRewind) {
+  Rewind rewind(console, 1, 0x100000);
+  auto states = play(rewind, 10);
+  for (auto i = 0; i < 4; i++) {
+    ASSERT_TRUE(rewind.rewind());
+  }
+  auto more = play(rewind, 5);
+  states.resize(6);
+  states.insert(states.end(), more.begin(), more.end());
+  ASSERT_EQ(rewind.snapshots(), states.size());
+
+  for (auto i = states.size(); i-- > 0;) {
+    ASSERT_TRUE(rewind.rewind());
+    vector<uint8_t> state;
+    console.saveState(state);
+    ASSERT_EQ(state, states[i]) << i;
+  }
+}
+
+TEST_F(RewindTest, CorruptDeltaLeavesConsole) {
+  Rewind rewind(console, 1, 0x100000);
+  play(rewind, 5);
+  corruptNewest(rewind);
+  console.frame();
+  vector<uint8_t> before;
+  console.saveState(before);
+
+  ASSERT_FALSE(rewind.rewind());
+  vector<uint8_t> after;
+  console.saveState(after);
+  ASSERT_EQ(after, before);
+  ASSERT_EQ(rewind.snapshots(), 5);
+  ASSERT_FALSE(rewind.rewind());
+}
+
+TEST_F(RewindTest, DropsOldest) {
+  Rewind rewind(console, 1, 0x400);
+  auto states = play(rewind, 200);
+  ASSERT_LE(rewind.used(), rewind.capacity());
+  ASSERT_GT(rewind.snapshots(), 1);
+  ASSERT_LT(rewind.snapshots(), states.size());
+
+  auto kept = rewind.snapshots();
+  for (uint32_t i = 0; i < kept; i++) {
+    ASSERT_TRUE(rewind.rewind());
+    vector<uint8_t> state;
+    console.saveState(state);
+    ASSERT_EQ(state, states[states.size() - 1 - i]) << i;
+  }
+  ASSERT_FALSE(rewind.rewind());
+}
+
+TEST_F(RewindTest, Interval) {
+  Rewind rewind(console, 6, 0x100000);
+  for (auto i = 0; i < 60; i++) {
+    console.frame();
+    rewind.frame();
+  }
+  ASSERT_EQ(rewind.snapshots(), 10);
+  auto perMinute = rewind.bytesPerMinute();
+  ASSERT_GT(perMinute, 0);
+  ASSERT_LT(perMinute, uint64_t(600) * console.stateSize());
+  RecordProperty("bytesPerMinute", std::to_string(perMinute));
+}
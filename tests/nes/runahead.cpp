@@ -0,0 +1,72 @@
+#include "nes/runahead.hpp"
+
+#include <gtest/gtest.h>
+
+#include "programs.hpp"
+
+using testing::Test;
+
+class RunAheadTest : public Test {
+ protected:
+  Console console;
+  Console reference;
+
+  void SetUp() override {
+    for (auto target : {&console, &reference}) {
+      target->loadProgram(LOOP_PROGRAM_ADDR, LOOP_PROGRAM,
+                          sizeof(LOOP_PROGRAM));
+      target->reset();
+    }
+  }
+
+  void presentsFutureFrame(RunAhead& runAhead) {
+    reference.frame();
+    reference.frame();
+    vector<uint8_t> expected;
+    vector<uint8_t> actual;
+
+    for (auto i = 0; i < 20; i++) {
+      auto& presented = runAhead.frame();
+      reference.frame();
+      ASSERT_EQ(&presented, &runAhead.ahead);
+      ASSERT_EQ(console.frames, i + 1);
+      ASSERT_EQ(presented.frames, i + 3);
+      presented.saveState(actual);
+      reference.saveState(expected);
+      ASSERT_EQ(actual, expected) << i;
+    }
+  }
+};
+
+TEST_F(RunAheadTest, Disabled) {
+  RunAhead runAhead(console, 0);
+  ASSERT_EQ(&runAhead.frame(), &console);
+  ASSERT_EQ(runAhead.costPerFrame(), 0.0);
+}
+
+TEST_F(RunAheadTest, PresentsFutureFrame) {
+  RunAhead runAhead(console, 2);
+  presentsFutureFrame(runAhead);
+  ASSERT_GT(runAhead.costPerFrame(), 0.0);
+  RecordProperty("microsecondsPerFrame",
+                 std::to_string(runAhead.costPerFrame()));
+}
+
+// the ahead console keeps its translations across the state loads
+TEST_F(RunAheadTest, RecompilerPresentsFutureFrame) {
+  console.cpu->setBackend(Backend::Recompiler);
+  reference.cpu->setBackend(Backend::Recompiler);
+  RunAhead runAhead(console, 2);
+  ASSERT_EQ(runAhead.ahead.cpu->getBackend(), Backend::Recompiler);
+  presentsFutureFrame(runAhead);
+}
+
+TEST_F(RunAheadTest, CarriesInput) {
+  RunAhead runAhead(console, 3);
+  for (auto i = 0; i < 10; i++) {
+    console.memory->write8(0x00ff, i);
+    auto& presented = runAhead.frame();
+    ASSERT_EQ(presented.memory->read8(0x00ff), i);
+    ASSERT_EQ(console.frames, i + 1);
+  }
+}
@@ -0,0 +1,115 @@
+#include "nes/singlestep.hpp"
+
+#include <gtest/gtest.h>
+
+using std::make_unique;
+using testing::Test;
+using testing::TestWithParam;
+using testing::Values;
+
+// LDA #$41, STA $10,X with X pointing at $15, and an ADC whose expected
+// result is deliberately wrong
+static const char* VECTORS = R"([
+  {
+    "name": "a9 41 33",
+    "initial": {"pc": 512, "s": 253, "a": 0, "x": 0, "y": 0, "p": 36,
+                "ram": [[512, 169], [513, 65], [514, 51]]},
+    "final": {"pc": 514, "s": 253, "a": 65, "x": 0, "y": 0, "p": 36,
+              "ram": [[512, 169], [513, 65], [514, 51]]},
+    "cycles": [[512, 169, "read"], [513, 65, "read"]]
+  },
+  {
+    "name": "95 10 00",
+    "initial": {"pc": 768, "s": 253, "a": 127, "x": 5, "y": 0, "p": 36,
+                "ram": [[768, 149], [769, 16], [21, 0]]},
+    "final": {"pc": 770, "s": 253, "a": 127, "x": 5, "y": 0, "p": 36,
+              "ram": [[768, 149], [769, 16], [21, 127]]},
+    "cycles": [[768, 149, "read"], [769, 16, "read"], [16, 0, "read"],
+               [21, 127, "write"]]
+  },
+  {
+    "name": "69 01 00",
+    "initial": {"pc": 1024, "s": 253, "a": 1, "x": 0, "y": 0, "p": 36,
+                "ram": [[1024, 105], [1025, 1]]},
+    "final": {"pc": 1026, "s": 253, "a": 3, "x": 0, "y": 0, "p": 36,
+              "ram": [[1024, 105], [1025, 1]]},
+    "cycles": [[1024, 105, "read"], [1025, 1, "read"]]
+  }
+])";
+
+using Cores = SingleStep::Factory;
+
+static const Cores interpreter = [] {
+  return make_unique<CpuCore>(Backend::Interpreter);
+};
+static const Cores recompiler = [] {
+  return make_unique<CpuCore>(Backend::Recompiler);
+};
+static const Cores lockstep = [] { return make_unique<LockstepCore>(); };
+
+class SingleStepTest : public TestWithParam<Cores> {
+ protected:
+  vector<StepVector> vectors;
+
+  void SetUp() override {
+    ASSERT_TRUE(SingleStep::parse(VECTORS, strlen(VECTORS), vectors));
+  }
+};
+
+TEST_F(SingleStepTest, Parse) {
+  ASSERT_EQ(vectors.size(), 3);
+  auto& store = vectors[1];
+  ASSERT_EQ(store.name, "95 10 00");
+  ASSERT_EQ(store.initial.pc, 768);
+  ASSERT_EQ(store.initial.a, 127);
+  ASSERT_EQ(store.initial.x, 5);
+  ASSERT_EQ(store.initial.p, 36);
+  ASSERT_EQ(store.initial.ram.size(), 3);
+  ASSERT_EQ(store.final.ram[2].first, 21);
+  ASSERT_EQ(store.final.ram[2].second, 127);
+  ASSERT_EQ(store.cycles.size(), 4);
+  ASSERT_TRUE(store.cycles[3].write);
+  ASSERT_FALSE(store.cycles[2].write);
+
+  vector<StepVector> broken;
+  ASSERT_FALSE(SingleStep::parse(VECTORS, strlen(VECTORS) - 3, broken));
+}
+
+TEST_P(SingleStepTest, Check) {
+  auto core = GetParam()();
+  string report;
+  ASSERT_TRUE(SingleStep::check(*core, vectors[0], report)) << report;
+  ASSERT_TRUE(SingleStep::check(*core, vectors[1], report)) << report;
+  ASSERT_FALSE(SingleStep::check(*core, vectors[2], report));
+  ASSERT_EQ(report,
+            "69 01 00\n"
+            "  expected pc:0402 s:fd a:03 x:00 y:00 p:24 cycles:2 "
+            "[0400]=69 [0401]=01\n"
+            "  actual   pc:0402 s:fd a:02 x:00 y:00 p:24 cycles:2 "
+            "[0400]=69 [0401]=01");
+}
+
+TEST_P(SingleStepTest, RunFiles) {
+  // the same file many times over so every worker gets some
+  auto path = testing::TempDir() + "singlestep.json";
+  FILE* file = fopen(path.c_str(), "wb");
+  fputs(VECTORS, file);
+  fclose(file);
+  vector<string> paths(16, path);
+  paths.push_back(path + ".missing");
+
+  SingleStep harness(GetParam(), 4);
+  auto results = harness.run(paths);
+  remove(path.c_str());
+  ASSERT_EQ(results.size(), paths.size());
+  for (uint32_t i = 0; i < 16; i++) {
+    ASSERT_EQ(results[i].vectors, 3);
+    ASSERT_EQ(results[i].failures, 1);
+    ASSERT_EQ(results[i].report.substr(0, 8), "69 01 00");
+  }
+  ASSERT_EQ(results.back().vectors, 0);
+  ASSERT_EQ(results.back().failures, 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Cores, SingleStepTest,
+                         Values(interpreter, recompiler, lockstep));
@@ -0,0 +1,119 @@
+#include "nes/tracer.hpp"
+
+#include <gtest/gtest.h>
+
+#include "nes/console.hpp"
+
+using testing::Test;
+
+class TracerTest : public Test {
+ protected:
+  Console console;
+  string path = testing::TempDir() + "trace.bin";
+
+  void SetUp() override {
+    // LDX #$0a / DEX / BNE $0602 / STA $0300,Y / JMP ($060b), $0605
+    uint8_t code[] = {0xa2, 0x0a, 0xca, 0xd0, 0xfd, 0x99, 0x00,
+                      0x03, 0x6c, 0x0b, 0x06, 0x05, 0x06};
+    console.loadProgram(0x0600, code, sizeof(code));
+    console.reset();
+    console.cyclesPerFrame = 100;
+  }
+
+  void TearDown() override { remove(path.c_str()); }
+};
+
+TEST_F(TracerTest, RecordsEveryInstruction) {
+  {
+    // a tiny buffer so the trace is flushed several times on the way
+    Tracer tracer(path, 7, 4);
+    ASSERT_TRUE(tracer.valid());
+    console.frame(tracer);
+    ASSERT_EQ(tracer.getRecords(), 1 + 2 * 10 + 2 * 5);
+  }
+
+  TraceReader reader(path);
+  ASSERT_TRUE(reader.valid());
+  TraceRecord record;
+  ASSERT_TRUE(reader.next(record));
+  ASSERT_EQ(record.getPc(), 0x0600);
+  ASSERT_EQ(record.opcode, 0xa2);
+  ASSERT_EQ(record.operands[0], 0x0a);
+  ASSERT_EQ(record.operands[1], 0x00);
+  ASSERT_EQ(record.getCycle(), 7);
+
+  // registers are the ones before the instruction runs
+  ASSERT_TRUE(reader.next(record));
+  ASSERT_EQ(record.getPc(), 0x0602);
+  ASSERT_EQ(record.x, 0x0a);
+  ASSERT_EQ(record.getCycle(), 9);
+
+  uint32_t count = 2;
+  uint64_t cycle = 0;
+  while (reader.next(record)) {
+    ASSERT_GT(record.getCycle(), cycle);
+    cycle = record.getCycle();
+    count++;
+  }
+  ASSERT_EQ(count, 31);
+  ASSERT_EQ(record.getPc(), 0x0608);
+}
+
+// operands come from a peek, the program sees only the CPU's own reads
+TEST_F(TracerTest, AddsNoReads) {
+  auto plain = console.fork();
+  uint32_t reads[2] = {};
+  Console* consoles[2] = {plain.get(), &console};
+  for (auto i = 0; i < 2; i++) {
+    auto& memory = *consoles[i]->memory;
+    memory.setWatcher([&reads, i](uint16_t addr, uint8_t value, bool write) {
+      reads[i]++;
+    });
+    for (uint16_t addr = 0x0600; addr < 0x060d; addr++) {
+      memory.watch(addr, true, false);
+    }
+  }
+  plain->frame();
+  Tracer tracer(path);
+  console.frame(tracer);
+  ASSERT_GT(reads[0], 0);
+  ASSERT_EQ(reads[1], reads[0]);
+}
+
+TEST_F(TracerTest, Render) {
+  {
+    Tracer tracer(path, 7);
+    console.frame(tracer);
+  }
+  TraceReader reader(path);
+  TraceRecord record;
+  vector<string> lines;
+  while (reader.next(record)) {
+    lines.push_back(TraceReader::render(record));
+  }
+  ASSERT_EQ(lines[0],
+            "0600  A2 0A     LDX #$0A                        "
+            "A:00 X:00 Y:00 P:20 SP:FD CYC:7");
+  ASSERT_EQ(lines[2],
+            "0603  D0 FD     BNE $0602                       "
+            "A:00 X:09 Y:00 P:20 SP:FD CYC:11");
+  ASSERT_EQ(lines[21],
+            "0605  99 00 03  STA $0300,Y                     "
+            "A:00 X:00 Y:00 P:22 SP:FD CYC:58");
+  ASSERT_EQ(lines[22],
+            "0608  6C 0B 06  JMP ($060B)                     "
+            "A:00 X:00 Y:00 P:22 SP:FD CYC:63");
+  ASSERT_EQ(lines[2].find("A:"), 48);
+}
+
+TEST_F(TracerTest, RejectsOtherFiles) {
+  FILE* file = fopen(path.c_str(), "wb");
+  fputs("not a trace", file);
+  fclose(file);
+  TraceReader reader(path);
+  ASSERT_FALSE(reader.valid());
+  TraceRecord record;
+  ASSERT_FALSE(reader.next(record));
+  TraceReader missing(path + ".missing");
+  ASSERT_FALSE(missing.valid());
+}